@@ -5,13 +5,27 @@ solution "3D_Pong"
 
    flags { "Unicode" , "NoPCH"}
 
+   -- the game rules, built into every project rather than being a project of their own
+   commonDir = "src/common"
+
+   -- projects that never open a window, so don't link SDL or OpenGL
+   headlessProjects = { PongServer = true, PongLoadGen = true, PongBench = true, PongTournament = true }
+
+   -- controller plugins (src/common/PongPlugin.h): shared libraries that only see the C header
+   pluginProjects = { PongExamplePlugin = true }
+
    srcDirs = os.matchdirs("src/*")
 
    for i, projectName in ipairs(srcDirs) do
+     if path.getname(projectName) ~= path.getname(commonDir) then
 
        -- A project defines one build target
        project (path.getname(projectName))
-          kind "ConsoleApp"
+          if pluginProjects[path.getname(projectName)] then
+             kind "SharedLib"
+          else
+             kind "ConsoleApp"
+          end
           location (projectName)
           language "C++"
           targetdir ( projectName )
@@ -25,6 +39,9 @@ solution "3D_Pong"
           configuration {}
 
           files { path.join(projectName, "**.h"), path.join(projectName, "**.cpp") } -- build all .h and .cpp files recursively
+          if not pluginProjects[path.getname(projectName)] then
+             files { path.join(commonDir, "**.h"), path.join(commonDir, "**.cpp") }
+          end
           excludes { "./graphics_dependencies/**" }  -- don't build files in graphics_dependencies/
 
 
@@ -36,6 +53,9 @@ solution "3D_Pong"
                         "./graphics_dependencies/glew/include",
                         "./graphics_dependencies/glm",
                         "./graphics_dependencies/SDL2_image/include",
+                        "./graphics_dependencies/SDL2_ttf/include",
+                        "./graphics_dependencies/SDL2/include/SDL2", -- SDL_ttf.h includes "SDL.h"
+                        "./graphics_dependencies/assimp/include",
 
                       }
           configuration { "linux" }
@@ -43,16 +63,25 @@ solution "3D_Pong"
                    -- should be installed as in ./graphics_dependencies/README.asciidoc
                       }
           configuration {}
+          includedirs { commonDir }
           -- end::headers[]
 
 
           -- what libraries need linking to
           -- tag::libraries[]
-          configuration "windows"
-             links { "SDL2", "SDL2main", "opengl32", "glew32", "SDL2_image" }
-          configuration "linux"
-             links { "SDL2", "SDL2main", "GL", "GLEW", "SDL2_image" }
-          configuration {}
+          if pluginProjects[path.getname(projectName)] then
+             -- nothing to link
+          elseif headlessProjects[path.getname(projectName)] then
+             configuration "linux"
+                links { "pthread", "dl" }
+             configuration {}
+          else
+             configuration "windows"
+                links { "SDL2", "SDL2main", "opengl32", "glew32", "SDL2_image", "SDL2_ttf", "assimp-vc130-mtd" }
+             configuration "linux"
+                links { "SDL2", "SDL2main", "GL", "GLEW", "SDL2_image", "SDL2_ttf", "assimp", "pthread", "dl" } -- pthread and dl for WorkerPool and Controller in src/common
+             configuration {}
+          end
           -- end::libraries[]
 
           -- where are libraries?
@@ -62,6 +91,8 @@ solution "3D_Pong"
                     "./graphics_dependencies/glew/lib/Release/Win32",
                     "./graphics_dependencies/SDL2/lib/win32",
                     "./graphics_dependencies/SDL2_image/lib/x86/",
+                    "./graphics_dependencies/SDL2_ttf/lib/x86/",
+                    "./graphics_dependencies/assimp/lib",
                   }
           configuration "linux"
                    -- should be installed as in ./graphics_dependencies/README.asciidoc
@@ -93,6 +124,9 @@ solution "3D_Pong"
              os.copyfile("./graphics_dependencies/SDL2_image/lib/x86/libtiff-5.dll", path.join(projectName, "libtiff-5.dll"))
              os.copyfile("./graphics_dependencies/SDL2_image/lib/x86/libwebp-4.dll", path.join(projectName, "libwebp-4.dll"))
              os.copyfile("./graphics_dependencies/SDL2_image/lib/x86/zlib1.dll", path.join(projectName, "zlib1.dll"))
+             os.copyfile("./graphics_dependencies/SDL2_ttf/lib/x86/SDL2_ttf.dll", path.join(projectName, "SDL2_ttf.dll"))
+             os.copyfile("./graphics_dependencies/SDL2_ttf/lib/x86/libfreetype-6.dll", path.join(projectName, "libfreetype-6.dll"))
           end
           -- end::windowsDLLCopy[]
+     end
    end
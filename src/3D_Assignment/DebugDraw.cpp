@@ -0,0 +1,84 @@
+#include "DebugDraw.h"
+
+#include <cstddef>
+
+void DebugDraw::initialise(StreamBuffer &streamBuffer, GLint positionLocation, GLint vertexColorLocation)
+{
+	// as with the text, the attributes start at the beginning of the stream buffer and each draw
+	// starts at its own first vertex
+	stream = &streamBuffer;
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, stream->buffer());
+	glEnableVertexAttribArray(positionLocation);
+	glEnableVertexAttribArray(vertexColorLocation);
+	glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, position));
+	glVertexAttribPointer(vertexColorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, color));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DebugDraw::destroy()
+{
+	glDeleteVertexArrays(1, &vertexArray);
+	vertexArray = 0;
+}
+
+// tag::debugLines[]
+void DebugDraw::line(const glm::vec3 &from, const glm::vec3 &to, const glm::vec4 &color)
+{
+	Vertex a = { { from.x, from.y, from.z }, { color.r, color.g, color.b, color.a } };
+	Vertex b = { { to.x, to.y, to.z }, { color.r, color.g, color.b, color.a } };
+	vertices.push_back(a);
+	vertices.push_back(b);
+}
+
+void DebugDraw::polyline(const glm::vec3 *points, int count, const glm::vec4 &color)
+{
+	for (int i = 1; i < count; i++)
+		line(points[i - 1], points[i], color);
+}
+
+void DebugDraw::box(const glm::vec3 &centre, const glm::vec3 &halfSize, const glm::vec4 &color)
+{
+	glm::vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+		corners[i] = centre + halfSize * glm::vec3(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1);
+
+	// corners differing in one bit share an edge
+	for (int i = 0; i < 8; i++)
+		for (int bit = 1; bit < 8; bit <<= 1)
+			if (!(i & bit))
+				line(corners[i], corners[i | bit], color);
+}
+// end::debugLines[]
+
+// tag::drawDebugLines[]
+void DebugDraw::draw()
+{
+	drawnLines = (int)vertices.size() / 2;
+	drawnFirst = -1;
+	if (vertices.empty() || !stream)
+	{
+		vertices.clear();
+		return;
+	}
+
+	GLintptr offset = stream->upload(&vertices[0], vertices.size() * sizeof(Vertex), sizeof(Vertex));
+	if (offset >= 0)
+	{
+		drawnFirst = (GLint)(offset / sizeof(Vertex));
+		redraw();
+	}
+	vertices.clear();
+}
+
+void DebugDraw::redraw()
+{
+	if (drawnFirst < 0)
+		return;
+	glBindVertexArray(vertexArray);
+	glDrawArrays(GL_LINES, drawnFirst, drawnLines * 2);
+	glBindVertexArray(0);
+}
+// end::drawDebugLines[]
@@ -0,0 +1,57 @@
+#pragma once
+
+// Immediate-mode debug lines: call line() or box() from anywhere during a frame, then draw()
+// once. Every line of the frame is written into the StreamBuffer as one block and drawn with a
+// single glDrawArrays(GL_LINES), so leaving it on costs one upload and one draw call however
+// much is drawn - cheap enough to keep on while profiling.
+//
+// Vertices have the same layout as the static geometry (position, then RGBA colour), so lines
+// are drawn with the game's own program and whatever view and projection are already set.
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#define GLM_FORCE_RADIANS // suppress a warning in GLM 0.9.5
+#include <glm/glm.hpp>
+
+#include "StreamBuffer.h"
+
+// tag::DebugDraw[]
+class DebugDraw
+{
+public:
+	// positionLocation and vertexColorLocation are the program's attribute locations
+	void initialise(StreamBuffer &stream, GLint positionLocation, GLint vertexColorLocation);
+	void destroy();
+
+	void line(const glm::vec3 &from, const glm::vec3 &to, const glm::vec4 &color);
+	void polyline(const glm::vec3 *points, int count, const glm::vec4 &color);
+	// the 12 edges of an axis aligned box
+	void box(const glm::vec3 &centre, const glm::vec3 &halfSize, const glm::vec4 &color);
+
+	// draw everything queued since the last draw with the program in use, and start an empty batch
+	void draw();
+
+	// draw the last batch again, e.g. into another viewport, without uploading it again - only
+	// within the frame it was drawn in, while the stream buffer still holds it
+	void redraw();
+
+	// lines in the last draw
+	int lastDrawLines() const { return drawnLines; }
+
+private:
+	struct Vertex
+	{
+		GLfloat position[3];
+		GLfloat color[4];
+	};
+
+	std::vector<Vertex> vertices;
+	int drawnLines = 0;
+	GLint drawnFirst = -1; // where the last batch is in the stream buffer, -1 if it wasn't uploaded
+
+	StreamBuffer *stream = nullptr;
+	GLuint vertexArray = 0;
+};
+// end::DebugDraw[]
@@ -0,0 +1,83 @@
+#include "GpuTimer.h"
+
+void GpuTimer::initialise(int frames)
+{
+	slots.resize(frames);
+}
+
+void GpuTimer::destroy()
+{
+	for (Slot &slot : slots)
+		if (!slot.queries.empty())
+			glDeleteQueries((GLsizei)slot.queries.size(), &slot.queries[0]);
+	*this = GpuTimer();
+}
+
+// tag::beginGpuTimer[]
+void GpuTimer::begin()
+{
+	Slot &slot = slots[next];
+	if (slot.pending)
+	{
+		// still unread a whole ring later - give that frame up rather than wait for it
+		slot.pending = false;
+		slot.used = 0;
+		droppedCount++;
+		oldest = (next + 1) % slots.size();
+	}
+	if (slot.used == slot.queries.size())
+	{
+		slot.queries.resize(slot.used + 2);
+		glGenQueries(2, &slot.queries[slot.used]);
+	}
+	glQueryCounter(slot.queries[slot.used++], GL_TIMESTAMP);
+}
+
+void GpuTimer::end()
+{
+	Slot &slot = slots[next];
+	glQueryCounter(slot.queries[slot.used++], GL_TIMESTAMP);
+}
+
+void GpuTimer::endFrame()
+{
+	Slot &slot = slots[next];
+	if (slot.used == 0)
+		return;
+	slot.pending = true;
+	next = (next + 1) % slots.size();
+}
+// end::beginGpuTimer[]
+
+// tag::pollGpuTimer[]
+int GpuTimer::poll(double &milliseconds)
+{
+	// queries finish in the order they were issued, so a frame is done once its last query is,
+	// and the first frame that isn't is as far as there's anything to read
+	int frames = 0;
+	milliseconds = 0;
+	while (!slots.empty() && slots[oldest].pending)
+	{
+		Slot &slot = slots[oldest];
+		GLint available = 0;
+		glGetQueryObjectiv(slot.queries[slot.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 total = 0;
+		for (size_t span = 0; span < slot.used; span += 2)
+		{
+			GLuint64 start, end;
+			glGetQueryObjectui64v(slot.queries[span], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(slot.queries[span + 1], GL_QUERY_RESULT, &end);
+			total += end - start;
+		}
+		milliseconds += total / 1e6;
+		frames++;
+		slot.pending = false;
+		slot.used = 0;
+		oldest = (oldest + 1) % slots.size();
+	}
+	return frames;
+}
+// end::pollGpuTimer[]
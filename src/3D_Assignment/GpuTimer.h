@@ -0,0 +1,57 @@
+#pragma once
+
+// How long the GPU takes over one kind of work each frame, measured with timer queries
+// (ARB_timer_query, core since GL 3.3) without ever waiting for them.
+//
+// A query's result is only there once the GPU has got that far, a frame or more after the CPU
+// issued it, and asking for it sooner stalls until it is. So each frame's queries go in their own
+// slot of a ring a few frames deep, and poll() only reads slots whose results are already
+// available - a few frames late, but for free. If the GPU falls so far behind that a slot comes
+// round again still unread, that frame isn't timed rather than waited for; dropped() counts
+// those.
+//
+// Spans are pairs of GL_TIMESTAMP counters rather than GL_TIME_ELAPSED queries, so timers can
+// overlap and nest - the ball's inside the scene's - and a frame can have any number of spans
+// (the ball in each view, say), which add up to the frame's time.
+
+#include <vector>
+
+#include <GL/glew.h>
+
+// tag::GpuTimer[]
+class GpuTimer
+{
+public:
+	static bool supported() { return GLEW_VERSION_3_3 || GLEW_ARB_timer_query; }
+
+	// a ring deep enough for frames frames in flight
+	void initialise(int frames = 4);
+	void destroy();
+
+	// around the commands to time, as often as they come up in a frame
+	void begin();
+	void end();
+
+	// after the frame's last span; a frame with none isn't timed
+	void endFrame();
+
+	// how many frames have finished since the last poll, without waiting, with milliseconds the
+	// sum of their times
+	int poll(double &milliseconds);
+
+	int dropped() const { return droppedCount; }
+
+private:
+	struct Slot
+	{
+		std::vector<GLuint> queries; // the start and end of each span, grown as frames need more
+		size_t used = 0;             // queries issued into this frame
+		bool pending = false;        // the frame's ended, but it hasn't been read back yet
+	};
+
+	std::vector<Slot> slots;
+	int next = 0;                    // the slot this frame's spans go in
+	int oldest = 0;                  // the slot poll() looks at first
+	int droppedCount = 0;
+};
+// end::GpuTimer[]
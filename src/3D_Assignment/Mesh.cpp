@@ -0,0 +1,359 @@
+#include "Mesh.h"
+
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "StateHash.h"
+
+static const char MESH_CACHE_MAGIC[8] = { 'P', 'O', 'N', 'G', 'M', 'S', 'H', '3' };
+
+// magic, source stamp, vertex count, index count, texture name length, level of detail count
+const size_t MESH_CACHE_HEADER_SIZE = sizeof(MESH_CACHE_MAGIC) + 8 + 4 + 4 + 4 + 4;
+
+// first index, index count, error - for each level of detail, after the header
+const size_t MESH_CACHE_LOD_SIZE = 4 + 4 + 4;
+
+// bumped whenever importing or optimizing changes, so every cache is rebuilt
+const uint64_t MESH_PIPELINE_VERSION = 3;
+
+// tag::importMesh[]
+bool importMesh(const std::string &path, MeshData &mesh, std::string &error)
+{
+	Assimp::Importer importer;
+	const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices |
+	                                               aiProcess_PreTransformVertices | aiProcess_SortByPType | aiProcess_FlipUVs);
+	if (!scene)
+	{
+		error = "could not import " + path + ": " + importer.GetErrorString();
+		return false;
+	}
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+	mesh.texture.clear();
+	for (unsigned m = 0; m < scene->mNumMeshes; m++)
+	{
+		const aiMesh *part = scene->mMeshes[m];
+		if (!(part->mPrimitiveTypes & aiPrimitiveType_TRIANGLE))
+			continue; // points and lines, sorted into meshes of their own
+
+		size_t first = mesh.vertices.size();
+		if (first + part->mNumVertices > 65536)
+		{
+			error = path + " has too many vertices for 16-bit indices";
+			return false;
+		}
+
+		aiColor4D materialColor(1, 1, 1, 1);
+		const aiMaterial *material = scene->mMaterials[part->mMaterialIndex];
+		material->Get(AI_MATKEY_COLOR_DIFFUSE, materialColor);
+		float opacity = 1;
+		if (material->Get(AI_MATKEY_OPACITY, opacity) == AI_SUCCESS)
+			materialColor.a = opacity;
+
+		// one texture for the whole model, so it stays one draw
+		aiString texture;
+		if (material->GetTexture(aiTextureType_DIFFUSE, 0, &texture) == AI_SUCCESS)
+		{
+			if (!mesh.texture.empty() && mesh.texture != texture.C_Str())
+			{
+				error = path + " uses more than one texture";
+				return false;
+			}
+			mesh.texture = texture.C_Str();
+		}
+
+		for (unsigned v = 0; v < part->mNumVertices; v++)
+		{
+			const aiVector3D &position = part->mVertices[v];
+			const aiColor4D &color = part->HasVertexColors(0) ? part->mColors[0][v] : materialColor;
+			aiVector3D texCoord = part->HasTextureCoords(0) ? part->mTextureCoords[0][v] : aiVector3D();
+			MeshVertex vertex = { { position.x, position.y, position.z }, { color.r, color.g, color.b, color.a },
+			                      { texCoord.x, texCoord.y } };
+			mesh.vertices.push_back(vertex);
+		}
+		for (unsigned f = 0; f < part->mNumFaces; f++)
+			for (unsigned i = 0; i < 3; i++)
+				mesh.indices.push_back((uint16_t)(first + part->mFaces[f].mIndices[i]));
+	}
+
+	if (mesh.indices.empty())
+	{
+		error = path + " has no triangles";
+		return false;
+	}
+	return true;
+}
+// end::importMesh[]
+
+// tag::optimizeVertexFetch[]
+void optimizeVertexFetch(MeshData &mesh)
+{
+	// wider than the indices, so a vertex can be remapped to 0xffff - a mesh can have 65536 of them
+	const uint32_t UNUSED = 0xffffffff;
+	std::vector<uint32_t> newIndex(mesh.vertices.size(), UNUSED);
+	std::vector<MeshVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (uint16_t &index : mesh.indices)
+	{
+		if (newIndex[index] == UNUSED)
+		{
+			newIndex[index] = (uint32_t)vertices.size();
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = (uint16_t)newIndex[index];
+	}
+	mesh.vertices.swap(vertices); // vertices no triangle uses are dropped
+}
+// end::optimizeVertexFetch[]
+
+// the model and its material library
+static uint64_t sourceStamp(const std::string &path)
+{
+	std::string materials = path.substr(0, path.rfind('.')) + ".mtl";
+	uint64_t stamps[2] = { fileStamp(path), fileStamp(materials) };
+	// a layout or pipeline change is a different stamp
+	return hashBytes(stamps, sizeof(stamps), sizeof(MeshVertex) | MESH_PIPELINE_VERSION << 32);
+}
+
+static std::string serializeMesh(const MeshData &mesh, uint64_t stamp)
+{
+	uint32_t vertexCount = (uint32_t)mesh.vertices.size(), indexCount = (uint32_t)mesh.indices.size();
+	uint32_t textureLength = (uint32_t)mesh.texture.size(), lodCount = (uint32_t)mesh.lods.size();
+	std::string bytes(MESH_CACHE_HEADER_SIZE + lodCount * MESH_CACHE_LOD_SIZE, 0);
+	memcpy(&bytes[0], MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	memcpy(&bytes[sizeof(MESH_CACHE_MAGIC)], &stamp, 8);
+	memcpy(&bytes[sizeof(MESH_CACHE_MAGIC) + 8], &vertexCount, 4);
+	memcpy(&bytes[sizeof(MESH_CACHE_MAGIC) + 12], &indexCount, 4);
+	memcpy(&bytes[sizeof(MESH_CACHE_MAGIC) + 16], &textureLength, 4);
+	memcpy(&bytes[sizeof(MESH_CACHE_MAGIC) + 20], &lodCount, 4);
+	for (uint32_t lod = 0; lod < lodCount; lod++)
+	{
+		char *entry = &bytes[MESH_CACHE_HEADER_SIZE + lod * MESH_CACHE_LOD_SIZE];
+		memcpy(entry, &mesh.lods[lod].firstIndex, 4);
+		memcpy(entry + 4, &mesh.lods[lod].indexCount, 4);
+		memcpy(entry + 8, &mesh.lods[lod].error, 4);
+	}
+	bytes.append((const char *)&mesh.vertices[0], vertexCount * sizeof(MeshVertex));
+	bytes.append((const char *)&mesh.indices[0], indexCount * sizeof(uint16_t));
+	bytes.append(mesh.texture);
+	return bytes;
+}
+
+// reads the header of a mesh cache, and checks the rest is the size it says
+static bool parseMeshCache(const AssetView &cache, uint64_t &stamp, uint32_t &vertexCount, uint32_t &indexCount,
+                           uint32_t &textureLength, uint32_t &lodCount)
+{
+	if (cache.size < MESH_CACHE_HEADER_SIZE || memcmp(cache.data, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0)
+		return false;
+	memcpy(&stamp, cache.data + sizeof(MESH_CACHE_MAGIC), 8);
+	memcpy(&vertexCount, cache.data + sizeof(MESH_CACHE_MAGIC) + 8, 4);
+	memcpy(&indexCount, cache.data + sizeof(MESH_CACHE_MAGIC) + 12, 4);
+	memcpy(&textureLength, cache.data + sizeof(MESH_CACHE_MAGIC) + 16, 4);
+	memcpy(&lodCount, cache.data + sizeof(MESH_CACHE_MAGIC) + 20, 4);
+	return indexCount > 0 && lodCount > 0 &&
+	       cache.size == MESH_CACHE_HEADER_SIZE + lodCount * MESH_CACHE_LOD_SIZE + vertexCount * sizeof(MeshVertex) +
+	                     indexCount * sizeof(uint16_t) + textureLength;
+}
+
+std::string meshCacheTexture(const AssetView &cache)
+{
+	uint64_t stamp;
+	uint32_t vertexCount, indexCount, textureLength, lodCount;
+	if (!parseMeshCache(cache, stamp, vertexCount, indexCount, textureLength, lodCount))
+		return "";
+	return std::string((const char *)cache.data + cache.size - textureLength, textureLength);
+}
+
+// tag::buildMeshCache[]
+bool buildMeshCache(const std::string &path, std::string &bytes, std::string &error, MeshReport *report)
+{
+	MeshData mesh;
+	if (!importMesh(path, mesh, error))
+		return false;
+
+	VertexCacheStats imported = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+	// every level of detail is optimized on its own, then they share one index buffer
+	const float *positions = mesh.vertices[0].position;
+	std::vector<float> errors;
+	std::vector<std::vector<uint16_t>> levels = simplifyLods(mesh.indices, positions, mesh.vertices.size(), sizeof(MeshVertex),
+	                                                         MAX_MESH_LODS, MAX_MESH_LOD_ERROR, errors);
+	float radius = meshRadius(positions, mesh.vertices.size(), sizeof(MeshVertex));
+
+	mesh.indices.clear();
+	mesh.lods.clear();
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		optimizeVertexCache(levels[level], mesh.vertices.size());
+		optimizeOverdraw(levels[level], positions, mesh.vertices.size(), sizeof(MeshVertex));
+		MeshLod lod = { (uint32_t)mesh.indices.size(), (uint32_t)levels[level].size(), errors[level] * radius };
+		mesh.lods.push_back(lod);
+		mesh.indices.insert(mesh.indices.end(), levels[level].begin(), levels[level].end());
+	}
+	optimizeVertexFetch(mesh); // full detail first, so its vertices come first
+
+	if (report)
+	{
+		std::vector<uint16_t> full(mesh.indices.begin(), mesh.indices.begin() + mesh.lods[0].indexCount);
+		report->triangles = (int)mesh.lods[0].indexCount / 3;
+		report->vertices = (int)mesh.vertices.size();
+		report->lodTriangles.clear();
+		for (const MeshLod &lod : mesh.lods)
+			report->lodTriangles.push_back((int)lod.indexCount / 3);
+		report->imported = imported;
+		report->optimized = analyzeVertexCache(full, mesh.vertices.size());
+	}
+
+	bytes = serializeMesh(mesh, sourceStamp(path));
+	return true;
+}
+// end::buildMeshCache[]
+
+// tag::uploadMesh[]
+static void uploadMesh(const void *vertices, uint32_t vertexCount, const void *indices, uint32_t indexCount,
+                       GLint positionLocation, GLint vertexColorLocation, GLint texCoordLocation, Mesh &mesh)
+{
+	glGenVertexArrays(1, &mesh.vertexArray);
+	glBindVertexArray(mesh.vertexArray);
+
+	glGenBuffers(1, &mesh.vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(MeshVertex), vertices, GL_STATIC_DRAW);
+
+	// the element buffer binding is part of the VAO
+	glGenBuffers(1, &mesh.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint16_t), indices, GL_STATIC_DRAW);
+	mesh.indexCount = indexCount;
+
+	glEnableVertexAttribArray(positionLocation);
+	glEnableVertexAttribArray(vertexColorLocation);
+	glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid *)offsetof(MeshVertex, position));
+	glVertexAttribPointer(vertexColorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid *)offsetof(MeshVertex, color));
+	if (texCoordLocation != -1)
+	{
+		glEnableVertexAttribArray(texCoordLocation);
+		glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid *)offsetof(MeshVertex, texCoord));
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+// end::uploadMesh[]
+
+bool uploadMeshCache(const AssetView &cache, GLint positionLocation, GLint vertexColorLocation, GLint texCoordLocation,
+                     Mesh &mesh)
+{
+	uint64_t stamp;
+	uint32_t vertexCount, indexCount, textureLength, lodCount;
+	if (!parseMeshCache(cache, stamp, vertexCount, indexCount, textureLength, lodCount))
+		return false;
+	mesh.lods.resize(lodCount);
+	for (uint32_t lod = 0; lod < lodCount; lod++)
+	{
+		const uint8_t *entry = cache.data + MESH_CACHE_HEADER_SIZE + lod * MESH_CACHE_LOD_SIZE;
+		memcpy(&mesh.lods[lod].firstIndex, entry, 4);
+		memcpy(&mesh.lods[lod].indexCount, entry + 4, 4);
+		memcpy(&mesh.lods[lod].error, entry + 8, 4);
+		if (mesh.lods[lod].firstIndex + (uint64_t)mesh.lods[lod].indexCount > indexCount)
+			return false;
+	}
+	const uint8_t *vertices = cache.data + MESH_CACHE_HEADER_SIZE + lodCount * MESH_CACHE_LOD_SIZE;
+	uploadMesh(vertices, vertexCount, vertices + vertexCount * sizeof(MeshVertex), indexCount, positionLocation,
+	           vertexColorLocation, texCoordLocation, mesh);
+	mesh.texture = meshCacheTexture(cache);
+
+	// the vertices may not be aligned in a mapped file or pack, so copied out one at a time
+	mesh.translucent = false;
+	float radiusSquared = 0;
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		GLfloat position[3], alpha;
+		memcpy(position, vertices + vertex * sizeof(MeshVertex) + offsetof(MeshVertex, position), sizeof(position));
+		memcpy(&alpha, vertices + vertex * sizeof(MeshVertex) + offsetof(MeshVertex, color) + 3 * sizeof(GLfloat), sizeof(alpha));
+		mesh.translucent = mesh.translucent || alpha < 1;
+		radiusSquared = std::max(radiusSquared, position[0] * position[0] + position[1] * position[1] + position[2] * position[2]);
+	}
+	mesh.radius = std::sqrt(radiusSquared);
+	return true;
+}
+
+// tag::loadMesh[]
+bool loadMesh(const std::string &path, const std::string &cacheDirectory, GLint positionLocation, GLint vertexColorLocation,
+              GLint texCoordLocation, Mesh &mesh, bool &fromCache, std::string &error, MeshReport *report)
+{
+	size_t nameStart = path.find_last_of("/\\") + 1; // 0 if there's no directory
+	std::string cachePath = cacheDirectory + path.substr(nameStart, path.rfind('.') - nameStart) + ".mesh";
+	uint64_t stamp = sourceStamp(path);
+
+	MappedFile cacheFile;
+	if (!cacheDirectory.empty() && cacheFile.open(cachePath))
+	{
+		AssetView cache;
+		cache.data = cacheFile.data();
+		cache.size = cacheFile.size();
+		uint64_t cacheStamp;
+		uint32_t vertexCount, indexCount, textureLength, lodCount;
+		if (parseMeshCache(cache, cacheStamp, vertexCount, indexCount, textureLength, lodCount) && cacheStamp == stamp &&
+		    uploadMeshCache(cache, positionLocation, vertexColorLocation, texCoordLocation, mesh))
+		{
+			fromCache = true;
+			return true;
+		}
+	}
+	cacheFile.close();
+
+	std::string bytes;
+	if (!buildMeshCache(path, bytes, error, report))
+		return false;
+	if (!cacheDirectory.empty())
+	{
+		std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), bytes.size());
+	}
+
+	AssetView cache;
+	cache.data = (const uint8_t *)bytes.data();
+	cache.size = bytes.size();
+	uploadMeshCache(cache, positionLocation, vertexColorLocation, texCoordLocation, mesh);
+	fromCache = false;
+	return true;
+}
+// end::loadMesh[]
+
+int Mesh::selectLod(float pixelsPerUnit, float maxPixelError) const
+{
+	int lod = 0;
+	while (lod + 1 < (int)lods.size() && lods[lod + 1].error * pixelsPerUnit <= maxPixelError)
+		lod++;
+	return lod;
+}
+
+void Mesh::draw(int lod) const
+{
+	glBindVertexArray(vertexArray);
+	if (lods.empty())
+		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
+	else
+		glDrawElements(GL_TRIANGLES, lods[lod].indexCount, GL_UNSIGNED_SHORT,
+		               (GLvoid *)(lods[lod].firstIndex * sizeof(uint16_t)));
+}
+
+void Mesh::destroy()
+{
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	*this = Mesh();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+// The world's models. A model file (anything assimp reads - the game's own are .obj) is imported
+// once, flattened into a single indexed triangle list in the static geometry's vertex layout,
+// simplified into levels of detail (MeshSimplifier.h), optimized for the vertex cache, overdraw
+// and vertex fetch (MeshOptimizer.h), and written to a binary cache that is exactly what the GPU
+// buffers hold: a short header, a table of the levels of detail, the vertices, then 16-bit
+// indices (followed by the name of the model's texture, if it has one). Every level of detail
+// draws a range of the one index buffer over the one vertex buffer. Later launches map the cache
+// file and hand the mapped bytes straight to glBufferData, so assimp only runs after a model
+// changes.
+//
+// The cache is little-endian, the byte order of every machine this builds for. It is matched to
+// its model by the size and modification time of the model file and of its material library
+// (the same name with .mtl), not by reading them, so checking it costs two stat() calls.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "AssetPack.h"
+#include "MeshOptimizer.h"
+
+// tag::MeshData[]
+// the layout of the static geometry: position, RGBA colour, then texture coordinates
+struct MeshVertex
+{
+	GLfloat position[3];
+	GLfloat color[4];
+	GLfloat texCoord[2];
+};
+
+// a range of the index buffer drawing the whole model with fewer triangles
+struct MeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error; // how far, in the model's units, its surface can be from the full-detail one
+};
+
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint16_t> indices; // triangles
+	std::string texture; // the diffuse texture, relative to the model's directory; empty if none
+	std::vector<MeshLod> lods; // full detail first; empty until the cache is built
+};
+// end::MeshData[]
+
+// every triangle in the model at path, in the model's space, with identical vertices shared, in
+// the order the file has them; colours come from the vertex colours if there
+// are any, otherwise the material's diffuse colour and opacity, to be multiplied by the diffuse
+// texture. Fails if the model needs more vertices than 16-bit indices can reach, or uses more
+// than one texture
+bool importMesh(const std::string &path, MeshData &mesh, std::string &error);
+
+// renumber the vertices in the order the triangles first use them, so vertex fetches walk
+// forward through memory
+void optimizeVertexFetch(MeshData &mesh);
+
+// what optimizing a model did to its triangle order
+struct MeshReport
+{
+	int triangles;
+	int vertices;
+	std::vector<int> lodTriangles; // in each level of detail, full detail first
+	VertexCacheStats imported;  // in the file's order
+	VertexCacheStats optimized;
+};
+
+// the most levels of detail a model gets - each about half the triangles of the one before - and
+// the furthest, relative to its size, any of them may be from the full-detail surface
+const int MAX_MESH_LODS = 4;
+const float MAX_MESH_LOD_ERROR = 0.05f;
+
+// what the cache of the model at path holds: imported, simplified, optimized and serialized;
+// fills in report if it isn't null
+bool buildMeshCache(const std::string &path, std::string &bytes, std::string &error, MeshReport *report = nullptr);
+
+// tag::Mesh[]
+// a mesh in GPU buffers, with a VAO for the game's program
+struct Mesh
+{
+	GLuint vertexArray = 0;
+	GLuint vertexBuffer = 0;
+	GLuint indexBuffer = 0;
+	GLsizei indexCount = 0; // in every level of detail
+	std::string texture; // as in MeshData
+	std::vector<MeshLod> lods;
+	bool translucent = false; // some vertex colour's alpha is under 1, so it's drawn in the transparent pass
+	float radius = 0; // of a sphere round the model's origin holding every vertex, for culling
+
+	// the level of detail with the fewest triangles whose error, at pixelsPerUnit (how many pixels
+	// across one of the model's units is drawn), is at most maxPixelError pixels
+	int selectLod(float pixelsPerUnit, float maxPixelError) const;
+
+	void draw(int lod = 0) const;
+	void destroy();
+};
+// end::Mesh[]
+
+// a mesh cache's bytes (from a cache file or an asset pack) straight into GPU buffers; false if
+// they aren't a mesh cache. texCoordLocation may be -1, for a program that doesn't use them
+bool uploadMeshCache(const AssetView &cache, GLint positionLocation, GLint vertexColorLocation, GLint texCoordLocation,
+                     Mesh &mesh);
+
+// the texture named in a mesh cache, or "" if it has none or isn't a mesh cache
+std::string meshCacheTexture(const AssetView &cache);
+
+// the model at path in GPU buffers - from its cache in cacheDirectory (which ends in a path
+// separator) if that's up to date, otherwise imported and cached for next time. fromCache says
+// which happened, and report (if it isn't null) is filled in when it's imported; returns false
+// and sets error if the model can't be imported
+bool loadMesh(const std::string &path, const std::string &cacheDirectory, GLint positionLocation, GLint vertexColorLocation,
+              GLint texCoordLocation, Mesh &mesh, bool &fromCache, std::string &error, MeshReport *report = nullptr);
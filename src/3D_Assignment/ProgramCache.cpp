@@ -0,0 +1,119 @@
+#include "ProgramCache.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "MappedFile.h"
+#include "StateHash.h"
+
+static const char PROGRAM_CACHE_MAGIC[8] = { 'P', 'O', 'N', 'G', 'P', 'R', 'G', '1' };
+
+// magic, key, binary format, binary length
+const size_t PROGRAM_CACHE_HEADER_SIZE = sizeof(PROGRAM_CACHE_MAGIC) + 8 + 4 + 4;
+
+static std::string glString(GLenum name)
+{
+	const GLubyte *value = glGetString(name);
+	return value ? (const char *)value : "";
+}
+
+void ProgramCache::initialise(const std::string &cacheDirectory)
+{
+	directory = cacheDirectory;
+	driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+
+	// GL 4.1 or ARB_get_program_binary, and at least one format - some drivers expose the
+	// functions but can't actually save anything
+	GLint formats = 0;
+	if (GLEW_ARB_get_program_binary)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	available = !directory.empty() && formats > 0;
+}
+
+// tag::programCacheKey[]
+uint64_t ProgramCache::key(const std::vector<ShaderSource> &sources) const
+{
+	// chained, so the same sources in a different order or a different stage are a different key
+	uint64_t hash = hashBytes(driver.data(), driver.size());
+	for (const ShaderSource &shader : sources)
+	{
+		hash = hashBytes(&shader.type, sizeof(shader.type), hash);
+		hash = hashBytes(shader.source, shader.length, hash);
+	}
+	return hash;
+}
+// end::programCacheKey[]
+
+// tag::loadProgramBinary[]
+GLuint ProgramCache::load(const std::string &name, uint64_t expectedKey)
+{
+	if (!available)
+		return 0;
+
+	// mapped rather than read, so the binary goes to the driver straight from the file cache
+	MappedFile file;
+	file.open(directory + name + ".bin");
+
+	uint64_t fileKey = 0;
+	uint32_t format = 0, length = 0;
+	if (file.size() >= PROGRAM_CACHE_HEADER_SIZE && memcmp(file.data(), PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC)) == 0)
+	{
+		const uint8_t *in = file.data() + sizeof(PROGRAM_CACHE_MAGIC);
+		memcpy(&fileKey, in, 8);
+		memcpy(&format, in + 8, 4);
+		memcpy(&length, in + 12, 4);
+	}
+	if (fileKey != expectedKey || length == 0 || file.size() != PROGRAM_CACHE_HEADER_SIZE + length)
+	{
+		missCount++;
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, format, file.data() + PROGRAM_CACHE_HEADER_SIZE, length);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		glDeleteProgram(program);
+		missCount++;
+		return 0;
+	}
+	hitCount++;
+	return program;
+}
+// end::loadProgramBinary[]
+
+// tag::storeProgramBinary[]
+bool ProgramCache::store(const std::string &name, uint64_t programKey, GLuint program)
+{
+	if (!available)
+		return false;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+
+	std::vector<char> bytes(PROGRAM_CACHE_HEADER_SIZE + length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &format, &bytes[PROGRAM_CACHE_HEADER_SIZE]);
+	if (written <= 0)
+		return false;
+	bytes.resize(PROGRAM_CACHE_HEADER_SIZE + written);
+
+	// native byte order - the key ties the file to this machine's driver anyway
+	uint32_t format32 = format, length32 = written;
+	char *out = &bytes[0];
+	memcpy(out, PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+	memcpy(out + sizeof(PROGRAM_CACHE_MAGIC), &programKey, 8);
+	memcpy(out + sizeof(PROGRAM_CACHE_MAGIC) + 8, &format32, 4);
+	memcpy(out + sizeof(PROGRAM_CACHE_MAGIC) + 12, &length32, 4);
+
+	std::ofstream file(directory + name + ".bin", std::ios::binary | std::ios::trunc);
+	file.write(&bytes[0], bytes.size());
+	return (bool)file;
+}
+// end::storeProgramBinary[]
@@ -0,0 +1,60 @@
+#pragma once
+
+// Linked GLSL programs kept on disk between runs. After a program is compiled and linked, its
+// driver-specific binary (glGetProgramBinary) is written to <directory>/<name>.bin; the next
+// launch hands that straight back to the driver (glProgramBinary) and skips compiling and
+// linking altogether.
+//
+// A binary is only good for the exact sources and driver that produced it, so each file starts
+// with a key - XXH64 of every shader source plus the GL vendor, renderer and version strings -
+// and a file whose key doesn't match, or that the driver refuses to load (the driver is free to
+// reject its own binaries, e.g. after an update), is a miss: the caller compiles as before and
+// stores the result, replacing the stale file.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// tag::ShaderSource[]
+// a shader's text, owned by something else - a string, or a mapped file or asset pack
+struct ShaderSource
+{
+	GLenum type; // GL_VERTEX_SHADER, ...
+	const char *source;
+	GLint length;
+};
+// end::ShaderSource[]
+
+// tag::ProgramCache[]
+class ProgramCache
+{
+public:
+	// keep binaries in directory, which must exist and end in a path separator; call once the GL
+	// context is current. Caching is off if directory is empty or the driver has no binary formats
+	void initialise(const std::string &directory);
+
+	bool enabled() const { return available; }
+
+	// the key for sources on this driver
+	uint64_t key(const std::vector<ShaderSource> &sources) const;
+
+	// the linked program stored as name with this key, or 0 on a miss
+	GLuint load(const std::string &name, uint64_t key);
+
+	// save program, which must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set;
+	// returns false if it couldn't be retrieved or written
+	bool store(const std::string &name, uint64_t key, GLuint program);
+
+	int hits() const { return hitCount; }
+	int misses() const { return missCount; }
+
+private:
+	std::string directory;
+	std::string driver; // vendor, renderer and version, hashed into every key
+	bool available = false;
+	int hitCount = 0;
+	int missCount = 0;
+};
+// end::ProgramCache[]
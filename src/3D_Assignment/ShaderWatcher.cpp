@@ -0,0 +1,111 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+
+ShaderWatcher::~ShaderWatcher()
+{
+	if (descriptor >= 0)
+		close(descriptor);
+}
+
+// tag::watchShaders[]
+bool ShaderWatcher::watch(const std::string &watchDirectory, const std::vector<std::string> &watchFiles)
+{
+	directory = watchDirectory;
+	files = watchFiles;
+
+	descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (descriptor < 0)
+		return false;
+
+	// a save is either the file closed after writing, or another file renamed over it
+	if (inotify_add_watch(descriptor, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(descriptor);
+		descriptor = -1;
+		return false;
+	}
+	return true;
+}
+// end::watchShaders[]
+
+// tag::shadersChanged[]
+bool ShaderWatcher::changed()
+{
+	if (descriptor < 0)
+		return false;
+
+	// drain every queued event, so a save that fires several only reloads once
+	bool any = false;
+	alignas(inotify_event) char events[4096];
+	ssize_t length;
+	while ((length = read(descriptor, events, sizeof(events))) > 0)
+	{
+		for (char *event = events; event < events + length; )
+		{
+			const inotify_event *notification = (const inotify_event *)event;
+			if (notification->len > 0 && std::find(files.begin(), files.end(), std::string(notification->name)) != files.end())
+				any = true;
+			event += sizeof(inotify_event) + notification->len;
+		}
+	}
+	return any;
+}
+// end::shadersChanged[]
+
+#else
+
+static long long modificationTime(const std::string &path)
+{
+	struct stat status;
+	return stat(path.c_str(), &status) == 0 ? (long long)status.st_mtime : 0;
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+}
+
+bool ShaderWatcher::watch(const std::string &watchDirectory, const std::vector<std::string> &watchFiles)
+{
+	directory = watchDirectory;
+	if (!directory.empty() && directory.back() != '/' && directory.back() != '\\')
+		directory += '/';
+	files = watchFiles;
+	modified.clear();
+	for (const std::string &file : files)
+		modified.push_back(modificationTime(directory + file));
+	return true;
+}
+
+bool ShaderWatcher::changed()
+{
+	using namespace std::chrono;
+	long long now = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+	if (now - lastCheck < 500)
+		return false;
+	lastCheck = now;
+
+	bool any = false;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		long long time = modificationTime(directory + files[i]);
+		if (time != modified[i])
+		{
+			modified[i] = time;
+			any = true;
+		}
+	}
+	return any;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+// Noticing when shader files are saved, without blocking or polling the disk every frame.
+//
+// On Linux this is inotify on the directory holding the files - not the files themselves, since
+// most editors save by writing a new file and renaming it over the old one, which would end a
+// watch on the file - read through a non-blocking descriptor, so changed() costs one read() that
+// usually returns nothing. Elsewhere it falls back to comparing modification times, at most twice
+// a second.
+
+#include <string>
+#include <vector>
+
+// tag::ShaderWatcher[]
+class ShaderWatcher
+{
+public:
+	~ShaderWatcher();
+
+	// watch files in directory ("" for the working directory); returns false if the platform's
+	// notifications couldn't be set up
+	bool watch(const std::string &directory, const std::vector<std::string> &files);
+
+	// true if any of the files has been written since the last call
+	bool changed();
+
+private:
+	std::string directory;
+	std::vector<std::string> files;
+
+#ifdef __linux__
+	int descriptor = -1;
+#else
+	std::vector<long long> modified; // per file, when it was last seen to change
+	long long lastCheck = 0;
+#endif
+};
+// end::ShaderWatcher[]
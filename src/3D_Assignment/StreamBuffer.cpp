@@ -0,0 +1,146 @@
+#include "StreamBuffer.h"
+
+#include <cstring>
+#include <chrono>
+
+using namespace std::chrono;
+
+// tag::initialiseStreamBuffer[]
+bool StreamBuffer::initialise(GLsizeiptr size)
+{
+	capacity = size;
+	glGenBuffers(1, &bufferObject);
+	glBindBuffer(GL_ARRAY_BUFFER, bufferObject);
+
+	persistent = GLEW_ARB_buffer_storage != 0;
+	if (persistent)
+	{
+		const GLbitfield FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, capacity, NULL, FLAGS);
+		persistentMemory = (unsigned char *)glMapBufferRange(GL_ARRAY_BUFFER, 0, capacity, FLAGS);
+		persistent = persistentMemory != nullptr;
+	}
+	if (!persistent)
+		glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return glGetError() == GL_NO_ERROR;
+}
+// end::initialiseStreamBuffer[]
+
+void StreamBuffer::destroy()
+{
+	for (const Region &region : regions)
+		glDeleteSync(region.fence);
+	regions.clear();
+
+	if (persistentMemory)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, bufferObject);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		persistentMemory = nullptr;
+	}
+	glDeleteBuffers(1, &bufferObject);
+	bufferObject = 0;
+}
+
+// tag::waitFor[]
+void StreamBuffer::waitFor(const Region &region)
+{
+	// usually signalled long ago, in which case this returns at once without counting as a wait
+	if (glClientWaitSync(region.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+	{
+		auto start = high_resolution_clock::now();
+		while (glClientWaitSync(region.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+			;
+		waitCount++;
+		waitTime += duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.0;
+	}
+	glDeleteSync(region.fence);
+}
+// end::waitFor[]
+
+void StreamBuffer::fence(long long end)
+{
+	if (end == frameBegin)
+		return;
+	Region region = { glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frameBegin, end };
+	regions.push_back(region);
+	frameBegin = end;
+}
+
+// tag::mapStreamBuffer[]
+void *StreamBuffer::map(GLsizeiptr bytes, GLsizeiptr alignment, GLintptr &offset)
+{
+	if (bytes > capacity || mapped)
+		return nullptr;
+
+	// round up to the alignment, and skip to the start if what's left at the end is too small
+	long long position = written % capacity;
+	long long padding = (alignment - position % alignment) % alignment;
+	if (position + padding + bytes > capacity)
+		padding = capacity - position;
+	long long begin = written + padding;
+	long long end = begin + bytes;
+
+	// everything that was in the bytes about to be overwritten has to have been drawn - including
+	// this frame's own earlier allocations, if a frame ever writes more than the whole buffer
+	long long reusedEnd = end - capacity;
+	if (frameBegin < reusedEnd)
+		fence(written);
+	while (!regions.empty() && regions.front().begin < reusedEnd)
+	{
+		waitFor(regions.front());
+		regions.pop_front();
+	}
+
+	written = end;
+	offset = (GLintptr)(begin % capacity);
+	mapped = true;
+	if (persistent)
+		return persistentMemory + offset;
+
+	glBindBuffer(GL_ARRAY_BUFFER, bufferObject);
+	return glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+	                        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+void StreamBuffer::unmap()
+{
+	if (!mapped)
+		return;
+	mapped = false;
+	if (persistent)
+		return; // coherent, so the writes are visible to the next draw as they are
+
+	glBindBuffer(GL_ARRAY_BUFFER, bufferObject);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+// end::mapStreamBuffer[]
+
+GLintptr StreamBuffer::upload(const void *data, GLsizeiptr bytes, GLsizeiptr alignment)
+{
+	GLintptr offset;
+	void *memory = map(bytes, alignment, offset);
+	if (!memory)
+		return -1;
+	memcpy(memory, data, bytes);
+	unmap();
+	return offset;
+}
+
+// tag::endFrame[]
+void StreamBuffer::endFrame()
+{
+	fence(written);
+
+	// let go of fences the GPU is already past, so the queue stays a few frames long
+	while (!regions.empty() && glClientWaitSync(regions.front().fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+	{
+		glDeleteSync(regions.front().fence);
+		regions.pop_front();
+	}
+}
+// end::endFrame[]
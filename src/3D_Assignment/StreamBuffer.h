@@ -0,0 +1,72 @@
+#pragma once
+
+// One large vertex buffer used as a ring for everything that changes every frame (HUD text, debug
+// lines, ...), so CPU writes go straight into memory the GPU isn't using and never wait on the
+// driver.
+//
+// Where ARB_buffer_storage exists the whole buffer is mapped once, persistently and coherently,
+// and allocations are just pointers into it. Otherwise each allocation maps only its own range,
+// unsynchronized and invalidated, so the driver neither waits for earlier draws nor copies.
+// Either way the GPU may still be reading what was written a frame or two ago, so every frame's
+// region is fenced at endFrame(), and an allocation that would wrap round onto a region whose
+// fence hasn't signalled waits for it - which, with the buffer a few frames' worth of data big,
+// should never happen; waits() counts the times it did.
+
+#include <deque>
+
+#include <GL/glew.h>
+
+// tag::StreamBuffer[]
+class StreamBuffer
+{
+public:
+	bool initialise(GLsizeiptr size);
+	void destroy();
+
+	GLuint buffer() const { return bufferObject; }
+	GLsizeiptr size() const { return capacity; }
+	bool isPersistent() const { return persistent; }
+
+	// reserve bytes, starting at a multiple of alignment (e.g. the vertex size, so the offset can
+	// be given to glDrawArrays as a first vertex), and return where to write them; unmap() before
+	// drawing from them. Returns null if bytes is bigger than the whole buffer
+	void *map(GLsizeiptr bytes, GLsizeiptr alignment, GLintptr &offset);
+	void unmap();
+
+	// map, copy data in and unmap; returns the offset, or -1 if it doesn't fit
+	GLintptr upload(const void *data, GLsizeiptr bytes, GLsizeiptr alignment);
+
+	// fence everything allocated since the last endFrame, once the frame's draws are issued
+	void endFrame();
+
+	// how many allocations have had to wait for the GPU, and for how long in total
+	int waits() const { return waitCount; }
+	double waitMilliseconds() const { return waitTime; }
+
+private:
+	// a fenced range, in bytes written since initialise() rather than offsets, so ranges that
+	// wrap round the end of the buffer need no special cases
+	struct Region
+	{
+		GLsync fence;
+		long long begin;
+		long long end;
+	};
+
+	void fence(long long end);
+	void waitFor(const Region &region);
+
+	GLuint bufferObject = 0;
+	GLsizeiptr capacity = 0;
+	bool persistent = false;
+	unsigned char *persistentMemory = nullptr;
+	bool mapped = false;
+
+	long long written = 0;      // bytes allocated so far, wrapping padding included
+	long long frameBegin = 0;   // where this frame's unfenced region starts
+	std::deque<Region> regions; // oldest first
+
+	int waitCount = 0;
+	double waitTime = 0;
+};
+// end::StreamBuffer[]
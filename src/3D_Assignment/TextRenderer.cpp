@@ -0,0 +1,211 @@
+#include "TextRenderer.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <SDL_ttf.h>
+#else
+#include <SDL2/SDL_ttf.h>
+#endif
+
+// the atlas is this wide, and as tall as the characters need
+const int ATLAS_WIDTH = 512;
+
+// tag::initialiseText[]
+bool TextRenderer::initialise(const AssetView &fontData, const std::string &fontName, int pointSize, GLuint textProgram,
+                              StreamBuffer &streamBuffer, std::string &error)
+{
+	// read in place - the font is only needed until the atlas is built
+	TTF_Font *font = fontData ? TTF_OpenFontRW(SDL_RWFromConstMem(fontData.data, (int)fontData.size), 1, pointSize) : nullptr;
+	if (!font)
+	{
+		error = "could not open font " + fontName + (fontData ? std::string(": ") + TTF_GetError() : std::string());
+		return false;
+	}
+	cellHeight = TTF_FontHeight(font);
+	lineSkip = TTF_FontLineSkip(font);
+
+	// render every character white - only the coverage in the alpha channel is kept - and pack
+	// them into rows, a pixel apart so linear filtering doesn't bleed between neighbours
+	std::vector<SDL_Surface *> surfaces(LAST_CHARACTER - FIRST_CHARACTER + 1, nullptr);
+	int x = 0, rows = 1;
+	for (int c = FIRST_CHARACTER; c <= LAST_CHARACTER; c++)
+	{
+		Glyph &glyph = glyphs[c - FIRST_CHARACTER];
+		int minX, maxX, minY, maxY;
+		if (!TTF_GlyphIsProvided(font, (Uint16)c) || TTF_GlyphMetrics(font, (Uint16)c, &minX, &maxX, &minY, &maxY, &glyph.advance) != 0)
+			continue;
+
+		char text[2] = { (char)c, 0 };
+		SDL_Color white = { 255, 255, 255, 255 };
+		SDL_Surface *rendered = TTF_RenderUTF8_Blended(font, text, white);
+		if (!rendered)
+			continue;
+		SDL_Surface *surface = SDL_ConvertSurfaceFormat(rendered, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(rendered);
+		if (!surface)
+			continue;
+
+		if (x + surface->w > ATLAS_WIDTH)
+		{
+			x = 0;
+			rows++;
+		}
+		glyph.width = surface->w;
+		glyph.u0 = (float)x;
+		glyph.v0 = (float)(rows - 1) * (cellHeight + 1);
+		glyph.present = true;
+		surfaces[c - FIRST_CHARACTER] = surface;
+		x += surface->w + 1;
+	}
+	TTF_CloseFont(font);
+
+	int atlasHeight = rows * (cellHeight + 1);
+	std::vector<GLubyte> atlas((size_t)ATLAS_WIDTH * atlasHeight, 0);
+	for (int c = FIRST_CHARACTER; c <= LAST_CHARACTER; c++)
+	{
+		SDL_Surface *surface = surfaces[c - FIRST_CHARACTER];
+		if (!surface)
+			continue;
+		Glyph &glyph = glyphs[c - FIRST_CHARACTER];
+
+		SDL_LockSurface(surface);
+		for (int row = 0; row < std::min(surface->h, cellHeight); row++)
+		{
+			const Uint32 *pixels = (const Uint32 *)((const Uint8 *)surface->pixels + row * surface->pitch);
+			GLubyte *out = &atlas[((size_t)glyph.v0 + row) * ATLAS_WIDTH + (size_t)glyph.u0];
+			for (int column = 0; column < surface->w; column++)
+				out[column] = (GLubyte)(pixels[column] >> 24);
+		}
+		SDL_UnlockSurface(surface);
+		SDL_FreeSurface(surface);
+
+		// pixels to texture coordinates
+		glyph.u1 = (glyph.u0 + glyph.width) / ATLAS_WIDTH;
+		glyph.v1 = (glyph.v0 + cellHeight) / atlasHeight;
+		glyph.u0 /= ATLAS_WIDTH;
+		glyph.v0 /= atlasHeight;
+	}
+
+	glGenTextures(1, &atlasTexture);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, &atlas[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	program = textProgram;
+	screenSizeLocation = glGetUniformLocation(program, "screenSize");
+	glyphAtlasLocation = glGetUniformLocation(program, "glyphAtlas");
+	GLint positionLocation = glGetAttribLocation(program, "position");
+	GLint texCoordLocation = glGetAttribLocation(program, "texCoord");
+	GLint vertexColorLocation = glGetAttribLocation(program, "vertexColor");
+
+	// the attributes start at the beginning of the stream buffer; each draw picks its vertices by
+	// its first vertex, which is why uploads are aligned to the vertex size
+	stream = &streamBuffer;
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, stream->buffer());
+	glEnableVertexAttribArray(positionLocation);
+	glEnableVertexAttribArray(texCoordLocation);
+	glEnableVertexAttribArray(vertexColorLocation);
+	glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, x));
+	glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, u));
+	glVertexAttribPointer(vertexColorLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, color));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return true;
+}
+// end::initialiseText[]
+
+void TextRenderer::destroy()
+{
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteTextures(1, &atlasTexture);
+	glDeleteProgram(program);
+	vertexArray = atlasTexture = program = 0;
+}
+
+float TextRenderer::measure(const std::string &text, float scale) const
+{
+	float width = 0;
+	for (char c : text)
+		if (c >= FIRST_CHARACTER && c <= LAST_CHARACTER && glyphs[c - FIRST_CHARACTER].present)
+			width += glyphs[c - FIRST_CHARACTER].advance * scale;
+	return width;
+}
+
+// tag::addText[]
+void TextRenderer::addText(const std::string &text, float x, float y, const glm::vec4 &color, float scale)
+{
+	GLubyte rgba[4];
+	for (int i = 0; i < 4; i++)
+		rgba[i] = (GLubyte)(glm::clamp(color[i], 0.0f, 1.0f) * 255 + 0.5f);
+
+	float bottom = y + cellHeight * scale;
+	for (char c : text)
+	{
+		if (c < FIRST_CHARACTER || c > LAST_CHARACTER || !glyphs[c - FIRST_CHARACTER].present)
+			continue;
+		const Glyph &glyph = glyphs[c - FIRST_CHARACTER];
+
+		// two triangles per character, so the whole batch is one GL_TRIANGLES draw
+		float right = x + glyph.width * scale;
+		Vertex corners[4] = {
+			{ x, y, glyph.u0, glyph.v0, { rgba[0], rgba[1], rgba[2], rgba[3] } },
+			{ right, y, glyph.u1, glyph.v0, { rgba[0], rgba[1], rgba[2], rgba[3] } },
+			{ x, bottom, glyph.u0, glyph.v1, { rgba[0], rgba[1], rgba[2], rgba[3] } },
+			{ right, bottom, glyph.u1, glyph.v1, { rgba[0], rgba[1], rgba[2], rgba[3] } },
+		};
+		vertices.push_back(corners[0]);
+		vertices.push_back(corners[2]);
+		vertices.push_back(corners[1]);
+		vertices.push_back(corners[1]);
+		vertices.push_back(corners[2]);
+		vertices.push_back(corners[3]);
+
+		x += glyph.advance * scale;
+	}
+}
+// end::addText[]
+
+// tag::drawText[]
+void TextRenderer::draw(int screenWidth, int screenHeight)
+{
+	drawnCharacters = (int)vertices.size() / 6;
+	if (vertices.empty() || !program)
+	{
+		vertices.clear();
+		return;
+	}
+
+	GLintptr offset = stream->upload(&vertices[0], vertices.size() * sizeof(Vertex), sizeof(Vertex));
+	if (offset < 0)
+	{
+		vertices.clear();
+		return;
+	}
+
+	glUseProgram(program);
+	glUniform2f(screenSizeLocation, (GLfloat)screenWidth, (GLfloat)screenHeight);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+	glUniform1i(glyphAtlasLocation, 0);
+
+	glBindVertexArray(vertexArray);
+	glDrawArrays(GL_TRIANGLES, (GLint)(offset / sizeof(Vertex)), (GLsizei)vertices.size());
+	glBindVertexArray(0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+
+	vertices.clear();
+}
+// end::drawText[]
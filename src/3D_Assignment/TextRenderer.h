@@ -0,0 +1,83 @@
+#pragma once
+
+// HUD text. Every printable ASCII character of one font is rasterised with SDL2_ttf into a single
+// texture atlas at startup; after that, text is only quads. Everything added during a frame goes
+// into one vertex array that is copied into the frame's StreamBuffer and drawn with a single
+// glDrawArrays, so a frame's text costs one upload and one draw however many strings and
+// characters it has.
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "StreamBuffer.h"
+#include "AssetPack.h"
+
+#define GLM_FORCE_RADIANS // suppress a warning in GLM 0.9.5
+#include <glm/glm.hpp>
+
+// tag::TextRenderer[]
+class TextRenderer
+{
+public:
+	// rasterise the font file's bytes into the atlas and set up the buffers; program is built from
+	// textVertexShader.glsl and textFragmentShader.glsl, and is deleted by destroy(); the vertices
+	// are streamed through stream. Returns false and sets error (naming the font fontName) if the
+	// font can't be opened
+	bool initialise(const AssetView &fontData, const std::string &fontName, int pointSize, GLuint program, StreamBuffer &stream,
+	                std::string &error);
+	void destroy();
+
+	// pixels from the top of one line to the top of the next, at scale 1
+	int lineHeight() const { return lineSkip; }
+
+	// width of text in pixels
+	float measure(const std::string &text, float scale = 1) const;
+
+	// queue text with its top left corner x, y pixels from the top left of the screen; characters
+	// the atlas doesn't have are skipped
+	void addText(const std::string &text, float x, float y, const glm::vec4 &color, float scale = 1);
+
+	// draw everything queued since the last draw, and start an empty batch for the next frame
+	void draw(int screenWidth, int screenHeight);
+
+	// characters in the last draw
+	int lastDrawCharacters() const { return drawnCharacters; }
+
+private:
+	static const int FIRST_CHARACTER = 32;
+	static const int LAST_CHARACTER = 126;
+
+	// where a character is in the atlas; every cell is a whole line high, with the baseline in the
+	// same place, so characters line up without per-glyph offsets
+	struct Glyph
+	{
+		float u0 = 0, v0 = 0, u1 = 0, v1 = 0;
+		int width = 0;
+		int advance = 0;
+		bool present = false;
+	};
+
+	struct Vertex
+	{
+		GLfloat x, y;
+		GLfloat u, v;
+		GLubyte color[4];
+	};
+
+	Glyph glyphs[LAST_CHARACTER - FIRST_CHARACTER + 1];
+	int cellHeight = 0;
+	int lineSkip = 0;
+
+	std::vector<Vertex> vertices;
+	int drawnCharacters = 0;
+
+	GLuint program = 0;
+	GLint screenSizeLocation = -1;
+	GLint glyphAtlasLocation = -1;
+	GLuint atlasTexture = 0;
+	GLuint vertexArray = 0;
+	StreamBuffer *stream = nullptr;
+};
+// end::TextRenderer[]
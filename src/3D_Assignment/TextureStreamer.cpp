@@ -0,0 +1,300 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <SDL2/SDL.h>
+#ifdef _WIN32
+#include <SDL_image.h>
+#else
+#include <SDL2/SDL_image.h>
+#endif
+
+#include "MappedFile.h"
+
+// tag::initialiseTextureStreamer[]
+bool TextureStreamer::initialise(const AssetPack &pack, GLsizeiptr bytesPerFrame, int decodeThreads)
+{
+	assetPack = &pack;
+	budgetBytes = bytesPerFrame;
+
+	// a few frames of budget, so the ring never waits on the GPU for last frame's copies; and at
+	// least enough for any row of the widest texture GL allows, which is always uploaded whole
+	if (!staging.initialise(std::max<GLsizeiptr>(4 * bytesPerFrame, 1024 * 1024)))
+		return false;
+
+	const GLubyte WHITE[4] = { 255, 255, 255, 255 };
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_2D, placeholder);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, WHITE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	stopping = false;
+	decodePool.reset(new WorkerPool(decodeThreads));
+	loader = std::thread(&TextureStreamer::loaderLoop, this);
+	return glGetError() == GL_NO_ERROR;
+}
+// end::initialiseTextureStreamer[]
+
+void TextureStreamer::destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (loader.joinable())
+		loader.join(); // after any batch it's in the middle of
+	decodePool.reset();
+	queued.clear();
+	decoded.clear();
+
+	for (const Texture &texture : textures)
+		glDeleteTextures(1, &texture.object);
+	textures.clear();
+	handles.clear();
+	uploads.clear();
+	pendingCount = 0;
+
+	glDeleteTextures(1, &placeholder);
+	placeholder = 0;
+	staging.destroy();
+}
+
+int TextureStreamer::request(const std::string &name)
+{
+	std::map<std::string, int>::const_iterator found = handles.find(name);
+	if (found != handles.end())
+		return found->second;
+
+	int handle = (int)textures.size();
+	textures.push_back(Texture());
+	textures.back().name = name;
+	handles[name] = handle;
+	pendingCount++;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.push_back(std::make_pair(handle, name));
+	}
+	wake.notify_one();
+	return handle;
+}
+
+GLuint TextureStreamer::texture(int handle) const
+{
+	if (handle < 0 || handle >= (int)textures.size() || !textures[handle].visible)
+		return placeholder;
+	return textures[handle].object;
+}
+
+// tag::loaderLoop[]
+// everything requested since the last batch is decoded as one batch, an image per worker
+void TextureStreamer::loaderLoop()
+{
+	while (true)
+	{
+		std::vector<std::pair<int, std::string>> batch;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || !queued.empty(); });
+			if (stopping)
+				return;
+			batch.swap(queued);
+		}
+
+		std::vector<Decoded> images(batch.size());
+		decodePool->parallelFor((int)batch.size(), [&](int, int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				images[i].handle = batch[i].first;
+				decode(batch[i].second, images[i]);
+			}
+		});
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (Decoded &image : images)
+			decoded.push_back(std::move(image));
+	}
+}
+// end::loaderLoop[]
+
+// tag::decodeTexture[]
+// on a decode thread: nothing here may touch GL
+void TextureStreamer::decode(const std::string &name, Decoded &image) const
+{
+	AssetView bytes = assetPack->find(name);
+	MappedFile file;
+	if (!bytes)
+	{
+		if (!file.open(name))
+		{
+			image.error = "cannot map file " + name;
+			return;
+		}
+		bytes.data = file.data();
+		bytes.size = file.size();
+	}
+
+	SDL_Surface *loaded = IMG_Load_RW(SDL_RWFromConstMem(bytes.data, (int)bytes.size), 1);
+	if (!loaded)
+	{
+		image.error = IMG_GetError();
+		return;
+	}
+	// ABGR8888 is R, G, B, A in memory on the little-endian machines this builds for - GL_RGBA
+	SDL_Surface *surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ABGR8888, 0);
+	SDL_FreeSurface(loaded);
+	if (!surface)
+	{
+		image.error = SDL_GetError();
+		return;
+	}
+
+	int width = surface->w, height = surface->h;
+	std::vector<uint8_t> pixels((size_t)width * height * 4);
+	SDL_LockSurface(surface);
+	for (int row = 0; row < height; row++)
+		memcpy(&pixels[(size_t)row * width * 4], (const uint8_t *)surface->pixels + row * surface->pitch, (size_t)width * 4);
+	SDL_UnlockSurface(surface);
+	SDL_FreeSurface(surface);
+
+	image.widths.push_back(width);
+	image.heights.push_back(height);
+	image.levels.push_back(std::move(pixels));
+
+	// each level a 2x2 box filter of the one above, down to 1x1; odd edges repeat their last texel
+	while (width > 1 || height > 1)
+	{
+		int nextWidth = std::max(1, width / 2), nextHeight = std::max(1, height / 2);
+		const std::vector<uint8_t> &above = image.levels.back();
+		std::vector<uint8_t> level((size_t)nextWidth * nextHeight * 4);
+		for (int y = 0; y < nextHeight; y++)
+		{
+			const uint8_t *row0 = &above[(size_t)std::min(2 * y, height - 1) * width * 4];
+			const uint8_t *row1 = &above[(size_t)std::min(2 * y + 1, height - 1) * width * 4];
+			for (int x = 0; x < nextWidth; x++)
+			{
+				int x0 = std::min(2 * x, width - 1) * 4, x1 = std::min(2 * x + 1, width - 1) * 4;
+				for (int c = 0; c < 4; c++)
+					level[((size_t)y * nextWidth + x) * 4 + c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+			}
+		}
+		width = nextWidth;
+		height = nextHeight;
+		image.widths.push_back(width);
+		image.heights.push_back(height);
+		image.levels.push_back(std::move(level));
+	}
+}
+// end::decodeTexture[]
+
+// tag::startUpload[]
+// storage for every level, none of it filled in yet - sampling is limited to the levels that are
+void TextureStreamer::startUpload(Decoded &image)
+{
+	Texture &texture = textures[image.handle];
+	int levels = (int)image.levels.size();
+	glGenTextures(1, &texture.object);
+	glBindTexture(GL_TEXTURE_2D, texture.object);
+	if (GLEW_ARB_texture_storage)
+		glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, image.widths[0], image.heights[0]);
+	else
+		for (int level = 0; level < levels; level++)
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, image.widths[level], image.heights[level], 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	uploads.push_back(Upload());
+	Upload &upload = uploads.back();
+	upload.image = std::move(image);
+	upload.level = levels - 1;
+	upload.row = 0;
+}
+// end::startUpload[]
+
+// tag::uploadRows[]
+// as many rows of the upload as budget allows, smallest level first; true once level 0 is in. The
+// pixel unpack buffer must be bound to the staging ring
+bool TextureStreamer::uploadRows(Upload &upload, GLsizeiptr &budget)
+{
+	Texture &texture = textures[upload.image.handle];
+	glBindTexture(GL_TEXTURE_2D, texture.object);
+	while (true)
+	{
+		int width = upload.image.widths[upload.level], height = upload.image.heights[upload.level];
+		GLsizeiptr rowBytes = (GLsizeiptr)width * 4;
+		int rows = (int)std::min<GLsizeiptr>(height - upload.row, std::min(budget, staging.size()) / rowBytes);
+		if (rows == 0)
+		{
+			if (budget < budgetBytes)
+				return false; // the rest next frame
+			rows = 1; // a row wider than the whole budget still has to go some time
+		}
+
+		GLsizeiptr bytes = rows * rowBytes;
+		GLintptr offset = staging.upload(&upload.image.levels[upload.level][(size_t)upload.row * rowBytes], bytes, 4);
+		glTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, upload.row, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid *)offset);
+		budget = std::max<GLsizeiptr>(0, budget - bytes);
+		updateBytes += bytes;
+		upload.row += rows;
+		if (upload.row < height)
+			continue;
+
+		// the level is complete: show it, and let go of its pixels
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, upload.level);
+		texture.visible = true;
+		std::vector<uint8_t>().swap(upload.image.levels[upload.level]);
+		if (upload.level == 0)
+			return true;
+		upload.level--;
+		upload.row = 0;
+	}
+}
+// end::uploadRows[]
+
+// tag::updateTextureStreamer[]
+bool TextureStreamer::update(std::string &error)
+{
+	std::vector<Decoded> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready.swap(decoded);
+	}
+
+	bool failed = false;
+	for (Decoded &image : ready)
+	{
+		if (image.error.empty())
+		{
+			startUpload(image);
+			continue;
+		}
+		// it stays the placeholder
+		error += (failed ? "\n" : "") + textures[image.handle].name + " could not be loaded - " + image.error;
+		failed = true;
+		pendingCount--;
+	}
+
+	GLsizeiptr budget = budgetBytes;
+	updateBytes = 0;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer());
+	while (!uploads.empty() && budget > 0 && uploadRows(uploads.front(), budget))
+	{
+		uploads.pop_front();
+		pendingCount--;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	staging.endFrame(); // fence the copies, so the ring doesn't overwrite staged rows before they're read
+	return !failed;
+}
+// end::updateTextureStreamer[]
@@ -0,0 +1,106 @@
+#pragma once
+
+// Textures that load while the game runs rather than before it starts. request() only queues the
+// image and hands back a handle; a loader thread decodes queued images with SDL2_image, spread
+// over a WorkerPool, and box-filters each into a full mip chain. Once a frame, on the GL thread,
+// update() copies decoded levels into a StreamBuffer used as a pixel unpack (PBO) staging ring and
+// issues glTexSubImage2D from it - smallest level first, a band of rows at a time, and never more
+// than the per-frame byte budget - so the driver's copies are spread over frames and a big image
+// never causes a spike.
+//
+// Until a texture's first level is in, texture() gives a 1x1 white placeholder, so a textured
+// material shows its plain colour; after that GL_TEXTURE_BASE_LEVEL is moved down to each level
+// as it completes, and the texture sharpens from a few pixels to full size over a few frames.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <GL/glew.h>
+
+#include "AssetPack.h"
+#include "StreamBuffer.h"
+#include "WorkerPool.h"
+
+// tag::TextureStreamer[]
+class TextureStreamer
+{
+public:
+	// images come from pack if it has them, otherwise from files; at most bytesPerFrame are
+	// uploaded each update(). Call with the GL context current; decodeThreads == 0 is one per core
+	bool initialise(const AssetPack &pack, GLsizeiptr bytesPerFrame, int decodeThreads = 0);
+	void destroy();
+
+	// queue the image called name (PNG, JPEG, ... anything SDL2_image reads) and return its handle;
+	// asking for the same name again gives the same handle
+	int request(const std::string &name);
+
+	// take whatever has been decoded and upload up to the frame's budget of it - once a frame, on
+	// the GL thread. Returns false and sets error for images that couldn't be decoded
+	bool update(std::string &error);
+
+	// the texture to bind for handle - the placeholder until it has a level to show, or if it
+	// couldn't be loaded. handle -1 is always the placeholder
+	GLuint texture(int handle) const;
+
+	// textures not yet fully uploaded, and bytes uploaded by the last update()
+	int pending() const { return pendingCount; }
+	GLsizeiptr lastUpdateBytes() const { return updateBytes; }
+
+private:
+	// an image and its mip chain, RGBA8, level 0 first
+	struct Decoded
+	{
+		int handle;
+		std::string error;
+		std::vector<int> widths, heights;
+		std::vector<std::vector<uint8_t>> levels;
+	};
+
+	// a decoded image on its way into its texture
+	struct Upload
+	{
+		Decoded image;
+		int level; // the level being uploaded, counting down to 0
+		int row;   // rows of it already uploaded
+	};
+
+	struct Texture
+	{
+		std::string name;
+		GLuint object = 0;
+		bool visible = false; // has at least one complete level
+	};
+
+	void loaderLoop();
+	void decode(const std::string &name, Decoded &image) const;
+	void startUpload(Decoded &image);
+	bool uploadRows(Upload &upload, GLsizeiptr &budget);
+
+	const AssetPack *assetPack = nullptr;
+	GLsizeiptr budgetBytes = 0;
+	StreamBuffer staging;
+	GLuint placeholder = 0;
+
+	std::vector<Texture> textures; // by handle - GL thread only
+	std::map<std::string, int> handles;
+	std::deque<Upload> uploads; // in request order
+	int pendingCount = 0;
+	GLsizeiptr updateBytes = 0;
+
+	// shared with the loader thread
+	std::unique_ptr<WorkerPool> decodePool;
+	std::thread loader;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::vector<std::pair<int, std::string>> queued;
+	std::vector<Decoded> decoded;
+	bool stopping = false;
+};
+// end::TextureStreamer[]
@@ -0,0 +1,103 @@
+#include "TransparencyPass.h"
+
+// tag::initialiseTransparency[]
+static GLuint createTarget(GLint internalFormat, GLenum format, int width, int height)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+bool TransparencyPass::initialise(int targetWidth, int targetHeight, GLuint depthRenderbuffer, GLuint compositeProgram,
+                                  std::string &error)
+{
+	width = targetWidth;
+	height = targetHeight;
+	accumulationTexture = createTarget(GL_RGBA16F, GL_RGBA, width, height);
+	weightTexture = createTarget(GL_R16F, GL_RED, width, height);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulationTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weightTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+	const GLenum DRAW_BUFFERS[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, DRAW_BUFFERS);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		error = "the accumulation targets can't be rendered to";
+		destroy();
+		return false;
+	}
+
+	program = compositeProgram;
+	accumulationLocation = glGetUniformLocation(program, "accumulation");
+	weightsLocation = glGetUniformLocation(program, "weights");
+	glGenVertexArrays(1, &emptyVertexArray);
+	return true;
+}
+// end::initialiseTransparency[]
+
+void TransparencyPass::destroy()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &accumulationTexture);
+	glDeleteTextures(1, &weightTexture);
+	glDeleteVertexArrays(1, &emptyVertexArray);
+	*this = TransparencyPass();
+}
+
+// tag::beginTransparency[]
+void TransparencyPass::begin()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	// nothing added, everything revealed - only in the viewport, which may be a corner of the targets
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glScissor(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glEnable(GL_SCISSOR_TEST);
+	const GLfloat CLEAR_ACCUMULATION[] = { 0, 0, 0, 1 };
+	const GLfloat CLEAR_WEIGHTS[] = { 0, 0, 0, 0 };
+	glClearBufferfv(GL_COLOR, 0, CLEAR_ACCUMULATION);
+	glClearBufferfv(GL_COLOR, 1, CLEAR_WEIGHTS);
+	glDisable(GL_SCISSOR_TEST);
+
+	// colour and weight sums add up; the revealage multiplies by (1 - alpha)
+	glEnable(GL_BLEND);
+	glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+}
+// end::beginTransparency[]
+
+// tag::compositeTransparency[]
+void TransparencyPass::composite(GLuint target)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+	glDepthMask(GL_TRUE);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_DEPTH_TEST);
+
+	glUseProgram(program);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, weightTexture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, accumulationTexture);
+	glUniform1i(accumulationLocation, 0);
+	glUniform1i(weightsLocation, 1);
+	glBindVertexArray(emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glEnable(GL_DEPTH_TEST);
+}
+// end::compositeTransparency[]
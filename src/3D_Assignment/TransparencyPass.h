@@ -0,0 +1,55 @@
+#pragma once
+
+// Order-independent transparency: weighted blended OIT (McGuire and Bavoil 2013). Translucent
+// surfaces aren't sorted or blended over each other in draw order; instead every fragment is
+// added into two targets with a weight that falls off with distance, and one full-screen pass
+// then blends their weighted average over the opaque scene. The result doesn't depend on the
+// order things are drawn in, so any number of overlapping translucent models look right from
+// every camera, at the cost of a fixed two-target pass instead of a per-frame sort.
+//
+// The targets, cleared before the translucent surfaces are drawn:
+//   accumulation (RGBA16F) - rgb: the sum of colour * alpha * weight; alpha: the product of
+//                            (1 - alpha), the revealage - how much of the opaque scene shows
+//   weights      (R16F)    - the sum of alpha * weight, to normalise the colour sum by
+// Summing rgb and multiplying alpha is one glBlendFuncSeparate for both targets, so it needs
+// nothing past GL 3.3 (no per-target blend functions).
+//
+// The world's fragment shader writes both when its transparentPass uniform is set; depth is
+// tested against the opaque pass's depth buffer, which is shared rather than copied, but not
+// written.
+
+#include <string>
+
+#include <GL/glew.h>
+
+// tag::TransparencyPass[]
+class TransparencyPass
+{
+public:
+	// targets width x height pixels, tested against depthRenderbuffer - the opaque pass's, the
+	// same size. compositeProgram is built from transparencyVertexShader.glsl and
+	// transparencyFragmentShader.glsl; it can be shared between passes and isn't deleted by
+	// destroy(). Returns false and sets error if the targets can't be rendered to
+	bool initialise(int width, int height, GLuint depthRenderbuffer, GLuint compositeProgram, std::string &error);
+	void destroy();
+
+	// bind the targets, with the viewport's part of them cleared, and set the blending and depth
+	// state for translucent surfaces
+	void begin();
+
+	// blend everything drawn in the viewport since begin() over the same part of framebuffer's
+	// colour - the opaque pass it was tested against - in one draw, and put the blending and depth
+	// state back
+	void composite(GLuint framebuffer);
+
+private:
+	int width = 0, height = 0;
+	GLuint framebuffer = 0;
+	GLuint accumulationTexture = 0;
+	GLuint weightTexture = 0;
+	GLuint program = 0;
+	GLint accumulationLocation = -1;
+	GLint weightsLocation = -1;
+	GLuint emptyVertexArray = 0; // the full-screen triangle comes from gl_VertexID, but core GL needs a VAO bound
+};
+// end::TransparencyPass[]
@@ -1,7 +1,23 @@
 #version 330
 in vec4 fragmentColor;
-out vec4 outputColor;
+in vec2 fragmentTexCoord;
+in float fragmentDepth;
+layout(location = 0) out vec4 outputColor;
+layout(location = 1) out vec4 outputWeight; // only drawn to in the transparent pass
+
+uniform sampler2D diffuseTexture; // white where a model has no texture
+uniform bool transparentPass = false; // accumulating translucent surfaces (TransparencyPass.h)
+
 void main()
 {
-	 outputColor = fragmentColor;
+	 vec4 color = fragmentColor * texture(diffuseTexture, fragmentTexCoord);
+	 if (!transparentPass)
+	 {
+		 outputColor = color;
+		 return;
+	 }
+	 // McGuire and Bavoil's depth weight (their equation 7): nearer surfaces count for more
+	 float weight = color.a * clamp(10.0 / (1e-5 + pow(fragmentDepth / 5.0, 2.0) + pow(fragmentDepth / 200.0, 6.0)), 1e-2, 3e3);
+	 outputColor = vec4(color.rgb * color.a * weight, color.a);
+	 outputWeight = vec4(color.a * weight);
 }
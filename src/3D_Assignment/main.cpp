@@ -15,16 +15,50 @@
 #include <algorithm>
 #include <string>
 #include <cassert>
+#include <cstdlib>
+#include <cstdio>
 
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
+#ifdef _WIN32
+#include <SDL_ttf.h>
+#include <SDL_image.h>
+#else
+#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL_image.h>
+#endif
 
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #define GLM_FORCE_RADIANS // suppress a warning in GLM 0.9.5
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+
+#include "Simulation.h"
+#include "FixedSimulation.h"
+#include "Replay.h"
+#include "Controller.h"
+#include "VecEnv.h"
+#include "PaddleAI.h"
+
+#include "StreamBuffer.h"
+#include "TextRenderer.h"
+#include "DebugDraw.h"
+#include "ProgramCache.h"
+#include "ShaderWatcher.h"
+#include "Mesh.h"
+#include "TextureStreamer.h"
+#include "TransparencyPass.h"
+#include "GpuTimer.h"
+#include "ResolutionController.h"
+#include "AssetPack.h"
+#include "MappedFile.h"
 // end::includes[]
 
 // tag::using[]
@@ -66,167 +100,44 @@ std::string loadShader(const string filePath) {
 }
 // end::loadShader[]
 
+// tag::loadAsset[]
+//startup assets come from the asset pack (AssetPack.h) given with --pack, and otherwise from their own
+//files - mapped rather than read, so either way the bytes go to GL without being copied first
+string assetPackPath;
+string buildPackPath;
+AssetPack assetPack;
+std::deque<MappedFile> looseAssets; //mapped files, kept until the end of loadAssets
+
+//the asset called name from the pack, or else the file at path (name, if path is empty)
+AssetView loadAsset(const string &name, const string &path = "")
+{
+	AssetView asset = assetPack.find(name);
+	if (asset)
+		return asset;
+
+	string filePath = path.empty() ? name : path;
+	looseAssets.emplace_back();
+	if (looseAssets.back().open(filePath))
+	{
+		asset.data = looseAssets.back().data();
+		asset.size = looseAssets.back().size();
+	}
+	else
+	{
+		cerr << "Asset could not be loaded - cannot map file " << filePath << endl;
+		looseAssets.pop_back();
+	}
+	return asset;
+}
+// end::loadAsset[]
+
 //our variables
 bool done = false;
 high_resolution_clock::time_point timePrev;
-bool isColliding = false;
 bool changeCamera = false;
 
 // tag::vertexData[]
-//the data about our geometry
-const GLfloat paddleVertexData[] = {
-//	    X        Y        Z        R     G     B      A
-// Front face
-	-0.250f, -0.125f, -0.125f,    1.0f, 0.0f, 0.0f,  1.0f, // 4
-	-0.250f,  0.125f, -0.125f,    1.0f, 0.0f, 0.0f,  1.0f, // 1
-	 0.250f, -0.125f, -0.125f,    1.0f, 0.0f, 0.0f,  1.0f, // 3
-	-0.250f,  0.125f, -0.125f,    1.0f, 0.0f, 0.0f,  1.0f, // 1
-	 0.250f, -0.125f, -0.125f,    1.0f, 0.0f, 0.0f,  1.0f, // 3
-	 0.250f,  0.125f, -0.125f,    1.0f, 0.0f, 0.0f,  1.0f, // 2
-
-// Back face
-	-0.250f, -0.125f,  0.125f,    0.0f, 1.0f, 0.0f,  1.0f, // 8
-	-0.250f,  0.125f,  0.125f,    0.0f, 1.0f, 0.0f,  1.0f, // 5
-	 0.250f, -0.125f,  0.125f,    0.0f, 1.0f, 0.0f,  1.0f, // 7
-	-0.250f,  0.125f,  0.125f,    0.0f, 1.0f, 0.0f,  1.0f, // 5
-	 0.250f, -0.125f,  0.125f,    0.0f, 1.0f, 0.0f,  1.0f, // 7
-	 0.250f,  0.125f,  0.125f,    0.0f, 1.0f, 0.0f,  1.0f, // 6
-
-// Left Face
-	-0.250f, -0.125f, -0.125f,    0.0f, 0.0f, 1.0f,  1.0f, // 4
-	-0.250f,  0.125f, -0.125f,    0.0f, 0.0f, 1.0f,  1.0f, // 1
-	-0.250f, -0.125f,  0.125f,    0.0f, 0.0f, 1.0f,  1.0f, // 8
-	-0.250f,  0.125f, -0.125f,    0.0f, 0.0f, 1.0f,  1.0f, // 1
-	-0.250f,  0.125f,  0.125f,    0.0f, 0.0f, 1.0f,  1.0f, // 5
-	-0.250f, -0.125f,  0.125f,    0.0f, 0.0f, 1.0f,  1.0f, // 8
-
-// Right Face
-	 0.250f,  0.125f, -0.125f,    0.0f, 0.5f, 0.0f,  1.0f, // 2
-	 0.250f, -0.125f, -0.125f,    0.0f, 0.5f, 0.0f,  1.0f, // 3
-	 0.250f, -0.125f,  0.125f,    0.0f, 0.5f, 0.0f,  1.0f, // 7
-	 0.250f, -0.125f,  0.125f,    0.0f, 0.5f, 0.0f,  1.0f, // 7
-	 0.250f,  0.125f,  0.125f,    0.0f, 0.5f, 0.0f,  1.0f, // 6
-	 0.250f,  0.125f, -0.125f,    0.0f, 0.5f, 0.0f,  1.0f, // 2
-
-// Bottom Face
-	-0.250f, -0.125f, -0.125f,    0.0f, 0.5f, 0.5f,  1.0f, // 4
-	-0.250f, -0.125f,  0.125f,    0.0f, 0.5f, 0.5f,  1.0f, // 8
-	 0.250f, -0.125f, -0.125f,    0.0f, 0.5f, 0.5f,  1.0f, // 3
-	 0.250f, -0.125f, -0.125f,    0.0f, 0.5f, 0.5f,  1.0f, // 3
-	 0.250f, -0.125f,  0.125f,    0.0f, 0.5f, 0.5f,  1.0f, // 7
-	-0.250f, -0.125f,  0.125f,    0.0f, 0.5f, 0.5f,  1.0f, // 8
-
-// Top Face
-	-0.250f,  0.125f,  0.125f,    0.5f, 0.5f, 0.0f,  1.0f, // 5
-	-0.250f,  0.125f, -0.125f,    0.5f, 0.5f, 0.0f,  1.0f, // 1
-	 0.250f,  0.125f, -0.125f,    0.5f, 0.5f, 0.0f,  1.0f, // 2
-	 0.250f,  0.125f, -0.125f,    0.5f, 0.5f, 0.0f,  1.0f, // 2
-	 0.250f,  0.125f,  0.125f,    0.5f, 0.5f, 0.0f,  1.0f, // 6
-	-0.250f,  0.125f,  0.125f,    0.5f, 0.5f, 0.0f,  1.0f, // 5
-};
-
-const GLfloat worldBoundsVertexData[] = {
-//	    X        Y        Z        R     G     B      A
-	// Front face
-	-0.250f, -0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 4
-	-0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 1
-	 0.250f, -0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 3
-	-0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 1
-	 0.250f, -0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 3
-	 0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 2
-
-														  // Back face
-	-0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 8
-	-0.250f,  0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 5
-	 0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 7
-	-0.250f,  0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 5
-	 0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 7
-	 0.250f,  0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 6
-
-														  // Left Face
-	-0.250f, -0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 4
-	-0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 1
-	-0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 8
-	-0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 1
-	-0.250f,  0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 5
-	-0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 8
-
-														   // Right Face
-	 0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 2
-	 0.250f, -0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 3
-	 0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 7
-	 0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 7
-	 0.250f,  0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 6
-	 0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 2
-
-														  // Bottom Face
-	-0.250f, -0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 4
-	-0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 8
-	 0.250f, -0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 3
-	 0.250f, -0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 3
-	 0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 7
-	-0.250f, -0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 8
-
-														   // Top Face
-	-0.250f,  0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 5
-	-0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 1
-	 0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 2
-	 0.250f,  0.125f, -0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 2
-	 0.250f,  0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 6
-	-0.250f,  0.125f,  0.125f,    0.4f, 0.4f, 0.4f,  0.3f, // 5
-};
-
-const GLfloat ballVertexData[] = {
-//	    X        Y     Z        R     G     B      A
-	// Front face
-	-0.05f, -0.05f, -0.05f,    1.0f, 0.0f, 0.0f,  1.0f, // 4
-	-0.05f,  0.05f, -0.05f,    1.0f, 0.0f, 0.0f,  1.0f, // 1
-	 0.05f, -0.05f, -0.05f,    1.0f, 0.0f, 0.0f,  1.0f, // 3
-	-0.05f,  0.05f, -0.05f,    1.0f, 0.0f, 0.0f,  1.0f, // 1
-	 0.05f, -0.05f, -0.05f,    1.0f, 0.0f, 0.0f,  1.0f, // 3
-	 0.05f,  0.05f, -0.05f,    1.0f, 0.0f, 0.0f,  1.0f, // 2
-
-														  // Back face
-	-0.05f, -0.05f,  0.05f,    0.0f, 1.0f, 0.0f,  1.0f, // 8
-	-0.05f,  0.05f,  0.05f,    0.0f, 1.0f, 0.0f,  1.0f, // 5
-	 0.05f, -0.05f,  0.05f,    0.0f, 1.0f, 0.0f,  1.0f, // 7
-	-0.05f,  0.05f,  0.05f,    0.0f, 1.0f, 0.0f,  1.0f, // 5
-	 0.05f, -0.05f,  0.05f,    0.0f, 1.0f, 0.0f,  1.0f, // 7
-	 0.05f,  0.05f,  0.05f,    0.0f, 1.0f, 0.0f,  1.0f, // 6
-
-														  // Left Face
-	-0.05f, -0.05f, -0.05f,    0.0f, 0.0f, 1.0f,  1.0f, // 4
-	-0.05f,  0.05f, -0.05f,    0.0f, 0.0f, 1.0f,  1.0f, // 1
-	-0.05f, -0.05f,  0.05f,    0.0f, 0.0f, 1.0f,  1.0f, // 8
-	-0.05f,  0.05f, -0.05f,    0.0f, 0.0f, 1.0f,  1.0f, // 1
-	-0.05f,  0.05f,  0.05f,    0.0f, 0.0f, 1.0f,  1.0f, // 5
-	-0.05f, -0.05f,  0.05f,    0.0f, 0.0f, 1.0f,  1.0f, // 8
-
-														   // Right Face
-	 0.05f,  0.05f, -0.05f,    0.0f, 0.5f, 0.0f,  1.0f, // 2
-	 0.05f, -0.05f, -0.05f,    0.0f, 0.5f, 0.0f,  1.0f, // 3
-	 0.05f, -0.05f,  0.05f,    0.0f, 0.5f, 0.0f,  1.0f, // 7
-	 0.05f, -0.05f,  0.05f,    0.0f, 0.5f, 0.0f,  1.0f, // 7
-	 0.05f,  0.05f,  0.05f,    0.0f, 0.5f, 0.0f,  1.0f, // 6
-	 0.05f,  0.05f, -0.05f,    0.0f, 0.5f, 0.0f,  1.0f, // 2
-
-														  // Bottom Face
-	-0.05f, -0.05f, -0.05f,    0.0f, 0.5f, 0.5f,  1.0f, // 4
-	-0.05f, -0.05f,  0.05f,    0.0f, 0.5f, 0.5f,  1.0f, // 8
-	 0.05f, -0.05f, -0.05f,    0.0f, 0.5f, 0.5f,  1.0f, // 3
-	 0.05f, -0.05f, -0.05f,    0.0f, 0.5f, 0.5f,  1.0f, // 3
-	 0.05f, -0.05f,  0.05f,    0.0f, 0.5f, 0.5f,  1.0f, // 7
-	-0.05f, -0.05f,  0.05f,    0.0f, 0.5f, 0.5f,  1.0f, // 8
-
-														   // Top Face
-	-0.05f,  0.05f,  0.05f,    0.5f, 0.5f, 0.0f,  1.0f, // 5
-	-0.05f,  0.05f, -0.05f,    0.5f, 0.5f, 0.0f,  1.0f, // 1
-	 0.05f,  0.05f, -0.05f,    0.5f, 0.5f, 0.0f,  1.0f, // 2
-	 0.05f,  0.05f, -0.05f,    0.5f, 0.5f, 0.0f,  1.0f, // 2
-	 0.05f,  0.05f,  0.05f,    0.5f, 0.5f, 0.0f,  1.0f, // 6
-	-0.05f,  0.05f,  0.05f,    0.5f, 0.5f, 0.0f,  1.0f, // 5
-};
-
+//the data about our geometry - the paddles, walls and ball are models (Mesh.h), only the score quad is here
 const GLfloat scoreVertexData[] = {
 //	   X       Y       Z        R     G     B      A
 	-0.03f, -0.03f, 0.00f,    1.0f, 0.0f, 0.0f,  1.0f, // 4
@@ -240,24 +151,80 @@ const GLfloat scoreVertexData[] = {
 // end::vertexData[]
 
 // tag::gameState[]
-//the translation vector we'll pass to our GLSL program
-glm::vec3 paddle1Position = { 0.0f, 0.0f, 2.0f };
-glm::vec3 paddle2Position = { 0.0f, 0.0f, -2.0f };
-
-GLfloat paddleVelocity = 1.2;
-GLfloat ballVelocity = 1.5;
-
-GLfloat paddle1Direction = 0.0;
-GLfloat paddle2Direction = 0.0;
-
-glm::vec3 ballPosition = glm::vec3(0, 0, 0);
-glm::vec3 ballDirection = glm::vec3(1, 0, 1);
+//paddles, ball and scores - simulated by the shared rules in Simulation.h
+MatchState match;
+
+// --fixed-point runs the deterministic rules in whole ticks, and copies the result into match to draw
+bool fixedPointMode = false;
+FixedMatchState fixedMatch;
+GLdouble fixedTickAccumulator = 0;
+const int MAX_TICKS_PER_FRAME = 8; //after a stall (a window drag, a breakpoint) the rest of the time is dropped, not caught up
+
+// --record-replay <file> also records every tick's input and state hash, for PongBench hash --replay
+const char *replayPath = NULL;
+Replay replay;
+
+// --controller1 / --controller2 <spec> hand a paddle to a Controller (Controller.h) - a computer
+// player or a plugin - and ignore its keys; --ai1 / --ai2 are short for the predictive player
+std::unique_ptr<Controller> controller1;
+std::unique_ptr<Controller> controller2;
+Random controllerRandom(1);
+
+// --pixel-envs N steps N VecEnv matches each frame and renders them all into one offscreen atlas,
+// read back with a single glReadPixels, as pixel observations for agents learning from the screen
+const int PIXEL_SIZE = 84;
+int pixelEnvCount = 0;
+std::unique_ptr<VecEnv> pixelEnv;
+Random pixelActionRandom(1);
+
+// --dump-observations <file> saves the last frame's pixel observations on exit, one PPM per env
+const char *observationsPath = NULL;
+
+// tag::hudState[]
+// HUD text (TextRenderer.h) - without a font the scores fall back to a quad per point
+#ifdef _WIN32
+string fontPath = "C:\\Windows\\Fonts\\consola.ttf";
+#else
+string fontPath = "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf";
+#endif
+bool fontChosen = false; //--font beats the font in an asset pack
+const int FONT_SIZE = 20;
+TextRenderer hudText;
+bool hudTextReady = false;
+
+// GPU time per pass (GpuTimer.h), read back a few frames late so it never stalls
+enum GpuPass { GPU_SCENE, GPU_WORLD_BOUNDS, GPU_BALL, GPU_HUD, GPU_PASSES };
+const char *GPU_PASS_NAMES[GPU_PASSES] = { "scene", "bounds", "ball", "hud" };
+GpuTimer gpuTimers[GPU_PASSES];
+bool gpuTiming = false; // timer queries exist
+
+// CPU time per frame and in its phases, and GPU time per pass, summed over half a second then shown as averages
+struct FrameStats
+{
+	high_resolution_clock::time_point windowStart;
+	int frames = 0;
+	double frameMilliseconds = 0, worstFrameMilliseconds = 0, updateMilliseconds = 0, renderMilliseconds = 0;
+	long long triangles = 0; // drawn by submitWorldDraws
+	long long culled = 0; // draws no view could see
+	double sceneMilliseconds = 0; // the scene's render time, as the dynamic resolution controller sees it
+	int sceneTimings = 0;
+	double gpuMilliseconds[GPU_PASSES] = {};
+	int gpuFrames[GPU_PASSES] = {}; // whose timings have come back
+
+	static const int LINES = 5;
+	string lines[LINES]; // what the HUD shows until the next half second is up
+};
+FrameStats frameStats;
+// end::hudState[]
 
-// Scores
-int player1Score = 0;
-int player2Score = 0;
+// tag::debugDrawState[]
+// collision volumes, side limits, ball velocity and predicted path drawn over the world - F3 or --debug-draw
+DebugDraw debugDraw;
+bool debugDrawEnabled = false;
+// end::debugDrawState[]
 
 int currentCamera = 1; // store the current camera index (1-MAX_CAMS)
+bool splitScreen = false; // cameras 1 and 2 side by side instead - V or --split-screen
 
 GLfloat angle = 0;
 
@@ -268,35 +235,117 @@ GLfloat angle = 0;
 //programIDs
 GLuint theProgram; //GLuint that we'll fill in to refer to the GLSL program (only have 1 at this point)
 
+//linked programs saved between runs (ProgramCache.h) - --no-program-cache compiles every time, for comparison
+ProgramCache programCache;
+bool programCacheEnabled = true;
+double programMilliseconds = 0; //time spent getting programs ready, from the cache or compiling
+int programsCompiled = 0;
+
+// tag::shaderReloadState[]
+//saving vertexShader.glsl or fragmentShader.glsl (ShaderWatcher.h) rebuilds theProgram while frames carry on;
+//the new program replaces the old between frames once it has linked, and a broken one is reported and dropped.
+//With parallel compile the driver builds it on its own threads; without, it's built on a second context shared
+//with this one, on a thread of its own, so the driver's compile never runs on this thread
+ShaderWatcher shaderWatcher;
+bool parallelShaderCompile = false; //ARB/KHR_parallel_shader_compile: compiles on driver threads, and can be asked if they're done
+struct ProgramReload
+{
+	GLuint program = 0; //0 while nothing is building
+	string text[2]; //the vertex and fragment shaders, as read from their files
+	std::vector<ShaderSource> sources;
+	std::vector<GLuint> shaders;
+	GLsync fence = 0; //on the compile thread, fenced after the link so this context knows the GPU side is done too
+	high_resolution_clock::time_point start;
+};
+ProgramReload programReload;
+bool reloadWanted = false; //the shaders were saved, and the reload waits for the compile thread to finish the last one
+
+SDL_GLContext compileContext = nullptr; //shared with context; only without parallel compile
+std::thread compileThread;
+std::mutex compileMutex;
+std::condition_variable compileWake;
+enum CompileState { COMPILE_IDLE, COMPILE_QUEUED, COMPILE_DONE }; //who has programReload: this thread, then the compile thread, then this thread again
+CompileState compileState = COMPILE_IDLE;
+bool compileStopping = false;
+// end::shaderReloadState[]
+
 //attribute locations
 GLint positionLocation; //GLuint that we'll fill in with the location of the `position` attribute in the GLSL
 GLint vertexColorLocation; //GLuint that we'll fill in with the location of the `vertexColor` attribute in the GLSL
+GLint texCoordLocation; //-1 if the shaders don't use texture coordinates
 
 //uniform location
 GLint modelMatrixLocation;
-GLint viewMatrixLocation;
-GLint projectionMatrixLocation;
-
-GLuint paddleVertexDataBufferObject;
-GLuint paddleVertexArrayObject;
 
-GLuint worldBoundsVertexDataBufferObject;
-GLuint worldBoundsVertexArrayObject;
-
-GLuint ballVertexDataBufferObject;
-GLuint ballVertexArrayObject;
+//the view and projection are the Camera uniform block, bound to a range of the stream buffer
+const GLuint CAMERA_BINDING = 0;
+GLint uniformBufferAlignment = 256; //GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, what a bound range's offset must be a multiple of
+
+//models, imported once and then loaded from the mesh cache (Mesh.h) in SDL's per-user data directory
+Mesh paddleMesh;
+Mesh wallMesh;
+Mesh ballMesh;
+
+//each is drawn at the coarsest level of detail whose error is at most --lod-error <pixels> on screen
+float lodPixelError = 1.0f;
+
+const float FIELD_OF_VIEW = 45.0f; //degrees, vertically
+
+//the window's drawable size, which changes whenever it's resized
+int windowWidth = 600;
+int windowHeight = 600;
+
+//the scene is drawn at --render-scale <fraction> of the window's size, into the corner of targets as big
+//as the window, and scaled up as it's copied in - so the scale can change any frame without reallocating
+float renderScale = 1.0f;
+const float MIN_RENDER_SCALE = 0.25f;
+
+//--resolution-budget <ms> hands the render scale to a dynamic resolution controller (ResolutionController.h),
+//which holds the scene's render time to the budget; the scene is timed on the GPU (GpuTimer.h) where timer
+//queries exist, and on the CPU otherwise. --resolution-log <file> writes every measurement, for tuning it
+bool dynamicResolution = false;
+ResolutionConfig resolutionConfig;
+ResolutionController resolution;
+string resolutionLogPath;
+std::ofstream resolutionLog;
+high_resolution_clock::time_point sceneCpuStart;
+double sceneMilliseconds = -1; //the latest timing of the scene the controller hasn't had yet, -1 for none
+
+//the models' textures load in the background (TextureStreamer.h), a plain white placeholder until they're in;
+//--texture-budget <KB> is how much of them goes to GL each frame
+TextureStreamer textureStreamer;
+GLsizeiptr textureBudget = 256 * 1024;
+int paddleTexture = -1; //handles, -1 for the placeholder
+int wallTexture = -1;
+int ballTexture = -1;
 
 GLuint scoreVertexDataBufferObject;
 GLuint scoreVertexArrayObject;
-// end::GLVariables[]
 
-// Constant variables - Only used for collision detection
-const GLfloat PADDLE_WIDTH = 0.5;
-const GLfloat PADDLE_DEPTH = 0.25;
-const GLfloat AREA_WIDTH = 2.6; // The play area
-const GLfloat AREA_DEPTH = 6;
-const GLfloat WORLD_BOUNDS_WIDTH = 0.25;
-const GLfloat BALL_WIDTH = 0.1;
+//everything drawn from per-frame data (StreamBuffer.h) is written into this one ring buffer
+const GLsizeiptr STREAM_BUFFER_SIZE = 4 * 1024 * 1024;
+StreamBuffer streamBuffer;
+
+//the pixel observation atlas: each env is a PIXEL_SIZE square, stacked bottom to top in columns as
+//tall as GL allows, so with one column the readback is exactly [env][row][column][RGB]
+GLuint atlasFramebuffer;
+GLuint atlasColorRenderbuffer;
+GLuint atlasDepthRenderbuffer;
+int atlasRows;
+int atlasColumns;
+std::vector<uint8_t> pixelObservations;
+
+//translucent models (the walls) go through weighted blended OIT (TransparencyPass.h) in the window and in
+//the atlas, so they blend the same whatever order they're drawn in; the window's opaque pass is drawn into
+//its own framebuffer, so the transparent pass can depth test against it, and copied to the window after
+GLuint transparencyProgram;
+GLint transparentPassLocation; //theProgram's switch between drawing and accumulating
+GLuint sceneFramebuffer;
+GLuint sceneColorRenderbuffer;
+GLuint sceneDepthRenderbuffer;
+TransparencyPass sceneTransparency;
+TransparencyPass atlasTransparency;
+// end::GLVariables[]
 
 const int MAX_CAMS = 3;
 
@@ -312,6 +361,20 @@ void initialise()
 		exit(1);
 	}
 	cout << "SDL initialised OK!\n";
+
+	if (TTF_Init() != 0)
+	{
+		cerr << "TTF_Init Error: " << TTF_GetError() << std::endl;
+		SDL_Quit();
+		exit(1);
+	}
+
+	if ((IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG) & IMG_INIT_PNG) == 0)
+	{
+		cerr << "IMG_Init Error: " << IMG_GetError() << std::endl;
+		SDL_Quit();
+		exit(1);
+	}
 }
 // end::initialise[]
 
@@ -326,7 +389,7 @@ void createWindow()
 	const char *exeNameCStr = exeNameEnd.c_str();
 
 	//create window
-	win = SDL_CreateWindow(exeNameCStr, 100, 100, 600, 600, SDL_WINDOW_OPENGL); //same height and width makes the window square ...
+	win = SDL_CreateWindow(exeNameCStr, 100, 100, windowWidth, windowHeight, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE); //starts square, the projection follows whatever shape it's resized to
 
 	//error handling
 	if (win == nullptr)
@@ -387,15 +450,9 @@ void initGlew()
 // end::initGlew[]
 
 // tag::createShader[]
-GLuint createShader(GLenum eShaderType, const std::string &strShaderFile)
+//print the compile log if shader failed - waits for the compile to finish
+void reportShaderErrors(GLuint shader, GLenum eShaderType)
 {
-	GLuint shader = glCreateShader(eShaderType);
-	//error check
-	const char *strFileData = strShaderFile.c_str();
-	glShaderSource(shader, 1, &strFileData, NULL);
-
-	glCompileShader(shader);
-
 	GLint status;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
 	if (status == GL_FALSE)
@@ -417,21 +474,29 @@ GLuint createShader(GLenum eShaderType, const std::string &strShaderFile)
 		fprintf(stderr, "Compile failure in %s shader:\n%s\n", strShaderType, strInfoLog);
 		delete[] strInfoLog;
 	}
+}
+
+//checkStatus false returns as soon as the compile is issued, without waiting to see if it worked
+GLuint createShader(const ShaderSource &source, bool checkStatus = true)
+{
+	GLenum eShaderType = source.type;
+	GLuint shader = glCreateShader(eShaderType);
+	//error check - the text needn't end in a NUL, it may be straight out of a mapped file
+	glShaderSource(shader, 1, &source.source, &source.length);
+
+	glCompileShader(shader);
+
+	if (checkStatus)
+		reportShaderErrors(shader, eShaderType);
 
 	return shader;
 }
 // end::createShader[]
 
 // tag::createProgram[]
-GLuint createProgram(const std::vector<GLuint> &shaderList)
+//print the link log if program failed - waits for the link to finish
+void reportProgramErrors(GLuint program)
 {
-	GLuint program = glCreateProgram();
-
-	for (size_t iLoop = 0; iLoop < shaderList.size(); iLoop++)
-		glAttachShader(program, shaderList[iLoop]);
-
-	glLinkProgram(program);
-
 	GLint status;
 	glGetProgramiv(program, GL_LINK_STATUS, &status);
 	if (status == GL_FALSE)
@@ -444,6 +509,32 @@ GLuint createProgram(const std::vector<GLuint> &shaderList)
 		fprintf(stderr, "Linker failure: %s\n", strInfoLog);
 		delete[] strInfoLog;
 	}
+}
+
+//attribute names to give fixed locations before linking, e.g. to keep a rebuilt program's matching existing VAOs
+typedef std::vector<std::pair<GLint, string>> AttributeLocations;
+
+//checkStatus false returns as soon as the link is issued, without waiting to see if it worked
+GLuint createProgram(const std::vector<GLuint> &shaderList, bool checkStatus = true,
+                     const AttributeLocations &attributeLocations = AttributeLocations())
+{
+	GLuint program = glCreateProgram();
+
+	for (size_t iLoop = 0; iLoop < shaderList.size(); iLoop++)
+		glAttachShader(program, shaderList[iLoop]);
+
+	for (const auto &attribute : attributeLocations)
+		if (attribute.first >= 0)
+			glBindAttribLocation(program, attribute.first, attribute.second.c_str());
+
+	//keep the linked binary so it can go into the program cache
+	if (GLEW_ARB_get_program_binary)
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	glLinkProgram(program);
+
+	if (checkStatus)
+		reportProgramErrors(program);
 
 	for (size_t iLoop = 0; iLoop < shaderList.size(); iLoop++)
 		glDetachShader(program, shaderList[iLoop]);
@@ -452,15 +543,49 @@ GLuint createProgram(const std::vector<GLuint> &shaderList)
 }
 // end::createProgram[]
 
-// tag::initializeProgram[]
-void initializeProgram()
+// tag::buildProgram[]
+//a program from the vertex and fragment shader files - from the program cache if these sources have
+//been linked on this driver before, otherwise compiled, linked and added to the cache
+GLuint buildProgram(const string &name, const string &vertexShaderFile, const string &fragmentShaderFile)
 {
-	std::vector<GLuint> shaderList;
+	auto start = high_resolution_clock::now();
+
+	AssetView vertexShaderText = loadAsset(vertexShaderFile);
+	AssetView fragmentShaderText = loadAsset(fragmentShaderFile);
+	std::vector<ShaderSource> sources;
+	ShaderSource vertexShader = { GL_VERTEX_SHADER, (const char *)vertexShaderText.data, (GLint)vertexShaderText.size };
+	ShaderSource fragmentShader = { GL_FRAGMENT_SHADER, (const char *)fragmentShaderText.data, (GLint)fragmentShaderText.size };
+	sources.push_back(vertexShader);
+	sources.push_back(fragmentShader);
+
+	uint64_t key = programCache.key(sources);
+	GLuint program = programCache.load(name, key);
+	if (program != 0)
+		cout << "GLSL program " << name << " loaded from the program cache\n";
+	else
+	{
+		std::vector<GLuint> shaderList;
+		for (const ShaderSource &shader : sources)
+			shaderList.push_back(createShader(shader));
+		program = createProgram(shaderList);
+		for_each(shaderList.begin(), shaderList.end(), glDeleteShader);
+		programsCompiled++;
+
+		GLint status;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status == GL_TRUE && programCache.store(name, key, program))
+			cout << "GLSL program " << name << " compiled and added to the program cache\n";
+	}
 
-	shaderList.push_back(createShader(GL_VERTEX_SHADER, loadShader("vertexShader.glsl")));
-	shaderList.push_back(createShader(GL_FRAGMENT_SHADER, loadShader("fragmentShader.glsl")));
+	programMilliseconds += duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.0;
+	return program;
+}
+// end::buildProgram[]
 
-	theProgram = createProgram(shaderList);
+// tag::initializeProgram[]
+void initializeProgram()
+{
+	theProgram = buildProgram("program", "vertexShader.glsl", "fragmentShader.glsl");
 	if (theProgram == 0)
 	{
 		cerr << "GLSL program creation error." << std::endl;
@@ -474,75 +599,209 @@ void initializeProgram()
 	// tag::glGetAttribLocation[]
 	positionLocation = glGetAttribLocation(theProgram, "position");
 	vertexColorLocation = glGetAttribLocation(theProgram, "vertexColor");
+	texCoordLocation = glGetAttribLocation(theProgram, "texCoord");
 	// end::glGetAttribLocation[]
 
 	// tag::glGetUniformLocation[]
 	modelMatrixLocation = glGetUniformLocation(theProgram, "modelMatrix");
-	viewMatrixLocation = glGetUniformLocation(theProgram, "viewMatrix");
-	projectionMatrixLocation = glGetUniformLocation(theProgram, "projectionMatrix");
+	transparentPassLocation = glGetUniformLocation(theProgram, "transparentPass");
+	GLuint cameraBlock = glGetUniformBlockIndex(theProgram, "Camera");
 
 	//only generates runtime code in debug mode
 	SDL_assert_release( modelMatrixLocation != -1);
-	SDL_assert_release( viewMatrixLocation != -1);
-	SDL_assert_release( projectionMatrixLocation != -1);
+	SDL_assert_release( cameraBlock != GL_INVALID_INDEX);
 	// end::glGetUniformLocation[]
 
-	//clean up shaders (we don't need them anymore as they are no in theProgram
-	for_each(shaderList.begin(), shaderList.end(), glDeleteShader);
+	glUniformBlockBinding(theProgram, cameraBlock, CAMERA_BINDING);
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignment);
 }
 // end::initializeProgram[]
 
-// tag::initializeVertexArrayObject[]
-//setup a GL object (a VertexArrayObject) that stores how to access data and from where
-void initializeVertexArrayObject()
+// tag::reloadProgram[]
+void endProgramReload()
 {
-	glGenVertexArrays(1, &paddleVertexArrayObject); //create a Vertex Array Object
-	cout << "Vertex Array Object created OK! GLUint is: " << paddleVertexArrayObject << std::endl;
+	for_each(programReload.shaders.begin(), programReload.shaders.end(), glDeleteShader);
+	if (programReload.fence != 0)
+		glDeleteSync(programReload.fence);
+	programReload = ProgramReload();
+}
 
-	glGenVertexArrays(1, &worldBoundsVertexArrayObject); //create a Vertex Array Object
-	cout << "World bounds Vertex Array Object created OK! GLUint is: " << worldBoundsVertexArrayObject << std::endl;
+//issue the compile and link of programReload's sources, without waiting for either
+void buildProgramReload()
+{
+	for (const ShaderSource &shader : programReload.sources)
+		programReload.shaders.push_back(createShader(shader, false));
+
+	//the attributes keep their locations, so every VAO set up for the old program still works
+	AttributeLocations attributes;
+	attributes.push_back(std::make_pair(positionLocation, string("position")));
+	attributes.push_back(std::make_pair(vertexColorLocation, string("vertexColor")));
+	if (texCoordLocation != -1)
+		attributes.push_back(std::make_pair(texCoordLocation, string("texCoord")));
+	programReload.program = createProgram(programReload.shaders, false, attributes);
+}
 
-	glGenVertexArrays(1, &ballVertexArrayObject); //create a Vertex Array Object
-	cout << "Ball Vertex Array Object created OK! GLUint is: " << ballVertexArrayObject << std::endl;
+//the compile thread: builds each queued reload on compileContext, and waits for the link there instead
+void compileLoop()
+{
+	if (SDL_GL_MakeCurrent(win, compileContext) != 0)
+	{
+		cerr << "\nCould not use the shared OpenGL context, shaders won't reload: " << SDL_GetError() << endl;
+		return;
+	}
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(compileMutex);
+			compileWake.wait(lock, [] { return compileStopping || compileState == COMPILE_QUEUED; });
+			if (compileStopping)
+				break;
+		}
 
-	glGenVertexArrays(1, &scoreVertexArrayObject); //create a Vertex Array Object
-	cout << "Score Vertex Array Object created OK! GLUint is: " << scoreVertexArrayObject << std::endl;
+		buildProgramReload();
+		GLint status;
+		glGetProgramiv(programReload.program, GL_LINK_STATUS, &status); //the wait for the link, here rather than on the render thread
+		programReload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush(); //so the fence can signal without this context doing anything more
 
-	glBindVertexArray(paddleVertexArrayObject); //make the just created vertexArrayObject the active one
+		std::lock_guard<std::mutex> lock(compileMutex);
+		compileState = COMPILE_DONE;
+	}
+	SDL_GL_MakeCurrent(win, nullptr);
+}
 
-		glBindBuffer(GL_ARRAY_BUFFER, paddleVertexDataBufferObject); //bind vertexDataBufferObject
+//read the shader files as they are now and start building them, on the driver's threads or the compile thread
+void startProgramReload()
+{
+	if (programReload.program != 0) //saved again before the last save finished building
+	{
+		glDeleteProgram(programReload.program);
+		endProgramReload();
+	}
 
-		glEnableVertexAttribArray(positionLocation); //enable attribute at index positionLocation
-		glEnableVertexAttribArray(vertexColorLocation); //enable attribute at index vertexColorLocation
+	programReload.start = high_resolution_clock::now();
+	programReload.text[0] = loadShader("vertexShader.glsl");
+	programReload.text[1] = loadShader("fragmentShader.glsl");
+	ShaderSource vertexShader = { GL_VERTEX_SHADER, programReload.text[0].data(), (GLint)programReload.text[0].size() };
+	ShaderSource fragmentShader = { GL_FRAGMENT_SHADER, programReload.text[1].data(), (GLint)programReload.text[1].size() };
+	programReload.sources.push_back(vertexShader);
+	programReload.sources.push_back(fragmentShader);
 
-		// tag::glVertexAttribPointer[]
-		glVertexAttribPointer(positionLocation,    3, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *) (0 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index positionLocation
-		glVertexAttribPointer(vertexColorLocation, 4, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *) (3 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index vertexColorLocation
-		// end::glVertexAttribPointer[]
+	if (parallelShaderCompile)
+	{
+		buildProgramReload();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(compileMutex);
+		compileState = COMPILE_QUEUED;
+	}
+	compileWake.notify_one();
+}
 
-	glBindVertexArray(worldBoundsVertexArrayObject); //make the just created vertexArrayObject the active one
+//whether the compile thread has programReload - it can't be given up part way, so a new save waits for it
+bool compileBusy()
+{
+	std::lock_guard<std::mutex> lock(compileMutex);
+	return compileState != COMPILE_IDLE;
+}
 
-		glBindBuffer(GL_ARRAY_BUFFER, worldBoundsVertexDataBufferObject); //bind vertexDataBufferObject
+//once the reload has linked, swap it in - call between frames, so every draw of a frame uses one program
+void finishProgramReload()
+{
+	if (parallelShaderCompile)
+	{
+		if (programReload.program == 0)
+			return;
+
+		//asking for the link status waits for the link, so only ask once it's done
+		GLint complete = GL_FALSE;
+		glGetProgramiv(programReload.program, GL_COMPLETION_STATUS_ARB, &complete);
+		if (complete == GL_FALSE)
+			return;
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(compileMutex);
+			if (compileState != COMPILE_DONE)
+				return;
+		}
 
-		glEnableVertexAttribArray(positionLocation); //enable attribute at index positionLocation
-		glEnableVertexAttribArray(vertexColorLocation); //enable attribute at index vertexColorLocation
+		//linked on the compile thread, and once the fence has passed the program is ready to use here
+		GLenum wait = glClientWaitSync(programReload.fence, 0, 0);
+		if (wait != GL_ALREADY_SIGNALED && wait != GL_CONDITION_SATISFIED)
+			return;
+		std::lock_guard<std::mutex> lock(compileMutex);
+		compileState = COMPILE_IDLE;
+	}
 
-		// tag::glVertexAttribPointer[]
-		glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *)(0 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index positionLocation
-		glVertexAttribPointer(vertexColorLocation, 4, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *)(3 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index vertexColorLocation
-		// end::glVertexAttribPointer[]
+	GLuint program = programReload.program;
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	GLint newModelMatrixLocation = glGetUniformLocation(program, "modelMatrix");
+	GLuint newCameraBlock = glGetUniformBlockIndex(program, "Camera");
+	if (status == GL_FALSE || newModelMatrixLocation == -1 || newCameraBlock == GL_INVALID_INDEX)
+	{
+		for (size_t i = 0; i < programReload.shaders.size(); i++)
+			reportShaderErrors(programReload.shaders[i], programReload.sources[i].type);
+		reportProgramErrors(program);
+		cerr << "\nShader reload failed" << (status == GL_FALSE ? "" : " - the program must use modelMatrix and the Camera block")
+		     << ", keeping the previous program" << endl;
+		glDeleteProgram(program);
+		endProgramReload();
+		return;
+	}
 
-	glBindVertexArray(ballVertexArrayObject); //make the just created vertexArrayObject the active one
+	glDeleteProgram(theProgram);
+	theProgram = program;
+	modelMatrixLocation = newModelMatrixLocation;
+	glUniformBlockBinding(program, newCameraBlock, CAMERA_BINDING);
+	transparentPassLocation = glGetUniformLocation(program, "transparentPass");
+	programCache.store("program", programCache.key(programReload.sources), program); //so the next launch starts with it
 
-		glBindBuffer(GL_ARRAY_BUFFER, ballVertexDataBufferObject); //bind vertexDataBufferObject
+	printf("\nShaders reloaded in %.1f ms\n",
+	       duration_cast<microseconds>(high_resolution_clock::now() - programReload.start).count() / 1000.0);
+	endProgramReload();
+}
 
-		glEnableVertexAttribArray(positionLocation); //enable attribute at index positionLocation
-		glEnableVertexAttribArray(vertexColorLocation); //enable attribute at index vertexColorLocation
+void reloadShaders()
+{
+	if (shaderWatcher.changed())
+		reloadWanted = true;
+	if (reloadWanted && (parallelShaderCompile || !compileBusy()))
+	{
+		reloadWanted = false;
+		startProgramReload();
+	}
+	finishProgramReload();
+}
+// end::reloadProgram[]
 
-		// tag::glVertexAttribPointer[]
-		glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *)(0 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index positionLocation
-		glVertexAttribPointer(vertexColorLocation, 4, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *)(3 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index vertexColorLocation
-		// end::glVertexAttribPointer[]
+// tag::initializeText[]
+void initializeText()
+{
+	GLuint textProgram = buildProgram("text", "textVertexShader.glsl", "textFragmentShader.glsl");
+
+	string error;
+	AssetView font = fontChosen ? loadAsset(fontPath) : loadAsset("font.ttf", fontPath);
+	hudTextReady = hudText.initialise(font, fontPath, FONT_SIZE, textProgram, streamBuffer, error);
+	if (hudTextReady)
+		cout << "HUD font " << fontPath << " rasterised into glyph atlas OK!\n";
+	else
+	{
+		cerr << error << " - drawing scores without text (use --font <file.ttf>)" << endl;
+		glDeleteProgram(textProgram);
+	}
+}
+// end::initializeText[]
+
+// tag::initializeVertexArrayObject[]
+//setup a GL object (a VertexArrayObject) that stores how to access data and from where
+void initializeVertexArrayObject()
+{
+	glGenVertexArrays(1, &scoreVertexArrayObject); //create a Vertex Array Object
+	cout << "Score Vertex Array Object created OK! GLUint is: " << scoreVertexArrayObject << std::endl;
 
 	glBindVertexArray(scoreVertexArrayObject); //make the just created vertexArrayObject the active one
 
@@ -551,10 +810,10 @@ void initializeVertexArrayObject()
 		glEnableVertexAttribArray(positionLocation); //enable attribute at index positionLocation
 		glEnableVertexAttribArray(vertexColorLocation); //enable attribute at index vertexColorLocation
 
-														// tag::glVertexAttribPointer[]
-		glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *)(0 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index positionLocation
-		glVertexAttribPointer(vertexColorLocation, 4, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *)(3 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index vertexColorLocation
-																																	// end::glVertexAttribPointer[]
+		// tag::glVertexAttribPointer[]
+		glVertexAttribPointer(positionLocation,    3, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *) (0 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index positionLocation
+		glVertexAttribPointer(vertexColorLocation, 4, GL_FLOAT, GL_FALSE, (7 * sizeof(GL_FLOAT)), (GLvoid *) (3 * sizeof(GLfloat))); //specify that position data contains four floats per vertex, and goes into attribute index vertexColorLocation
+		// end::glVertexAttribPointer[]
 
 	glBindVertexArray(0); //unbind the vertexArrayObject so we can't change it
 
@@ -565,29 +824,76 @@ void initializeVertexArrayObject()
 }
 // end::initializeVertexArrayObject[]
 
-// tag::initializeVertexBuffer[]
-void initializeVertexBuffer()
+// tag::initializeMeshes[]
+//how far the import-time passes (MeshOptimizer.h) cut vertex shader runs per triangle (ACMR) and per vertex (ATVR)
+void printMeshReport(const string &name, const MeshReport &report)
 {
-	glGenBuffers(1, &paddleVertexDataBufferObject);
+	string lods;
+	for (int triangles : report.lodTriangles)
+		lods += (lods.empty() ? "" : "/") + std::to_string(triangles);
+	printf("Model %s optimized: %d triangles, %d vertices - ACMR %.3f -> %.3f, ATVR %.3f -> %.3f - LODs %s\n", name.c_str(),
+	       report.triangles, report.vertices, report.imported.acmr, report.optimized.acmr, report.imported.atvr,
+	       report.optimized.atvr, lods.c_str());
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, paddleVertexDataBufferObject);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(paddleVertexData), paddleVertexData, GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	cout << "vertexDataBufferObject created OK! GLUint is: " << paddleVertexDataBufferObject << std::endl;
+//models/<name>.obj - packed, cached or imported - with its texture, if it has one, requested from the streamer
+void loadModel(const string &name, Mesh &mesh, int &texture, const string &cacheDirectory, int &fromCacheCount)
+{
+	AssetView packed = assetPack.find("models/" + name + ".mesh");
+	if (packed && uploadMeshCache(packed, positionLocation, vertexColorLocation, texCoordLocation, mesh))
+		fromCacheCount++;
+	else
+	{
+		string error;
+		bool fromCache;
+		MeshReport report;
+		if (!loadMesh("models/" + name + ".obj", cacheDirectory, positionLocation, vertexColorLocation, texCoordLocation, mesh,
+		              fromCache, error, &report))
+		{
+			cerr << "Model could not be loaded - " << error << endl;
+			SDL_Quit();
+			exit(1);
+		}
+		if (fromCache)
+			fromCacheCount++;
+		else
+			printMeshReport(name, report);
+	}
+
+	if (!mesh.texture.empty())
+		texture = textureStreamer.request("models/" + mesh.texture);
+}
 
-	glGenBuffers(1, &worldBoundsVertexDataBufferObject);
+void initializeMeshes()
+{
+	auto start = high_resolution_clock::now();
 
-	glBindBuffer(GL_ARRAY_BUFFER, worldBoundsVertexDataBufferObject);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(worldBoundsVertexData), worldBoundsVertexData, GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	cout << "World Bounds vertexDataBufferObject created OK! GLUint is: " << worldBoundsVertexDataBufferObject << std::endl;
+	char *cachePath = SDL_GetPrefPath("Pong", "MeshCache");
+	string cacheDirectory = cachePath ? cachePath : "";
+	SDL_free(cachePath);
 
-	glGenBuffers(1, &ballVertexDataBufferObject);
+	int fromCache = 0;
+	loadModel("paddle", paddleMesh, paddleTexture, cacheDirectory, fromCache);
+	loadModel("wall", wallMesh, wallTexture, cacheDirectory, fromCache);
+	loadModel("ball", ballMesh, ballTexture, cacheDirectory, fromCache);
 
-	glBindBuffer(GL_ARRAY_BUFFER, ballVertexDataBufferObject);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(ballVertexData), ballVertexData, GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	cout << "Ball vertexDataBufferObject created OK! GLUint is: " << ballVertexDataBufferObject << std::endl;
+	printf("Models loaded in %.1f ms (%d from the mesh cache or asset pack, %d imported)\n",
+	       duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.0, fromCache, 3 - fromCache);
+}
+// end::initializeMeshes[]
+
+// tag::initializeVertexBuffer[]
+void initializeVertexBuffer()
+{
+	if (!textureStreamer.initialise(assetPack, textureBudget))
+	{
+		cerr << "Texture streamer creation error." << std::endl;
+		SDL_Quit();
+		exit(1);
+	}
+	cout << "Texture streamer created OK! Uploading up to " << textureBudget / 1024 << "KB of textures a frame\n";
+
+	initializeMeshes();
 
 	glGenBuffers(1, &scoreVertexDataBufferObject);
 
@@ -596,92 +902,432 @@ void initializeVertexBuffer()
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	cout << "Score vertexDataBufferObject created OK! GLUint is: " << scoreVertexDataBufferObject << std::endl;
 
+	if (!streamBuffer.initialise(STREAM_BUFFER_SIZE))
+	{
+		cerr << "Stream buffer creation error." << std::endl;
+		SDL_Quit();
+		exit(1);
+	}
+	cout << "Stream buffer of " << STREAM_BUFFER_SIZE / 1024 << "KB created OK! "
+	     << (streamBuffer.isPersistent() ? "Persistently mapped" : "Mapped unsynchronized per allocation") << std::endl;
+
+	debugDraw.initialise(streamBuffer, positionLocation, vertexColorLocation);
+
 	initializeVertexArrayObject();
 }
 // end::initializeVertexBuffer[]
 
-// tag::loadAssets[]
-void loadAssets()
+// tag::renderScale[]
+//the scene's share of the window at the current render scale, never less than a pixel
+int sceneWidth()
 {
-	initializeProgram(); //create GLSL Shaders, link into a GLSL program, and get IDs of attributes and variables
+	return max(1, (int)(windowWidth * renderScale));
+}
 
-	initializeVertexBuffer(); //load data into a vertex buffer
+int sceneHeight()
+{
+	return max(1, (int)(windowHeight * renderScale));
+}
 
-	cout << "Loaded Assets OK!\n";
+void setRenderScale(float scale)
+{
+	renderScale = std::min(1.0f, std::max(MIN_RENDER_SCALE, scale));
+}
 
-	timePrev = high_resolution_clock::now(); // set the last time
+void updateWindowSize()
+{
+	SDL_GL_GetDrawableSize(win, &windowWidth, &windowHeight);
+	windowWidth = max(1, windowWidth); //0 while minimised
+	windowHeight = max(1, windowHeight);
 }
-// end::loadAssets[]
+// end::renderScale[]
 
-// tag::handleInput[]
-void handleInput()
+// tag::resizeSceneTargets[]
+//(re)allocate the scene framebuffer and the transparent pass's targets at the window's size
+void resizeSceneTargets()
 {
-	//Event-based input handling
-	//The underlying OS is event-based, so **each** key-up or key-down (for example)
-	//generates an event.
-	//  - https://wiki.libsdl.org/SDL_PollEvent
-	//In some scenarios we want to catch **ALL** the events, not just to present state
-	//  - for instance, if taking keyboard input the user might key-down two keys during a frame
-	//    - we want to catch based, and know the order
-	//  - or the user might key-down and key-up the same within a frame, and we still want something to happen (e.g. jump)
-	//  - the alternative is to Poll the current state with SDL_GetKeyboardState
+	glBindRenderbuffer(GL_RENDERBUFFER, sceneColorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, windowWidth, windowHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, sceneDepthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, windowWidth, windowHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	sceneTransparency.destroy();
+	string error;
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+		error = "the scene framebuffer is incomplete";
+	if (status != GL_FRAMEBUFFER_COMPLETE || !sceneTransparency.initialise(windowWidth, windowHeight, sceneDepthRenderbuffer, transparencyProgram, error))
+	{
+		cerr << "Scene targets could not be created at " << windowWidth << "x" << windowHeight << " - " << error << endl;
+		SDL_Quit();
+		exit(1);
+	}
+}
+// end::resizeSceneTargets[]
 
-	SDL_Event event; //somewhere to store an event
+// tag::initializeTransparency[]
+//the window's opaque pass goes into sceneFramebuffer, whose depth the transparent pass tests against
+void initializeTransparency()
+{
+	transparencyProgram = buildProgram("transparency", "transparencyVertexShader.glsl", "transparencyFragmentShader.glsl");
+
+	glGenRenderbuffers(1, &sceneColorRenderbuffer);
+	glGenRenderbuffers(1, &sceneDepthRenderbuffer);
+	glGenFramebuffers(1, &sceneFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, sceneColorRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, sceneDepthRenderbuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	resizeSceneTargets();
+	cout << "Transparency pass (weighted blended OIT) created OK!\n";
+}
+// end::initializeTransparency[]
 
-	//NOTE: there may be multiple events per frame
-	while (SDL_PollEvent(&event)) //loop until SDL_PollEvent returns 0 (meaning no more events)
+// tag::gpuTimers[]
+void initializeGpuTimers()
+{
+	gpuTiming = GpuTimer::supported();
+	if (!gpuTiming)
 	{
-		switch (event.type)
-		{
-		case SDL_QUIT:
-			done = true; //set donecreate remote branch flag if SDL wants to quit (i.e. if the OS has triggered a close event,
-							//  - such as window close, or SIGINT
-			break;
+		cout << "No timer queries - GPU time won't be shown\n";
+		return;
+	}
+	for (GpuTimer &timer : gpuTimers)
+		timer.initialise();
+	cout << "GPU timers created OK!\n";
+}
 
-			//keydown handling - we should to the opposite on key-up for direction controls (generally)
-		case SDL_KEYDOWN:
-			//Keydown can fire repeatable if key-repeat is on.
-			//  - the repeat flag is set on the keyboard event, if this is a repeat event
-			//  - in our case, we're going to ignore repeat events
-			//  - https://wiki.libsdl.org/SDL_KeyboardEvent
-			if (!event.key.repeat)
-				switch (event.key.keysym.sym)
-				{
-					//hit escape to exit
-					case SDLK_ESCAPE: done = true;
-						break;
-					case SDLK_a:
-						paddle2Direction -= 1.0;
-						break;
-					case SDLK_s:
-						paddle2Direction += 1.0;
-						break;
-					case SDLK_LEFT:
-						paddle1Direction -= 1.0;
-						break;
-					case SDLK_RIGHT:
-						paddle1Direction += 1.0;
-						break;
-					case SDLK_c:
-						changeCamera = true;
-						break;
-				}
-			break;
-		case SDL_KEYUP:
+void beginGpuTimer(GpuPass pass)
+{
+	if (gpuTiming)
+		gpuTimers[pass].begin();
+}
+
+void endGpuTimer(GpuPass pass)
+{
+	if (gpuTiming)
+		gpuTimers[pass].end();
+}
+
+//close this frame's spans, once they've all been issued
+void endGpuFrames()
+{
+	if (gpuTiming)
+		for (GpuTimer &timer : gpuTimers)
+			timer.endFrame();
+}
+
+//read back whichever frames' timer queries have finished, without waiting for any
+void pollGpuTimers()
+{
+	if (!gpuTiming)
+		return;
+	for (int pass = 0; pass < GPU_PASSES; pass++)
+	{
+		double milliseconds;
+		int frames = gpuTimers[pass].poll(milliseconds);
+		if (frames == 0)
+			continue;
+		frameStats.gpuMilliseconds[pass] += milliseconds;
+		frameStats.gpuFrames[pass] += frames;
+		if (pass == GPU_SCENE)
+			sceneMilliseconds = milliseconds / frames; //the controller takes one measurement a frame
+	}
+}
+// end::gpuTimers[]
+
+// tag::initializeResolution[]
+void initializeResolution()
+{
+	if (!dynamicResolution)
+		return;
+
+	resolutionConfig.minScale = MIN_RENDER_SCALE;
+	resolution = ResolutionController(resolutionConfig, renderScale);
+	setRenderScale(resolution.scale());
+	if (!resolutionLogPath.empty())
+	{
+		resolutionLog.open(resolutionLogPath);
+		if (resolutionLog)
+			resolutionLog << "measurement,milliseconds,average,scale,timer\n";
+		else
+			cerr << "Could not open " << resolutionLogPath << " - not logging the render scale" << endl;
+	}
+	cout << "Dynamic resolution holding the scene to " << resolutionConfig.budgetMilliseconds << " ms, timed on the "
+	     << (gpuTiming ? "GPU" : "CPU") << " OK!\n";
+}
+// end::initializeResolution[]
+
+// tag::sceneTiming[]
+//around everything in the scene that scales with the render scale
+void beginSceneTiming()
+{
+	if (gpuTiming)
+		beginGpuTimer(GPU_SCENE);
+	else if (dynamicResolution)
+		sceneCpuStart = high_resolution_clock::now();
+}
+
+void endSceneTiming()
+{
+	if (gpuTiming)
+		endGpuTimer(GPU_SCENE);
+	else if (dynamicResolution)
+	{
+		// without timer queries, time to when the scene is finished - on a software renderer, where
+		// this matters most, the waiting is the rendering
+		glFinish();
+		sceneMilliseconds = duration_cast<microseconds>(high_resolution_clock::now() - sceneCpuStart).count() / 1000.0;
+	}
+}
+
+//feed the scene's latest timing, if there's a new one, to the controller, which picks the scale to draw the next frame at
+void updateRenderScale()
+{
+	double milliseconds = sceneMilliseconds;
+	if (milliseconds < 0)
+		return;
+	sceneMilliseconds = -1;
+	frameStats.sceneMilliseconds += milliseconds;
+	frameStats.sceneTimings++;
+	if (!dynamicResolution)
+		return;
+
+	setRenderScale(resolution.update(milliseconds));
+	if (resolutionLog.is_open())
+		resolutionLog << resolution.getStats().measurements << "," << milliseconds << "," << resolution.getStats().averageMilliseconds
+		              << "," << renderScale << "," << (gpuTiming ? "gpu" : "cpu") << "\n";
+}
+// end::sceneTiming[]
+
+// tag::buildAssetPack[]
+//--build-pack <file>: everything loadAssets reads, in one asset pack - the models imported and preprocessed
+//into mesh caches, everything else (including the models' textures) as it is
+bool addFileToPack(std::vector<PackEntry> &entries, const string &name, const string &path)
+{
+	MappedFile file;
+	if (!file.open(path))
+	{
+		cerr << "Could not read " << path << " for the asset pack" << endl;
+		return false;
+	}
+	PackEntry entry;
+	entry.name = name;
+	entry.bytes.assign((const char *)file.data(), file.size());
+	entries.push_back(entry);
+	return true;
+}
+
+bool buildAssetPack(const string &path)
+{
+	std::vector<PackEntry> entries;
+	bool complete = addFileToPack(entries, "vertexShader.glsl", "vertexShader.glsl") &&
+	                addFileToPack(entries, "fragmentShader.glsl", "fragmentShader.glsl") &&
+	                addFileToPack(entries, "textVertexShader.glsl", "textVertexShader.glsl") &&
+	                addFileToPack(entries, "textFragmentShader.glsl", "textFragmentShader.glsl") &&
+	                addFileToPack(entries, "transparencyVertexShader.glsl", "transparencyVertexShader.glsl") &&
+	                addFileToPack(entries, "transparencyFragmentShader.glsl", "transparencyFragmentShader.glsl");
+
+	const char *MODEL_NAMES[] = { "paddle", "wall", "ball" };
+	string error;
+	for (const char *model : MODEL_NAMES)
+	{
+		PackEntry entry;
+		entry.name = string("models/") + model + ".mesh";
+		MeshReport report;
+		if (complete && !buildMeshCache(string("models/") + model + ".obj", entry.bytes, error, &report))
+		{
+			cerr << error << endl;
+			complete = false;
+		}
+		else if (complete)
+			printMeshReport(model, report);
+		AssetView cache;
+		cache.data = (const uint8_t *)entry.bytes.data();
+		cache.size = entry.bytes.size();
+		string texture = meshCacheTexture(cache);
+		entries.push_back(entry);
+		if (complete && !texture.empty())
+			complete = addFileToPack(entries, "models/" + texture, "models/" + texture);
+	}
+
+	//without the font the pack still works, with the font read from its usual place
+	if (complete && !addFileToPack(entries, "font.ttf", fontPath))
+		cerr << "Packing without a font" << endl;
+
+	if (complete && writeAssetPack(path, entries, error))
+	{
+		cout << "Asset pack of " << entries.size() << " assets written to " << path << endl;
+		return true;
+	}
+	if (complete)
+		cerr << error << endl;
+	return false;
+}
+// end::buildAssetPack[]
+
+// tag::loadAssets[]
+void loadAssets()
+{
+	auto start = high_resolution_clock::now();
+
+	if (!assetPackPath.empty())
+	{
+		string error;
+		if (!assetPack.open(assetPackPath, error))
+		{
+			cerr << error << endl;
+			SDL_Quit();
+			exit(1);
+		}
+		cout << "Asset pack " << assetPackPath << " of " << assetPack.count() << " assets mapped OK!\n";
+	}
+
+	//binaries are kept in SDL's per-user writable directory for the game
+	char *cachePath = programCacheEnabled ? SDL_GetPrefPath("Pong", "ProgramCache") : nullptr;
+	programCache.initialise(cachePath ? cachePath : "");
+	SDL_free(cachePath);
+	if (programCacheEnabled && !programCache.enabled())
+		cout << "Program cache unavailable - the driver can't save program binaries\n";
+
+	initializeProgram(); //create GLSL Shaders, link into a GLSL program, and get IDs of attributes and variables
+
+	parallelShaderCompile = GLEW_ARB_parallel_shader_compile != 0;
+	if (parallelShaderCompile)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF); //as many threads as the driver likes
+	else
+	{
+		//the driver would compile on this thread, so give it another: a context shared with this one, made now as
+		//creating it makes it current, and a thread to make it current on
+		SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+		compileContext = SDL_GL_CreateContext(win);
+		SDL_GL_MakeCurrent(win, context);
+		if (compileContext != nullptr)
+		{
+			compileThread = std::thread(compileLoop);
+			cout << "Created shared OpenGL context for shader reloads OK!\n";
+		}
+		else
+			cout << "Not watching the shaders - without parallel compile reloading needs a shared context: " << SDL_GetError() << "\n";
+	}
+	if (parallelShaderCompile || compileContext != nullptr)
+	{
+		std::vector<string> shaderFiles;
+		shaderFiles.push_back("vertexShader.glsl");
+		shaderFiles.push_back("fragmentShader.glsl");
+		if (shaderWatcher.watch("", shaderFiles))
+			cout << "Watching the shaders for changes OK!\n";
+	}
+
+	initializeVertexBuffer(); //load data into a vertex buffer
+
+	initializeText(); //rasterise the HUD font into a glyph atlas
+
+	initializeTransparency(); //the scene framebuffer and the translucent models' accumulation targets
+
+	initializeGpuTimers(); //per-pass GPU time, where there are timer queries
+
+	initializeResolution(); //the dynamic resolution controller, if there's a budget
+
+	looseAssets.clear(); //everything has been copied into GL and the glyph atlas
+
+	printf("Loaded Assets OK! in %.1f ms - GLSL programs %.1f ms (%d from the program cache, %d compiled)\n",
+	       duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.0, programMilliseconds,
+	       programCache.hits(), programsCompiled);
+
+	timePrev = high_resolution_clock::now(); // set the last time
+}
+// end::loadAssets[]
+
+// tag::handleInput[]
+void handleInput()
+{
+	//Event-based input handling
+	//The underlying OS is event-based, so **each** key-up or key-down (for example)
+	//generates an event.
+	//  - https://wiki.libsdl.org/SDL_PollEvent
+	//In some scenarios we want to catch **ALL** the events, not just to present state
+	//  - for instance, if taking keyboard input the user might key-down two keys during a frame
+	//    - we want to catch based, and know the order
+	//  - or the user might key-down and key-up the same within a frame, and we still want something to happen (e.g. jump)
+	//  - the alternative is to Poll the current state with SDL_GetKeyboardState
+
+	SDL_Event event; //somewhere to store an event
+
+	//NOTE: there may be multiple events per frame
+	while (SDL_PollEvent(&event)) //loop until SDL_PollEvent returns 0 (meaning no more events)
+	{
+		switch (event.type)
+		{
+		case SDL_QUIT:
+			done = true; //set donecreate remote branch flag if SDL wants to quit (i.e. if the OS has triggered a close event,
+							//  - such as window close, or SIGINT
+			break;
+
+		case SDL_WINDOWEVENT:
+			//the scene targets follow the window; the projection picks up the new shape next frame
+			if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+			{
+				updateWindowSize();
+				resizeSceneTargets();
+			}
+			break;
+
+			//keydown handling - we should to the opposite on key-up for direction controls (generally)
+		case SDL_KEYDOWN:
+			//Keydown can fire repeatable if key-repeat is on.
+			//  - the repeat flag is set on the keyboard event, if this is a repeat event
+			//  - in our case, we're going to ignore repeat events
+			//  - https://wiki.libsdl.org/SDL_KeyboardEvent
+			if (!event.key.repeat)
+				switch (event.key.keysym.sym)
+				{
+					//hit escape to exit
+					case SDLK_ESCAPE: done = true;
+						break;
+					case SDLK_a:
+						if (!controller2) match.paddle2Direction -= 1.0;
+						break;
+					case SDLK_s:
+						if (!controller2) match.paddle2Direction += 1.0;
+						break;
+					case SDLK_LEFT:
+						if (!controller1) match.paddle1Direction -= 1.0;
+						break;
+					case SDLK_RIGHT:
+						if (!controller1) match.paddle1Direction += 1.0;
+						break;
+					case SDLK_c:
+						changeCamera = true;
+						break;
+					case SDLK_v:
+						splitScreen = !splitScreen;
+						break;
+					case SDLK_F3:
+						debugDrawEnabled = !debugDrawEnabled;
+						break;
+				}
+			break;
+		case SDL_KEYUP:
 			if (!event.key.repeat)
 				switch (event.key.keysym.sym)
 				{
 					case SDLK_a:
-						paddle2Direction += 1.0;
+						if (!controller2) match.paddle2Direction += 1.0;
 						break;
 					case SDLK_s:
-						paddle2Direction -= 1.0;
+						if (!controller2) match.paddle2Direction -= 1.0;
 						break;
 					case SDLK_LEFT:
-						paddle1Direction += 1.0;
+						if (!controller1) match.paddle1Direction += 1.0;
 						break;
 					case SDLK_RIGHT:
-						paddle1Direction -= 1.0;
+						if (!controller1) match.paddle1Direction -= 1.0;
 						break;
 				}
 			break;
@@ -706,42 +1352,23 @@ GLdouble getDelta()
 	return delta;
 }
 
-bool checkSideBounds(GLfloat* value, bool leftSide, const GLfloat ITEM_WIDTH)
+// tag::applyControllers[]
+// set the direction of each paddle that has a controller - a batch of one match
+void applyControllers(FixedMatchState &state)
 {
-	if (leftSide)
+	int direction;
+	if (controller1)
 	{
-		if (*value < (-AREA_WIDTH / 2) + ITEM_WIDTH / 2 + WORLD_BOUNDS_WIDTH / 2)
-		{
-			*value = ((-AREA_WIDTH / 2) + ITEM_WIDTH / 2 + WORLD_BOUNDS_WIDTH / 2);
-			return true;
-		}
-		else
-			return false;
-	}
-	else {
-		if (*value > (AREA_WIDTH / 2) - ITEM_WIDTH / 2 - WORLD_BOUNDS_WIDTH / 2)
-		{
-			*value = ((AREA_WIDTH / 2) - ITEM_WIDTH / 2 - WORLD_BOUNDS_WIDTH / 2);
-			return true;
-		}
-		else
-			return false;
+		controller1->decide(&state, 1, 1, &controllerRandom, &direction);
+		state.paddle1Direction = direction;
 	}
-}
-
-bool checkBallPaddleCollision(const glm::vec3 PADDLE_POSITION)
-{
-	if (PADDLE_POSITION.x - PADDLE_WIDTH / 2 < ballPosition.x + BALL_WIDTH / 2 &&
-		PADDLE_POSITION.x + PADDLE_WIDTH / 2 > ballPosition.x - BALL_WIDTH / 2 &&
-		PADDLE_POSITION.z - PADDLE_DEPTH / 2 < ballPosition.z + BALL_WIDTH / 2 &&
-		PADDLE_POSITION.z + PADDLE_DEPTH / 2 > ballPosition.z - BALL_WIDTH / 2)
+	if (controller2)
 	{
-		return true;
-	}
-	else {
-		return false;
+		controller2->decide(&state, 1, 2, &controllerRandom, &direction);
+		state.paddle2Direction = direction;
 	}
 }
+// end::applyControllers[]
 
 // tag::updateSimulation[]
 void updateSimulation(double simLength = 0.02) //update simulation with an amount of time to simulate for (in seconds)
@@ -752,47 +1379,48 @@ void updateSimulation(double simLength = 0.02) //update simulation with an amoun
 	// get delta time - makes sure that speed is same on all computers
 	GLdouble delta = getDelta();
 
-	// move paddle
-	paddle1Position.x += (paddleVelocity * delta * paddle1Direction);
-
-	// make sure that the paddles can't go out of bounds
-	checkSideBounds(&paddle1Position.x, true, PADDLE_WIDTH);
-	checkSideBounds(&paddle1Position.x, false, PADDLE_WIDTH);
-
-	paddle2Position.x += (paddleVelocity * delta * paddle2Direction);
-
-	checkSideBounds(&paddle2Position.x, true, PADDLE_WIDTH);
-	checkSideBounds(&paddle2Position.x, false, PADDLE_WIDTH);
+	// move the paddles and ball, and keep score
+	if (fixedPointMode)
+	{
+		fixedMatch.paddle1Direction = (int)match.paddle1Direction;
+		fixedMatch.paddle2Direction = (int)match.paddle2Direction;
 
-	// move the ball
-	ballPosition += ballDirection * ballVelocity * (GLfloat)delta;
-	
-	// reverse the direction of the ball if it hits the side wall
-	if (checkSideBounds(&ballPosition.x, false, BALL_WIDTH) || checkSideBounds(&ballPosition.x, true, BALL_WIDTH))
-		ballDirection.x = -ballDirection.x;
+		fixedTickAccumulator += delta;
+		for (int ticks = 0; fixedTickAccumulator >= 1.0 / FIXED_TICK_RATE; ticks++)
+		{
+			if (ticks == MAX_TICKS_PER_FRAME)
+			{
+				fixedTickAccumulator = 0;
+				break;
+			}
+
+			// controllers decide every tick, from the fixed point state so replays stay exact
+			applyControllers(fixedMatch);
+
+			if (replayPath)
+			{
+				TickInput input = { (int8_t)fixedMatch.paddle1Direction, (int8_t)fixedMatch.paddle2Direction };
+				stepAndRecord(replay, fixedMatch, input);
+			}
+			else
+				stepMatchFixed(fixedMatch);
+			fixedTickAccumulator -= 1.0 / FIXED_TICK_RATE;
+		}
 
-	// check for paddle collisions
-	if (checkBallPaddleCollision(paddle1Position) || checkBallPaddleCollision(paddle2Position))
+		toMatchState(fixedMatch, match);
+	}
+	else
 	{
-		if (!isColliding)
+		if (controller1 || controller2)
 		{
-			ballDirection.z = -ballDirection.z;
-			isColliding = true;
+			FixedMatchState decided;
+			fromMatchState(match, decided);
+			applyControllers(decided);
+			match.paddle1Direction = (float)decided.paddle1Direction;
+			match.paddle2Direction = (float)decided.paddle2Direction;
 		}
-	}
-	else {
-		isColliding = false;
-	}
 
-	// check if a player has missed
-	if ((AREA_DEPTH/2 - WORLD_BOUNDS_WIDTH / 2 < ballPosition.z + BALL_WIDTH / 2) || (-AREA_DEPTH/2 + WORLD_BOUNDS_WIDTH / 2 > ballPosition.z - BALL_WIDTH / 2))
-	{
-		if (ballPosition.z < 0)
-			player1Score++;
-		else
-			player2Score++;
-		ballDirection = -ballDirection;
-		ballPosition = glm::vec3(0, 0, 0);
+		stepMatch(match, delta);
 	}
 
 	if (changeCamera)
@@ -813,7 +1441,7 @@ void updateSimulation(double simLength = 0.02) //update simulation with an amoun
 // tag::preRender[]
 void preRender()
 {
-	glViewport(0, 0, 600, 600); //set viewpoint
+	glViewport(0, 0, windowWidth, windowHeight); //set viewpoint
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f); //set clear colour
 	glDepthFunc(GL_LEQUAL);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -827,7 +1455,7 @@ void renderScore()
 	GLfloat xPos = -0.95;
 
 	// PLAYER 1
-	for (int i = 0; i < player1Score; i++)
+	for (int i = 0; i < match.player1Score; i++)
 	{
 		glm::mat4 modelMatrix = glm::mat4(1.0);
 		modelMatrix = glm::translate(modelMatrix, glm::vec3(xPos, -0.95, 0));
@@ -840,7 +1468,7 @@ void renderScore()
 	xPos = -0.95;
 	// PLAYER 2
 	// PLAYER 1
-	for (int i = 0; i < player2Score; i++)
+	for (int i = 0; i < match.player2Score; i++)
 	{
 		glm::mat4 modelMatrix = glm::mat4(1.0);
 		modelMatrix = glm::translate(modelMatrix, glm::vec3(xPos, 0.95, 0));
@@ -852,78 +1480,132 @@ void renderScore()
 
 }
 
-// tag::render[]
-void render()
+// tag::viewMatrixFor[]
+//viewMatrix - how we control the view (viewpoint, view direction, etc)
+glm::mat4 viewMatrixFor(int camera, const MatchState &state)
 {
-	frameLine += "Player 1: " + std::to_string(player1Score) + " Player 2: " + std::to_string(player2Score) + " ";
-
-	glUseProgram(theProgram); //installs the program object specified by program as part of current rendering state
-
-	glBindVertexArray(paddleVertexArrayObject);
-
-	//set projectionMatrix - how we go from 3D to 2D
-	glm::mat4 projectionMatrix = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f); // perspective - makes things further away smaller
-	glUniformMatrix4fv(projectionMatrixLocation, 1, false, glm::value_ptr(projectionMatrix));
-
-	//set viewMatrix - how we control the view (viewpoint, view direction, etc)
-	glm::mat4 viewMatrix;
-	switch (currentCamera)
+	switch (camera)
 	{
 	case 1:
-		viewMatrix = glm::lookAt(glm::vec3(paddle1Position.x, 2, 5), paddle1Position, glm::vec3(0, 1, 0)); // looks at paddle 1
-		break;
+		return glm::lookAt(glm::vec3(state.paddle1Position.x, 2, 5), state.paddle1Position, glm::vec3(0, 1, 0)); // looks at paddle 1
 	case 2:
-		viewMatrix = glm::lookAt(glm::vec3(paddle2Position.x, -2, -5), paddle2Position, glm::vec3(0, -1, 0)); // looks at paddle 2
-		break;
+		return glm::lookAt(glm::vec3(state.paddle2Position.x, -2, -5), state.paddle2Position, glm::vec3(0, -1, 0)); // looks at paddle 2
 	case 3:
-		viewMatrix = glm::lookAt(glm::vec3(7, 3, 4), glm::vec3(0,0,0.5), glm::vec3(0, 1, 0)); // top down view
-		break;
+		return glm::lookAt(glm::vec3(7, 3, 4), glm::vec3(0,0,0.5), glm::vec3(0, 1, 0)); // top down view
 	default:
-		viewMatrix = glm::mat4(1.0);
-		break;
+		return glm::mat4(1.0);
 	}
+}
+// end::viewMatrixFor[]
+
+// tag::camera[]
+// the Camera uniform block's layout (std140)
+struct CameraBlock
+{
+	glm::mat4 viewMatrix;
+	glm::mat4 projectionMatrix;
+};
+
+// write a camera into the stream buffer, to bind with bindCamera any time in the frame; -1 if it
+// doesn't fit
+GLintptr uploadCamera(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix)
+{
+	CameraBlock camera = { viewMatrix, projectionMatrix };
+	return streamBuffer.upload(&camera, sizeof(camera), uniformBufferAlignment);
+}
+
+void bindCamera(GLintptr offset)
+{
+	if (offset >= 0)
+		glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BINDING, streamBuffer.buffer(), offset, sizeof(CameraBlock));
+}
+
+void setCamera(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix)
+{
+	bindCamera(uploadCamera(viewMatrix, projectionMatrix));
+}
+// end::camera[]
+
+// tag::drawList[]
+// the world is laid out as a list of draws once a frame, however many views it's drawn into; each
+// view then only binds its camera and submits the list
+const int MAX_VIEWS = 2;
+
+// one model, with everything about drawing it that doesn't depend on the view
+struct DrawCommand
+{
+	const Mesh *mesh;
+	int texture; // a streamer handle
+	glm::mat4 modelMatrix;
+	float scale; // of the longest side - a stretched model's bounds and error grow with it
+	unsigned views; // a bit for each view that can see it
+	int timer; // the gpuTimers pass its draws add to, -1 for none
+};
+
+// how the draws are being submitted: for the view whose bit is view, through viewMatrix into a
+// viewport viewportHeight pixels high, and either the opaque models or, in the transparent pass,
+// the translucent ones
+struct WorldPass
+{
+	glm::mat4 viewMatrix;
+	float viewportHeight;
+	bool translucent;
+	unsigned view;
+};
+
+std::vector<DrawCommand> worldDraws; // the window's, reused every frame
+std::vector<std::vector<DrawCommand>> pixelEnvDraws; // each pixel env's
+
+void addDraw(std::vector<DrawCommand> &draws, const Mesh &mesh, int texture, const glm::mat4 &modelMatrix, int timer = -1)
+{
+	float scale = max(glm::length(glm::vec3(modelMatrix[0])),
+	                  max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+	DrawCommand draw = { &mesh, texture, modelMatrix, scale, ~0u, timer };
+	draws.push_back(draw);
+}
+// end::drawList[]
 
+// tag::buildWorldDraws[]
+// the paddles, walls and ball of state, visible in every view until cullWorldDraws says otherwise;
+// if timed, the walls and ball are drawn inside their GPU timers
+void buildWorldDraws(const MatchState &state, std::vector<DrawCommand> &draws, bool timed)
+{
+	int boundsTimer = timed ? GPU_WORLD_BOUNDS : -1;
+	int ballTimer = timed ? GPU_BALL : -1;
 
-	glUniformMatrix4fv(viewMatrixLocation, 1, false, glm::value_ptr(viewMatrix));
+	draws.clear();
 
 	// PADDLES ------------------------------------------------------------------------------------
 
 	glm::mat4 modelMatrix = glm::mat4(1.0);
-	modelMatrix = glm::translate(modelMatrix, paddle1Position);
+	modelMatrix = glm::translate(modelMatrix, state.paddle1Position);
 
-	glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(modelMatrix));
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	addDraw(draws, paddleMesh, paddleTexture, modelMatrix);
 
 	modelMatrix = glm::mat4(1.0);
 
-	modelMatrix = glm::translate(modelMatrix, paddle2Position);
+	modelMatrix = glm::translate(modelMatrix, state.paddle2Position);
 
 	// rotate so a different side is showing
 	modelMatrix = glm::rotate(modelMatrix, glm::radians(180.0f), glm::vec3(1, 0, 0));
 
-	glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(modelMatrix));
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	addDraw(draws, paddleMesh, paddleTexture, modelMatrix);
 
 	// WORLD BOUNDS -------------------------------------------------------------------------------
 
-	glDepthMask(GL_FALSE);
-	glBindVertexArray(worldBoundsVertexArrayObject);
-
 	// bottom
 	modelMatrix = glm::mat4(1.0);
 	modelMatrix = glm::translate(modelMatrix, glm::vec3(0,0,AREA_DEPTH/2));
 	modelMatrix *= glm::vec4(4.7, 1, 1, 1);
 
-	glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(modelMatrix));
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	addDraw(draws, wallMesh, wallTexture, modelMatrix, boundsTimer);
 
 	// top
 	modelMatrix = glm::mat4(1.0);
 	modelMatrix = glm::translate(modelMatrix, glm::vec3(0, 0, -AREA_DEPTH/2));
 	modelMatrix *= glm::vec4(4.7, 1, 1, 1);
 
-	glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(modelMatrix));
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	addDraw(draws, wallMesh, wallTexture, modelMatrix, boundsTimer);
 
 	// right
 	modelMatrix = glm::mat4(1.0);
@@ -931,8 +1613,7 @@ void render()
 	modelMatrix = glm::rotate(modelMatrix, glm::radians(-90.0f), glm::vec3(0, 1, 0));
 	modelMatrix *= glm::vec4(1, 1, 12.5, 1);
 
-	glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(modelMatrix));
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	addDraw(draws, wallMesh, wallTexture, modelMatrix, boundsTimer);
 
 	// left
 	modelMatrix = glm::mat4(1.0);
@@ -940,50 +1621,545 @@ void render()
 	modelMatrix = glm::rotate(modelMatrix, glm::radians(90.0f), glm::vec3(0, 1, 0));
 	modelMatrix *= glm::vec4(1, 1, 12.5, 1);
 
-	glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(modelMatrix));
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-
-	glDepthMask(GL_TRUE);
+	addDraw(draws, wallMesh, wallTexture, modelMatrix, boundsTimer);
 
 	// BALL ---------------------------------------------------------------------------------------
 
-	glBindVertexArray(ballVertexArrayObject);
-
 	modelMatrix = glm::mat4(1.0);
-	modelMatrix = glm::translate(modelMatrix, ballPosition);
+	modelMatrix = glm::translate(modelMatrix, state.ballPosition);
 	modelMatrix = glm::rotate(modelMatrix, angle, glm::vec3(1, 1, 1));
 
-	glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(modelMatrix));
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	addDraw(draws, ballMesh, ballTexture, modelMatrix, ballTimer);
 
-	// 2D HUD -------------------------------------------------------------------------------------
+}
+// end::buildWorldDraws[]
 
-	// disable depth testing
-	glDisable(GL_DEPTH_TEST);
+// tag::cullWorldDraws[]
+// mark which of the views (their projection * view matrices) can see each draw, testing its
+// bounding sphere against every view's frustum in one pass over the list
+void cullWorldDraws(std::vector<DrawCommand> &draws, const glm::mat4 *viewProjections, int viewCount)
+{
+	// the frustum planes, pointing inwards, straight from the matrix's rows (Gribb and Hartmann)
+	glm::vec4 planes[MAX_VIEWS][6];
+	for (int view = 0; view < viewCount; view++)
+	{
+		const glm::mat4 &m = viewProjections[view];
+		glm::vec4 rows[4];
+		for (int row = 0; row < 4; row++)
+			rows[row] = glm::vec4(m[0][row], m[1][row], m[2][row], m[3][row]);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			planes[view][axis * 2] = rows[3] + rows[axis];
+			planes[view][axis * 2 + 1] = rows[3] - rows[axis];
+		}
+		for (glm::vec4 &plane : planes[view])
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	for (DrawCommand &draw : draws)
+	{
+		glm::vec3 centre(draw.modelMatrix[3]);
+		float radius = draw.mesh->radius * draw.scale;
+		draw.views = 0;
+		for (int view = 0; view < viewCount; view++)
+		{
+			bool inside = true;
+			for (const glm::vec4 &plane : planes[view])
+				inside = inside && glm::dot(glm::vec3(plane), centre) + plane.w >= -radius;
+			if (inside)
+				draw.views |= 1u << view;
+		}
+		if (draw.views == 0)
+			frameStats.culled++;
+	}
+}
+// end::cullWorldDraws[]
 
-	glBindVertexArray(scoreVertexArrayObject);
+// tag::submitWorldDraws[]
+// the draws in pass's view that belong in pass, each at the coarsest level of detail whose error
+// covers at most lodPixelError pixels, judged at the model's centre - theProgram must be in use,
+// with the view's camera bound, and for the translucent models a TransparencyPass begun
+void submitWorldDraws(const std::vector<DrawCommand> &draws, const WorldPass &pass)
+{
+	glUniform1i(transparentPassLocation, pass.translucent);
 
-	// Reset all the matrices to identity matrix
-	projectionMatrix = glm::mat4(1.0);
-	glUniformMatrix4fv(projectionMatrixLocation, 1, false, glm::value_ptr(projectionMatrix));
+	int timer = -1; // running over the draws since it changed
+	for (const DrawCommand &draw : draws)
+	{
+		const Mesh &mesh = *draw.mesh;
+		if (mesh.translucent != pass.translucent || !(draw.views & pass.view))
+			continue;
+
+		if (draw.timer != timer)
+		{
+			if (timer >= 0)
+				endGpuTimer((GpuPass)timer);
+			timer = draw.timer;
+			if (timer >= 0)
+				beginGpuTimer((GpuPass)timer);
+		}
 
-	viewMatrix = glm::mat4(1.0);
-	glUniformMatrix4fv(viewMatrixLocation, 1, false, glm::value_ptr(viewMatrix));
+		glBindTexture(GL_TEXTURE_2D, textureStreamer.texture(draw.texture));
+		glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(draw.modelMatrix));
 
-	renderScore();
+		float depth = max(-(pass.viewMatrix * draw.modelMatrix[3]).z, 0.1f); // no nearer than the near plane
+		float pixelsPerUnit = draw.scale * pass.viewportHeight / (2 * depth * tan(glm::radians(FIELD_OF_VIEW) / 2));
 
-	// re-enable the depth testing for next iteration
+		int lod = mesh.selectLod(pixelsPerUnit, lodPixelError);
+		mesh.draw(lod);
+		frameStats.triangles += (mesh.lods.empty() ? mesh.indexCount : mesh.lods[lod].indexCount) / 3;
+	}
+	if (timer >= 0)
+		endGpuTimer((GpuPass)timer);
+
+	glUniform1i(transparentPassLocation, 0);
+}
+// end::submitWorldDraws[]
+
+// tag::renderDebugDraw[]
+// what the simulation sees rather than what's drawn: the boxes checkBallPaddleCollision tests (green
+// while they overlap), the x limits checkSideBounds clamps the ball and paddles to, the ball's
+// velocity, and the path predictBallPath expects it to take. theProgram must be in use, with a
+// camera bound
+void renderDebugDraw(const MatchState &state)
+{
+	const glm::vec4 RED(1, 0.2f, 0.2f, 1);
+	const glm::vec4 GREEN(0.2f, 1, 0.2f, 1);
+	const glm::vec4 YELLOW(1, 1, 0.2f, 1);
+	const glm::vec4 CYAN(0.2f, 1, 1, 1);
+	const glm::vec4 MAGENTA(1, 0.2f, 1, 1);
+	const float HEIGHT = 0.125f; // the simulation is flat; give the boxes some height so they show from above
+
+	const glm::vec3 paddleHalfSize(PADDLE_WIDTH / 2, HEIGHT, PADDLE_DEPTH / 2);
+	const glm::vec3 ballHalfSize(BALL_WIDTH / 2, BALL_WIDTH / 2, BALL_WIDTH / 2);
+	debugDraw.box(state.paddle1Position, paddleHalfSize, checkBallPaddleCollision(state, state.paddle1Position) ? GREEN : RED);
+	debugDraw.box(state.paddle2Position, paddleHalfSize, checkBallPaddleCollision(state, state.paddle2Position) ? GREEN : RED);
+	debugDraw.box(state.ballPosition, ballHalfSize, YELLOW);
+
+	// the limits on each item's centre
+	float ballLimit = AREA_WIDTH / 2 - BALL_WIDTH / 2 - WORLD_BOUNDS_WIDTH / 2;
+	float paddleLimit = AREA_WIDTH / 2 - PADDLE_WIDTH / 2 - WORLD_BOUNDS_WIDTH / 2;
+	for (float side = -1; side <= 1; side += 2)
+	{
+		debugDraw.line(glm::vec3(side * ballLimit, 0, -AREA_DEPTH / 2), glm::vec3(side * ballLimit, 0, AREA_DEPTH / 2), YELLOW);
+		for (float z : { state.paddle1Position.z, state.paddle2Position.z })
+			debugDraw.line(glm::vec3(side * paddleLimit, 0, z - PADDLE_DEPTH), glm::vec3(side * paddleLimit, 0, z + PADDLE_DEPTH), RED);
+	}
+
+	// half a second of travel
+	debugDraw.line(state.ballPosition, state.ballPosition + state.ballDirection * (BALL_VELOCITY * 0.5f), CYAN);
+
+	glm::vec3 path[32];
+	debugDraw.polyline(path, predictBallPath(state, path, 32), MAGENTA);
+
+	glm::mat4 modelMatrix = glm::mat4(1.0);
+	glUniformMatrix4fv(modelMatrixLocation, 1, false, glm::value_ptr(modelMatrix));
+
+	// on top of the world, which would otherwise hide half of every box
+	glBindTexture(GL_TEXTURE_2D, textureStreamer.texture(-1));
+	glDisable(GL_DEPTH_TEST);
+	debugDraw.draw();
 	glEnable(GL_DEPTH_TEST);
+}
+// end::renderDebugDraw[]
+
+// tag::render[]
+void render()
+{
+	frameLine += "Player 1: " + std::to_string(match.player1Score) + " Player 2: " + std::to_string(match.player2Score) + " ";
+
+	glUseProgram(theProgram); //installs the program object specified by program as part of current rendering state
+
+	// the views: the current camera across the whole scene, or in split screen cameras 1 and 2 side by side
+	int viewCount = splitScreen ? 2 : 1;
+	int viewWidth = sceneWidth() / viewCount;
+
+	//set projectionMatrix - how we go from 3D to 2D
+	glm::mat4 projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), (float)windowWidth / viewCount / windowHeight, 0.1f, 100.0f); // perspective - makes things further away smaller
+
+	glm::mat4 viewMatrices[MAX_VIEWS];
+	glm::mat4 viewProjections[MAX_VIEWS];
+	GLintptr cameras[MAX_VIEWS];
+	for (int view = 0; view < viewCount; view++)
+	{
+		viewMatrices[view] = viewMatrixFor(splitScreen ? view + 1 : currentCamera, match);
+		viewProjections[view] = projectionMatrix * viewMatrices[view];
+		cameras[view] = uploadCamera(viewMatrices[view], projectionMatrix);
+	}
+
+	// laid out and culled once for every view
+	buildWorldDraws(match, worldDraws, true);
+	cullWorldDraws(worldDraws, viewProjections, viewCount);
+
+	// the scene fills the render scale's share of its targets, so that's all that needs clearing
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	beginSceneTiming();
+	glViewport(0, 0, sceneWidth(), sceneHeight());
+	glScissor(0, 0, sceneWidth(), sceneHeight());
+	glEnable(GL_SCISSOR_TEST);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+
+	// every view's opaque models, then every view's translucent ones, blended over them whatever
+	// order they're drawn in by one composite for the whole scene
+	for (int translucent = 0; translucent < 2; translucent++)
+	{
+		if (translucent)
+			sceneTransparency.begin(); //the viewport is still the whole scene
+		for (int view = 0; view < viewCount; view++)
+		{
+			glViewport(view * viewWidth, 0, viewWidth, sceneHeight());
+			bindCamera(cameras[view]);
+			WorldPass pass = { viewMatrices[view], (float)sceneHeight(), translucent != 0, 1u << view };
+			submitWorldDraws(worldDraws, pass);
+		}
+		glViewport(0, 0, sceneWidth(), sceneHeight());
+	}
+	sceneTransparency.composite(sceneFramebuffer);
+	glUseProgram(theProgram);
+
+	// the lines are queued and uploaded once, and drawn again for any other view
+	if (debugDrawEnabled)
+	{
+		for (int view = 0; view < viewCount; view++)
+		{
+			glViewport(view * viewWidth, 0, viewWidth, sceneHeight());
+			bindCamera(cameras[view]);
+			if (view == 0)
+				renderDebugDraw(match);
+			else
+			{
+				glDisable(GL_DEPTH_TEST);
+				debugDraw.redraw();
+				glEnable(GL_DEPTH_TEST);
+			}
+		}
+		glViewport(0, 0, sceneWidth(), sceneHeight());
+	}
+
+	// 2D HUD -------------------------------------------------------------------------------------
+
+	// without a font, draw the scores as quads here; otherwise they're text in renderHUD
+	if (!hudTextReady)
+	{
+		// disable depth testing
+		glDisable(GL_DEPTH_TEST);
+
+		glBindVertexArray(scoreVertexArrayObject);
+		glBindTexture(GL_TEXTURE_2D, textureStreamer.texture(-1));
+
+		// Reset all the matrices to identity matrix
+		setCamera(glm::mat4(1.0), glm::mat4(1.0));
+
+		beginGpuTimer(GPU_HUD);
+		renderScore();
+		endGpuTimer(GPU_HUD);
+
+		// re-enable the depth testing for next iteration
+		glEnable(GL_DEPTH_TEST);
+	}
 
 	glBindVertexArray(0);
 
+	// the finished scene into the window, scaled up to fill it, for the HUD to go over at full resolution
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	bool scaled = sceneWidth() != windowWidth || sceneHeight() != windowHeight;
+	glBlitFramebuffer(0, 0, sceneWidth(), sceneHeight(), 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT,
+	                  scaled ? GL_LINEAR : GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	endSceneTiming();
+	glViewport(0, 0, windowWidth, windowHeight);
+
 	glUseProgram(0); //clean up
 }
 // end::render[]
 
+// tag::initializeAtlas[]
+void initializeAtlas()
+{
+	GLint maxSize;
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+	atlasRows = std::min(pixelEnvCount, (int)maxSize / PIXEL_SIZE);
+	atlasColumns = (pixelEnvCount + atlasRows - 1) / atlasRows;
+	if (atlasColumns * PIXEL_SIZE > maxSize)
+	{
+		cerr << "Too many pixel envs for one atlas: the most is " << (maxSize / PIXEL_SIZE) * (maxSize / PIXEL_SIZE) << endl;
+		SDL_Quit();
+		exit(1);
+	}
+	int width = atlasColumns * PIXEL_SIZE;
+	int height = atlasRows * PIXEL_SIZE;
+
+	glGenRenderbuffers(1, &atlasColorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, atlasColorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, width, height);
+
+	glGenRenderbuffers(1, &atlasDepthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, atlasDepthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &atlasFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, atlasFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, atlasColorRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, atlasDepthRenderbuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		cerr << "Pixel observation atlas framebuffer is incomplete" << endl;
+		SDL_Quit();
+		exit(1);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	string error;
+	if (!atlasTransparency.initialise(width, height, atlasDepthRenderbuffer, transparencyProgram, error))
+	{
+		cerr << "Pixel observation atlas transparency targets could not be created - " << error << endl;
+		SDL_Quit();
+		exit(1);
+	}
+
+	pixelObservations.resize((size_t)width * height * 3);
+	cout << "Pixel observation atlas " << width << "x" << height << " for " << pixelEnvCount << " envs created OK!\n";
+}
+// end::initializeAtlas[]
+
+// tag::pixelObservation[]
+// where env's image starts in pixelObservations; rows are rowStride bytes apart, bottom row first
+const uint8_t *pixelObservation(int env, int &rowStride)
+{
+	rowStride = atlasColumns * PIXEL_SIZE * 3;
+	int column = env / atlasRows;
+	int row = env % atlasRows;
+	return &pixelObservations[(size_t)row * PIXEL_SIZE * rowStride + (size_t)column * PIXEL_SIZE * 3];
+}
+
+// every env's image from the last readback as binary PPMs one after another, top row first -
+// netpbm reads them as one multi-image file (pnmsplit separates them)
+bool dumpPixelObservations(const char *path)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	for (int env = 0; env < pixelEnvCount && file; env++)
+	{
+		int rowStride;
+		const uint8_t *image = pixelObservation(env, rowStride);
+		file << "P6\n" << PIXEL_SIZE << " " << PIXEL_SIZE << "\n255\n";
+		for (int row = PIXEL_SIZE - 1; row >= 0; row--)
+			file.write((const char *)image + (size_t)row * rowStride, PIXEL_SIZE * 3);
+	}
+	return (bool)file;
+}
+// end::pixelObservation[]
+
+// tag::updatePixelEnvs[]
+void updatePixelEnvs()
+{
+	// stand-in agents pressing random directions - a trainer would pass its own actions
+	static std::vector<int32_t> actions;
+	static std::vector<float> observations, rewards;
+	static std::vector<uint8_t> dones;
+	actions.resize(pixelEnvCount);
+	observations.resize((size_t)pixelEnvCount * VecEnv::OBSERVATION_SIZE);
+	rewards.resize(pixelEnvCount);
+	dones.resize(pixelEnvCount);
+
+	for (int32_t &action : actions)
+		action = (int32_t)pixelActionRandom.below(VecEnv::ACTION_COUNT);
+	pixelEnv->step(&actions[0], &observations[0], &rewards[0], &dones[0]);
+
+	// rotate the ball as fast as one step's worth of game time would
+	angle += (float)pixelEnv->getConfig().ticksPerStep / FIXED_TICK_RATE * 2;
+	if (angle > 360)
+		angle = 0;
+}
+// end::updatePixelEnvs[]
+
+// tag::renderPixelEnvs[]
+// draw every env into its square of the atlas, read the whole atlas back in one go, then show the
+// first few squares in the window
+void renderPixelEnvs()
+{
+	auto renderStart = high_resolution_clock::now();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, atlasFramebuffer);
+	glViewport(0, 0, atlasColumns * PIXEL_SIZE, atlasRows * PIXEL_SIZE);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glUseProgram(theProgram);
+
+	// the long shot sees the whole arena, so nothing an agent needs is ever off screen
+	glm::mat4 projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), 1.0f, 0.1f, 100.0f);
+	glm::mat4 viewMatrix = viewMatrixFor(3, match);
+	setCamera(viewMatrix, projectionMatrix);
+
+	// each env's world laid out once for both passes - and not culled, as it's all in shot
+	MatchState state;
+	pixelEnvDraws.resize(pixelEnvCount);
+	for (int env = 0; env < pixelEnvCount; env++)
+	{
+		toMatchState(pixelEnv->match(env), state);
+		buildWorldDraws(state, pixelEnvDraws[env], false);
+	}
+
+	// every env's opaque models, then every env's translucent ones, then one composite for them all
+	for (int translucent = 0; translucent < 2; translucent++)
+	{
+		if (translucent)
+			atlasTransparency.begin(); //the viewport is still the whole atlas
+		WorldPass pass = { viewMatrix, PIXEL_SIZE, translucent != 0, 1 };
+		for (int env = 0; env < pixelEnvCount; env++)
+		{
+			glViewport((env / atlasRows) * PIXEL_SIZE, (env % atlasRows) * PIXEL_SIZE, PIXEL_SIZE, PIXEL_SIZE);
+			submitWorldDraws(pixelEnvDraws[env], pass);
+		}
+		glViewport(0, 0, atlasColumns * PIXEL_SIZE, atlasRows * PIXEL_SIZE); //begin and composite cover the whole atlas
+	}
+	atlasTransparency.composite(atlasFramebuffer);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	// one readback for every env
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, atlasColumns * PIXEL_SIZE, atlasRows * PIXEL_SIZE, GL_RGB, GL_UNSIGNED_BYTE, &pixelObservations[0]);
+
+	double milliseconds = duration_cast<microseconds>(high_resolution_clock::now() - renderStart).count() / 1000.0;
+	frameLine += "Pixel envs: " + std::to_string(pixelEnvCount) + " render+readback: " + std::to_string(milliseconds) + "ms ";
+
+	// show up to a 7x7 grid of envs, square in the window's top left
+	const int SHOWN = 7;
+	const int CELL = std::min(windowWidth, windowHeight) / SHOWN;
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, atlasFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	for (int env = 0; env < std::min(pixelEnvCount, SHOWN * SHOWN); env++)
+	{
+		int sourceX = (env / atlasRows) * PIXEL_SIZE;
+		int sourceY = (env % atlasRows) * PIXEL_SIZE;
+		int cellX = (env % SHOWN) * CELL;
+		int cellY = windowHeight - (env / SHOWN + 1) * CELL;
+		glBlitFramebuffer(sourceX, sourceY, sourceX + PIXEL_SIZE, sourceY + PIXEL_SIZE,
+		                  cellX, cellY, cellX + CELL, cellY + CELL, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+}
+// end::renderPixelEnvs[]
+
+// tag::recordFrameTimes[]
+void recordFrameTimes(double updateMilliseconds, double renderMilliseconds)
+{
+	auto now = high_resolution_clock::now();
+	static high_resolution_clock::time_point lastFrame = now;
+	double frameMilliseconds = duration_cast<microseconds>(now - lastFrame).count() / 1000.0;
+	lastFrame = now;
+
+	FrameStats &stats = frameStats;
+	if (stats.frames == 0 && stats.frameMilliseconds == 0)
+		stats.windowStart = now;
+	stats.frames++;
+	stats.frameMilliseconds += frameMilliseconds;
+	stats.worstFrameMilliseconds = max(stats.worstFrameMilliseconds, frameMilliseconds);
+	stats.updateMilliseconds += updateMilliseconds;
+	stats.renderMilliseconds += renderMilliseconds;
+
+	double windowSeconds = duration_cast<microseconds>(now - stats.windowStart).count() / 1e6;
+	if (windowSeconds < 0.5)
+		return;
+
+	char line[128];
+	snprintf(line, sizeof(line), "%.0f fps  frame %.2f ms (worst %.2f)  scene %dx%d", stats.frames / windowSeconds,
+	         stats.frameMilliseconds / stats.frames, stats.worstFrameMilliseconds, sceneWidth(), sceneHeight());
+	stats.lines[0] = line;
+	snprintf(line, sizeof(line), "update %.3f ms  render %.3f ms  %lld tris  %lld culled", stats.updateMilliseconds / stats.frames,
+	         stats.renderMilliseconds / stats.frames, stats.triangles / stats.frames, stats.culled / stats.frames);
+	stats.lines[1] = line;
+	// the GPU's side of the same frames, each pass averaged over the frames whose timings are back
+	stats.lines[2] = gpuTiming ? "gpu" : "";
+	int dropped = 0;
+	for (int pass = 0; pass < GPU_PASSES && gpuTiming; pass++)
+	{
+		if (stats.gpuFrames[pass] > 0)
+			snprintf(line, sizeof(line), "  %s %.3f ms", GPU_PASS_NAMES[pass], stats.gpuMilliseconds[pass] / stats.gpuFrames[pass]);
+		else
+			snprintf(line, sizeof(line), "  %s -", GPU_PASS_NAMES[pass]);
+		stats.lines[2] += line;
+		dropped += gpuTimers[pass].dropped();
+	}
+	if (dropped > 0)
+		stats.lines[2] += "  dropped " + std::to_string(dropped);
+	snprintf(line, sizeof(line), "text %d chars  debug %d lines  stream waits %d  tex pending %d", hudText.lastDrawCharacters(),
+	         debugDrawEnabled ? debugDraw.lastDrawLines() : 0, streamBuffer.waits(), textureStreamer.pending());
+	stats.lines[3] = line;
+	line[0] = 0;
+	const ResolutionStats &resolutionStats = resolution.getStats();
+	if (stats.sceneTimings > 0 && dynamicResolution)
+		snprintf(line, sizeof(line), "scene %.3f ms %s  budget %.1f  scale %.2f  changes %d  over %d", stats.sceneMilliseconds / stats.sceneTimings,
+		         gpuTiming ? "gpu" : "cpu", resolutionConfig.budgetMilliseconds, renderScale, resolutionStats.changes,
+		         resolutionStats.overBudget);
+	stats.lines[4] = line;
+
+	stats.windowStart = now;
+	stats.frames = 0;
+	stats.frameMilliseconds = stats.worstFrameMilliseconds = stats.updateMilliseconds = stats.renderMilliseconds = 0;
+	stats.triangles = 0;
+	stats.culled = 0;
+	stats.sceneMilliseconds = 0;
+	stats.sceneTimings = 0;
+	for (int pass = 0; pass < GPU_PASSES; pass++)
+	{
+		stats.gpuMilliseconds[pass] = 0;
+		stats.gpuFrames[pass] = 0;
+	}
+}
+// end::recordFrameTimes[]
+
+// tag::renderHUD[]
+// all the HUD's text - scores and frame stats - in one draw
+void renderHUD()
+{
+	if (!hudTextReady)
+		return;
+
+	const glm::vec4 WHITE(1, 1, 1, 1);
+	const glm::vec4 GREY(0.7f, 0.7f, 0.7f, 1);
+
+	if (pixelEnvCount == 0)
+	{
+		string score = "Player 1  " + std::to_string(match.player1Score) + " : " + std::to_string(match.player2Score) + "  Player 2";
+		float scale = 1.25f;
+		hudText.addText(score, (windowWidth - hudText.measure(score, scale)) / 2, 8, WHITE, scale);
+	}
+
+	float scale = 0.75f;
+	float lineHeight = hudText.lineHeight() * scale;
+	for (int i = 0; i < FrameStats::LINES; i++)
+		hudText.addText(frameStats.lines[i], 8, windowHeight - 8 - (FrameStats::LINES - i) * lineHeight, GREY, scale);
+
+	glDisable(GL_DEPTH_TEST);
+	beginGpuTimer(GPU_HUD);
+	hudText.draw(windowWidth, windowHeight);
+	endGpuTimer(GPU_HUD);
+	glEnable(GL_DEPTH_TEST);
+}
+// end::renderHUD[]
+
+// tag::updateTextures[]
+//upload the next frame's share of whatever textures have been decoded
+void updateTextures()
+{
+	string error;
+	if (!textureStreamer.update(error))
+		cerr << "\nTexture " << error << " - drawing without it" << endl;
+}
+// end::updateTextures[]
+
 // tag::postRender[]
 void postRender()
 {
+	streamBuffer.endFrame(); //fence this frame's streamed data, so the ring doesn't overwrite it until it's drawn
+	endGpuFrames(); //this frame's timer queries are all issued
 	SDL_GL_SwapWindow(win);; //present the frame buffer to the display (swapBuffers)
 	frameLine += "Frame: " + std::to_string(frameCount++);
 	cout << "\r" << frameLine << std::flush;
@@ -994,16 +2170,147 @@ void postRender()
 // tag::cleanUp[]
 void cleanUp()
 {
+	if (replayPath)
+	{
+		if (saveReplay(replayPath, replay))
+			cout << "Replay of " << replay.inputs.size() << " ticks saved to " << replayPath << "\n";
+		else
+			cerr << "Could not save replay to " << replayPath << "\n";
+	}
+
+	if (observationsPath && pixelEnvCount > 0)
+	{
+		if (dumpPixelObservations(observationsPath))
+			cout << "Pixel observations of " << pixelEnvCount << " envs saved to " << observationsPath << "\n";
+		else
+			cerr << "Could not save pixel observations to " << observationsPath << "\n";
+	}
+
+	if (hudTextReady)
+		hudText.destroy();
+	TTF_Quit();
+	textureStreamer.destroy();
+	IMG_Quit();
+	if (compileThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(compileMutex);
+			compileStopping = true;
+		}
+		compileWake.notify_all();
+		compileThread.join(); //after any reload it's in the middle of
+		SDL_GL_DeleteContext(compileContext);
+	}
+	if (programReload.program != 0)
+	{
+		glDeleteProgram(programReload.program);
+		endProgramReload();
+	}
+	debugDraw.destroy();
+	if (dynamicResolution)
+	{
+		const ResolutionStats &stats = resolution.getStats();
+		cout << "Dynamic resolution: " << stats.measurements << " measurements, " << stats.overBudget << " over budget, "
+		     << stats.changes << " changes, scale " << stats.lowestScale << " to " << stats.highestScale << "\n";
+	}
+	for (GpuTimer &timer : gpuTimers)
+		timer.destroy();
+	sceneTransparency.destroy();
+	atlasTransparency.destroy();
+	if (pixelEnvCount > 0)
+	{
+		glDeleteFramebuffers(1, &atlasFramebuffer);
+		glDeleteRenderbuffers(1, &atlasColorRenderbuffer);
+		glDeleteRenderbuffers(1, &atlasDepthRenderbuffer);
+		pixelEnv.reset(); //stop its worker threads while everything else is still up
+	}
+	glDeleteProgram(transparencyProgram);
+	glDeleteFramebuffers(1, &sceneFramebuffer);
+	glDeleteRenderbuffers(1, &sceneColorRenderbuffer);
+	glDeleteRenderbuffers(1, &sceneDepthRenderbuffer);
+	streamBuffer.destroy();
+	paddleMesh.destroy();
+	wallMesh.destroy();
+	ballMesh.destroy();
+
 	SDL_GL_DeleteContext(context);
 	SDL_DestroyWindow(win);
 	cout << "Cleaning up OK!\n";
 }
 // end::cleanUp[]
 
+void loadController(std::unique_ptr<Controller> &controller, const string &spec)
+{
+	string error;
+	controller = createController(spec, error);
+	if (!controller)
+	{
+		cerr << error << endl;
+		exit(1);
+	}
+	cout << "Paddle controlled by " << controller->name() << "\n";
+}
+
 // tag::main[]
 int main( int argc, char* args[] )
 {
 	exeName = args[0];
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(args[i]) == "--fixed-point")
+			fixedPointMode = true;
+		else if (string(args[i]) == "--record-replay" && i + 1 < argc)
+		{
+			replayPath = args[++i];
+			fixedPointMode = true;
+		}
+		else if (string(args[i]) == "--pixel-envs" && i + 1 < argc)
+			pixelEnvCount = std::max(1, atoi(args[++i]));
+		else if (string(args[i]) == "--dump-observations" && i + 1 < argc)
+			observationsPath = args[++i];
+		else if ((string(args[i]) == "--controller1" || string(args[i]) == "--controller2") && i + 1 < argc)
+		{
+			std::unique_ptr<Controller> &controller = string(args[i]) == "--controller1" ? controller1 : controller2;
+			loadController(controller, args[++i]);
+		}
+		else if (string(args[i]) == "--font" && i + 1 < argc)
+		{
+			fontPath = args[++i];
+			fontChosen = true;
+		}
+		else if (string(args[i]) == "--pack" && i + 1 < argc)
+			assetPackPath = args[++i];
+		else if (string(args[i]) == "--build-pack" && i + 1 < argc)
+			buildPackPath = args[++i];
+		else if (string(args[i]) == "--texture-budget" && i + 1 < argc)
+			textureBudget = (GLsizeiptr)std::max(1, atoi(args[++i])) * 1024;
+		else if (string(args[i]) == "--lod-error" && i + 1 < argc)
+			lodPixelError = (float)atof(args[++i]);
+		else if (string(args[i]) == "--render-scale" && i + 1 < argc)
+			setRenderScale((float)atof(args[++i]));
+		else if (string(args[i]) == "--resolution-budget" && i + 1 < argc)
+		{
+			resolutionConfig.budgetMilliseconds = atof(args[++i]);
+			dynamicResolution = resolutionConfig.budgetMilliseconds > 0;
+		}
+		else if (string(args[i]) == "--resolution-log" && i + 1 < argc)
+			resolutionLogPath = args[++i];
+		else if (string(args[i]) == "--debug-draw")
+			debugDrawEnabled = true;
+		else if (string(args[i]) == "--split-screen")
+			splitScreen = true;
+		else if (string(args[i]) == "--no-program-cache")
+			programCacheEnabled = false;
+		else if (string(args[i]) == "--ai1")
+			loadController(controller1, "predictive");
+		else if (string(args[i]) == "--ai2")
+			loadController(controller2, "predictive");
+	}
+	if (!buildPackPath.empty())
+		return buildAssetPack(buildPackPath) ? 0 : 1;
+	if (fixedPointMode)
+		cout << "Using fixed point simulation at " << FIXED_TICK_RATE << " ticks/s\n";
+
 	//setup
 	//- do just once
 	initialise();
@@ -1013,22 +2320,63 @@ int main( int argc, char* args[] )
 
 	initGlew();
 
-	glViewport(0,0,600,600); //should check what the actual window res is?
+	updateWindowSize(); //the drawable size, which can differ from the window's on high-DPI displays
+	glViewport(0, 0, windowWidth, windowHeight);
 
 	//do stuff that only needs to happen once
 	//- create shaders
 	//- load vertex data
 	loadAssets();
 
+	if (pixelEnvCount > 0)
+	{
+		VecEnvConfig config;
+		config.envs = pixelEnvCount;
+		pixelEnv.reset(new VecEnv(config));
+
+		std::vector<uint64_t> seeds(pixelEnvCount);
+		std::vector<float> observations((size_t)pixelEnvCount * VecEnv::OBSERVATION_SIZE);
+		for (int i = 0; i < pixelEnvCount; i++)
+			seeds[i] = i;
+		pixelEnv->reset(&seeds[0], &observations[0]);
+
+		initializeAtlas();
+	}
+
 	while (!done) //loop until done flag is set)
 	{
+		auto updateStart = high_resolution_clock::now();
+
 		handleInput(); // this should ONLY SET VARIABLES
 
-		updateSimulation(); // this should ONLY SET VARIABLES according to simulation
+		if (pixelEnvCount > 0)
+			updatePixelEnvs();
+		else
+			updateSimulation(); // this should ONLY SET VARIABLES according to simulation
+
+		auto renderStart = high_resolution_clock::now();
+
+		reloadShaders(); //swap in edited shaders once they've built
+
+		updateTextures(); //a budgeted slice of texture uploads
+
+		pollGpuTimers(); //whatever earlier frames' GPU timings have come in
+
+		if (pixelEnvCount == 0)
+			updateRenderScale(); //the scale to draw the scene at, from the timings that have come in
 
 		preRender();
 
-		render(); // this should render the world state according to VARIABLES -
+		if (pixelEnvCount > 0)
+			renderPixelEnvs();
+		else
+			render(); // this should render the world state according to VARIABLES -
+
+		renderHUD();
+
+		auto renderEnd = high_resolution_clock::now();
+		recordFrameTimes(duration_cast<microseconds>(renderStart - updateStart).count() / 1000.0,
+		                 duration_cast<microseconds>(renderEnd - renderStart).count() / 1000.0);
 
 		postRender();
 
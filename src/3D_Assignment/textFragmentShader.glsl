@@ -0,0 +1,11 @@
+#version 330
+in vec2 fragmentTexCoord;
+in vec4 fragmentColor;
+out vec4 outputColor;
+
+uniform sampler2D glyphAtlas; // coverage in the red channel
+
+void main()
+{
+	 outputColor = vec4(fragmentColor.rgb, fragmentColor.a * texture(glyphAtlas, fragmentTexCoord).r);
+}
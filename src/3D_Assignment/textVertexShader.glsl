@@ -0,0 +1,15 @@
+#version 330
+in vec2 position; // pixels from the top left of the screen
+in vec2 texCoord;
+in vec4 vertexColor;
+out vec2 fragmentTexCoord;
+out vec4 fragmentColor;
+
+uniform vec2 screenSize = vec2(600.0, 600.0);
+
+void main()
+{
+		gl_Position = vec4(position.x / screenSize.x * 2.0 - 1.0, 1.0 - position.y / screenSize.y * 2.0, 0.0, 1.0);
+		fragmentTexCoord = texCoord;
+		fragmentColor = vertexColor;
+}
@@ -0,0 +1,17 @@
+#version 330
+out vec4 outputColor;
+
+uniform sampler2D accumulation; // rgb: sum of colour * alpha * weight; alpha: revealage
+uniform sampler2D weights;      // sum of alpha * weight
+
+void main()
+{
+	 ivec2 pixel = ivec2(gl_FragCoord.xy);
+	 vec4 sum = texelFetch(accumulation, pixel, 0);
+	 float revealage = sum.a;
+	 if (revealage == 1.0)
+		 discard; // nothing translucent here
+	 // the weighted average colour, covering as much as the surfaces together hide
+	 vec3 average = sum.rgb / max(texelFetch(weights, pixel, 0).r, 1e-5);
+	 outputColor = vec4(average, 1.0 - revealage);
+}
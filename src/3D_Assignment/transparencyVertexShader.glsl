@@ -0,0 +1,7 @@
+#version 330
+// one triangle covering the whole screen, from gl_VertexID alone
+void main()
+{
+		vec2 corner = vec2(float(gl_VertexID & 1) * 4.0 - 1.0, float(gl_VertexID & 2) * 2.0 - 1.0);
+		gl_Position = vec4(corner, 0.0, 1.0);
+}
@@ -1,14 +1,25 @@
 #version 330
 in vec3 position;
 in vec4 vertexColor;
+in vec2 texCoord;
 out vec4 fragmentColor;
+out vec2 fragmentTexCoord;
+out float fragmentDepth; // distance in front of the camera
 
 uniform mat4 modelMatrix      = mat4(1.0);
-uniform mat4 viewMatrix       = mat4(1.0);
-uniform mat4 projectionMatrix = mat4(1.0);
+
+// the camera, from a range of a uniform buffer, so changing views is one bind
+layout(std140) uniform Camera
+{
+		mat4 viewMatrix;
+		mat4 projectionMatrix;
+};
 
 void main()
 {
-		gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
+		vec4 viewPosition = viewMatrix * modelMatrix * vec4(position, 1.0);
+		gl_Position = projectionMatrix * viewPosition;
 		fragmentColor = vertexColor;
+		fragmentTexCoord = texCoord;
+		fragmentDepth = -viewPosition.z;
 }
@@ -0,0 +1,164 @@
+// PongBench ai - checks the predictive computer player in PaddleAI.h and times its decisions.
+//
+// The prediction made as the ball leaves one paddle should be where it arrives at the other,
+// however many times it bounces off the walls on the way; the predictive player should beat the
+// follow-the-ball bot; and a decision should cost about as little as a simulation step.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include "Benchmarks.h"
+#include "PaddleAI.h"
+#include "Random.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+// tag::measurePredictionError[]
+// both paddles predictive; each time the ball leaves a paddle, predict where it meets the other
+// and compare with where it really does. Returns the largest error in metres.
+float measurePredictionError(int ticks, int &checkedBounces)
+{
+	FixedMatchState match;
+	int targetPlayer = 0;
+	Fixed predicted = Fixed::fromInt(0);
+	float largestError = 0;
+	checkedBounces = 0;
+
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		int lastDirectionZ = match.ballDirectionZ;
+		int points = match.player1Score + match.player2Score;
+
+		match.paddle1Direction = predictiveDirectionFixed(match, 1);
+		match.paddle2Direction = predictiveDirectionFixed(match, 2);
+		stepMatchFixed(match);
+
+		if (match.player1Score + match.player2Score != points)
+			targetPlayer = 0; // a point resets the ball, so the prediction no longer applies
+		else if (match.ballDirectionZ != lastDirectionZ)
+		{
+			// the ball just bounced off a paddle
+			int bouncedOff = match.ballZ > Fixed::fromInt(0) ? 1 : 2;
+			if (bouncedOff == targetPlayer)
+			{
+				largestError = std::max(largestError, fabsf((match.ballX - predicted).toFloat()));
+				checkedBounces++;
+			}
+			targetPlayer = bouncedOff == 1 ? 2 : 1;
+			predicted = predictBallXFixed(match, targetPlayer);
+		}
+	}
+	return largestError;
+}
+// end::measurePredictionError[]
+
+// tag::playAgainstFollower[]
+// the predictive player against the follow-the-ball bot, swapping sides every match
+void playAgainstFollower(int matchCount, int ticks, int &predictivePoints, int &followerPoints)
+{
+	predictivePoints = followerPoints = 0;
+	for (int i = 0; i < matchCount; i++)
+	{
+		int predictivePlayer = i % 2 == 0 ? 1 : 2;
+		FixedMatchState match;
+		// start the paddles somewhere different each match
+		Random random(i);
+		match.paddle1X = Fixed::fromRaw((int32_t)random.below(Fixed::ONE)) - Fixed::fromRatio(1, 2);
+		match.paddle2X = Fixed::fromRaw((int32_t)random.below(Fixed::ONE)) - Fixed::fromRatio(1, 2);
+
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			int predictive = predictiveDirectionFixed(match, predictivePlayer);
+			Fixed followerX = predictivePlayer == 1 ? match.paddle2X : match.paddle1X;
+			int follower = followBallDirection(followerX.toFloat(), match.ballX.toFloat());
+			match.paddle1Direction = predictivePlayer == 1 ? predictive : follower;
+			match.paddle2Direction = predictivePlayer == 1 ? follower : predictive;
+			stepMatchFixed(match);
+		}
+
+		predictivePoints += predictivePlayer == 1 ? match.player1Score : match.player2Score;
+		followerPoints += predictivePlayer == 1 ? match.player2Score : match.player1Score;
+	}
+}
+// end::playAgainstFollower[]
+
+// tag::timeDecisions[]
+// nanoseconds per decision over a batch of matches at different points of play
+void timeDecisions(int matchCount, int repeats, double &floatNanos, double &fixedNanos)
+{
+	std::vector<FixedMatchState> fixedMatches(matchCount);
+	std::vector<MatchState> floatMatches(matchCount);
+	for (int i = 0; i < matchCount; i++)
+	{
+		for (int tick = 0; tick < i % 1000; tick++)
+			stepMatchFixed(fixedMatches[i]);
+		toMatchState(fixedMatches[i], floatMatches[i]);
+	}
+
+	int sum = 0;
+	auto start = steady_clock::now();
+	for (int repeat = 0; repeat < repeats; repeat++)
+		for (const MatchState &match : floatMatches)
+			sum += predictiveDirection(match, 1 + (repeat & 1));
+	floatNanos = duration_cast<nanoseconds>(steady_clock::now() - start).count() / ((double)matchCount * repeats);
+
+	start = steady_clock::now();
+	for (int repeat = 0; repeat < repeats; repeat++)
+		for (const FixedMatchState &match : fixedMatches)
+			sum += predictiveDirectionFixed(match, 1 + (repeat & 1));
+	fixedNanos = duration_cast<nanoseconds>(steady_clock::now() - start).count() / ((double)matchCount * repeats);
+
+	// use the results so the loops can't be optimised away
+	if (sum == 0x7fffffff)
+		cout << sum;
+}
+// end::timeDecisions[]
+
+// tag::runAIBench[]
+int runAIBench(int argc, char *args[])
+{
+	int matchCount = 200;
+	int ticks = 60 * FIXED_TICK_RATE;
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--matches")
+			matchCount = atoi(args[i + 1]);
+		else if (arg == "--ticks")
+			ticks = atoi(args[i + 1]);
+	}
+
+	bool passed = true;
+	cout << std::fixed;
+
+	// 1. predictions land where the ball does - off by at most the few ticks' clamping at each wall
+	int checkedBounces;
+	float largestError = measurePredictionError(ticks * 10, checkedBounces);
+	const float TOLERANCE = 0.05f; // 5cm; the worst seen is about 2cm, from the clamping at each wall
+	cout << std::setprecision(4) << "prediction: largest error " << largestError << "m over " << checkedBounces
+	     << " returns" << (largestError <= TOLERANCE && checkedBounces > 0 ? " - OK" : " - FAILED") << endl;
+	passed &= largestError <= TOLERANCE && checkedBounces > 0;
+
+	// 2. it beats the bot that chases the ball
+	int predictivePoints, followerPoints;
+	playAgainstFollower(matchCount, ticks, predictivePoints, followerPoints);
+	cout << "predictive vs follow-the-ball over " << matchCount << " matches: " << predictivePoints << "-" << followerPoints
+	     << (predictivePoints > followerPoints ? " - OK" : " - FAILED") << endl;
+	passed &= predictivePoints > followerPoints;
+
+	// 3. the cost of a decision
+	double floatNanos, fixedNanos;
+	timeDecisions(4096, 1000, floatNanos, fixedNanos);
+	cout << std::setprecision(2) << "decision: float " << floatNanos << " ns, fixed " << fixedNanos << " ns" << endl;
+
+	return passed ? 0 : 1;
+}
+// end::runAIBench[]
@@ -0,0 +1,253 @@
+// PongBench assets - loading the game's startup assets from loose files versus an asset pack.
+//
+// Packs the game's shaders, models, textures and font (from --dir, src/3D_Assignment by default, and
+// --font), checks every asset comes back out of the pack byte for byte, then times getting all
+// of them into memory three ways: each file read into a string through an ifstream, as
+// loadShader used to; each file memory-mapped; and one mapped pack. Warm runs have the files in
+// the OS cache already; cold runs evict them first (posix_fadvise, Linux only), which is what a
+// first launch after boot or an update pays.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Benchmarks.h"
+#include "AssetPack.h"
+#include "MappedFile.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+struct BenchAsset
+{
+	string name; // as named in the pack
+	string path;
+};
+
+// tag::evictFromCache[]
+// drop a file's pages from the OS file cache, so the next read comes from the disk; false where
+// that isn't possible
+bool evictFromCache(const string &path)
+{
+#ifdef __linux__
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		return false;
+	fdatasync(descriptor);
+	bool evicted = posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(descriptor);
+	return evicted;
+#else
+	(void)path;
+	return false;
+#endif
+}
+// end::evictFromCache[]
+
+// read a byte from every page, as the GPU driver copying the data out would
+uint64_t touchPages(const uint8_t *data, size_t size)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i < size; i += 4096)
+		sum += data[i];
+	return size > 0 ? sum + data[size - 1] : sum;
+}
+
+// tag::loadWays[]
+uint64_t loadWithStreams(const std::vector<BenchAsset> &assets)
+{
+	uint64_t sum = 0;
+	for (const BenchAsset &asset : assets)
+	{
+		std::ifstream file(asset.path, std::ios::in | std::ios::binary);
+		string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		sum += touchPages((const uint8_t *)bytes.data(), bytes.size());
+	}
+	return sum;
+}
+
+uint64_t loadMapped(const std::vector<BenchAsset> &assets)
+{
+	uint64_t sum = 0;
+	for (const BenchAsset &asset : assets)
+	{
+		MappedFile file;
+		if (file.open(asset.path))
+			sum += touchPages(file.data(), file.size());
+	}
+	return sum;
+}
+
+uint64_t loadFromPack(const std::vector<BenchAsset> &assets, const string &packPath)
+{
+	uint64_t sum = 0;
+	AssetPack pack;
+	string error;
+	if (!pack.open(packPath, error))
+		return 0;
+	for (const BenchAsset &asset : assets)
+	{
+		AssetView view = pack.find(asset.name);
+		sum += touchPages(view.data, view.size);
+	}
+	return sum;
+}
+// end::loadWays[]
+
+// tag::checkAssetPack[]
+bool checkAssetPack(const std::vector<BenchAsset> &assets, const string &packPath)
+{
+	AssetPack pack;
+	string error;
+	if (!pack.open(packPath, error))
+	{
+		cout << error << endl;
+		return false;
+	}
+
+	bool passed = pack.count() == (int)assets.size();
+	for (const BenchAsset &asset : assets)
+	{
+		MappedFile file;
+		AssetView view = pack.find(asset.name);
+		bool same = file.open(asset.path) && view && view.size == file.size() &&
+		            memcmp(view.data, file.data(), view.size) == 0 && (uintptr_t)view.data % 16 == 0;
+		if (!same)
+			cout << asset.name << " differs in the pack" << endl;
+		passed &= same;
+	}
+	passed &= !pack.find("not/in/the/pack");
+
+	// a pack cut short must be refused rather than read past its end
+	string truncatedPath = packPath + ".truncated";
+	{
+		MappedFile whole;
+		whole.open(packPath);
+		std::ofstream truncated(truncatedPath, std::ios::binary | std::ios::trunc);
+		truncated.write((const char *)whole.data(), whole.size() - 1);
+	}
+	AssetPack truncated;
+	passed &= !truncated.open(truncatedPath, error);
+	std::remove(truncatedPath.c_str());
+	return passed;
+}
+// end::checkAssetPack[]
+
+// tag::runAssetBench[]
+int runAssetBench(int argc, char *args[])
+{
+	string directory = "src/3D_Assignment/";
+	string font = "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf";
+	int runs = 20;
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--dir")
+		{
+			directory = args[i + 1];
+			if (directory.back() != '/' && directory.back() != '\\')
+				directory += '/';
+		}
+		else if (arg == "--font")
+			font = args[i + 1];
+		else if (arg == "--runs")
+			runs = std::max(1, atoi(args[i + 1]));
+	}
+
+	const char *NAMES[] = { "vertexShader.glsl", "fragmentShader.glsl", "textVertexShader.glsl", "textFragmentShader.glsl",
+	                        "transparencyVertexShader.glsl", "transparencyFragmentShader.glsl",
+	                        "models/paddle.obj", "models/paddle.mtl", "models/wall.obj", "models/wall.mtl",
+	                        "models/ball.obj", "models/ball.mtl", "models/paddle.png", "models/wall.png" };
+	std::vector<BenchAsset> assets;
+	std::vector<PackEntry> entries;
+	size_t totalBytes = 0;
+	for (const char *name : NAMES)
+		assets.push_back(BenchAsset{ name, directory + name });
+	if (fileStamp(font) != 0) // the font is optional, like in the game
+		assets.push_back(BenchAsset{ "font.ttf", font });
+	for (const BenchAsset &asset : assets)
+	{
+		MappedFile file;
+		if (!file.open(asset.path))
+		{
+			cout << "Could not read " << asset.path << " - run from the repository root, or give --dir" << endl;
+			return 1;
+		}
+		PackEntry entry;
+		entry.name = asset.name;
+		entry.bytes.assign((const char *)file.data(), file.size());
+		entries.push_back(entry);
+		totalBytes += file.size();
+	}
+
+	string packPath = "PongBench-assets.pak", error;
+	if (!writeAssetPack(packPath, entries, error))
+	{
+		cout << error << endl;
+		return 1;
+	}
+	bool passed = checkAssetPack(assets, packPath);
+	cout << assets.size() << " assets, " << totalBytes / 1024 << " KB - pack round trip " << (passed ? "OK" : "FAILED") << endl;
+
+	// cold runs can only be done where the cache can be dropped
+	bool canEvict = evictFromCache(packPath);
+	cout << endl << std::left << std::setw(22) << "" << std::right << std::setw(14) << "warm ms" << std::setw(14)
+	     << (canEvict ? "cold ms" : "") << endl;
+	cout << std::fixed << std::setprecision(3);
+
+	for (int way = 0; way < 3; way++)
+	{
+		const char *WAY_NAMES[] = { "ifstream per file", "mmap per file", "mmap asset pack" };
+		auto load = [&]() {
+			return way == 0 ? loadWithStreams(assets) : way == 1 ? loadMapped(assets) : loadFromPack(assets, packPath);
+		};
+
+		// medians, so one slow run from another process doesn't skew them
+		std::vector<double> warm, cold;
+		uint64_t sum = load(); // warm up
+		for (int run = 0; run < runs; run++)
+		{
+			auto start = steady_clock::now();
+			sum += load();
+			warm.push_back(duration_cast<nanoseconds>(steady_clock::now() - start).count() / 1e6);
+
+			if (canEvict)
+			{
+				if (way == 2)
+					evictFromCache(packPath);
+				else
+					for (const BenchAsset &asset : assets)
+						evictFromCache(asset.path);
+				start = steady_clock::now();
+				sum += load();
+				cold.push_back(duration_cast<nanoseconds>(steady_clock::now() - start).count() / 1e6);
+			}
+		}
+		std::sort(warm.begin(), warm.end());
+		std::sort(cold.begin(), cold.end());
+		cout << std::left << std::setw(22) << WAY_NAMES[way] << std::right << std::setw(14) << warm[warm.size() / 2];
+		if (canEvict)
+			cout << std::setw(14) << cold[cold.size() / 2];
+		cout << (sum == 0 ? " (no data)" : "") << endl;
+	}
+
+	std::remove(packPath.c_str());
+	return passed ? 0 : 1;
+}
+// end::runAssetBench[]
@@ -0,0 +1,15 @@
+#pragma once
+
+// Each PongBench mode is a function taking the arguments after the mode name and returning the
+// process exit code, so checks that fail make the whole run fail.
+
+int runFixedBench(int argc, char *args[]);
+int runHashBench(int argc, char *args[]);
+int runAIBench(int argc, char *args[]);
+int runEnvBench(int argc, char *args[]);
+int runControllerBench(int argc, char *args[]);
+int runOutcomeBench(int argc, char *args[]);
+int runAssetBench(int argc, char *args[]);
+int runMeshBench(int argc, char *args[]);
+int runLodBench(int argc, char *args[]);
+int runResolutionBench(int argc, char *args[]);
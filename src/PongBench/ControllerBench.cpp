@@ -0,0 +1,102 @@
+// PongBench controllers - what a decision costs at different batch sizes.
+//
+// A batch of one is what calling a controller per paddle per tick costs: a virtual call, and for
+// a plugin a call through a function pointer into another library plus converting the state.
+// Larger batches spread that over many matches until only the decisions themselves are left.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Benchmarks.h"
+#include "Controller.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+// tag::timeBatches[]
+// nanoseconds per decision when count matches are decided batchSize at a time
+double timeBatches(const Controller &controller, std::vector<FixedMatchState> &matches, std::vector<Random> &randoms,
+                   int batchSize, int repeats)
+{
+	int count = (int)matches.size();
+	std::vector<int> directions(count);
+	int sum = 0;
+
+	auto start = steady_clock::now();
+	for (int repeat = 0; repeat < repeats; repeat++)
+	{
+		for (int first = 0; first < count; first += batchSize)
+			controller.decide(&matches[first], std::min(batchSize, count - first), 1 + (repeat & 1), &randoms[first],
+			                  &directions[first]);
+		sum += directions[repeat % count];
+	}
+	double nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count() / ((double)count * repeats);
+
+	// use the results so the loops can't be optimised away
+	if (sum == 0x7fffffff)
+		cout << sum;
+	return nanos;
+}
+// end::timeBatches[]
+
+// tag::runControllerBench[]
+int runControllerBench(int argc, char *args[])
+{
+	std::vector<string> specs = { "predictive", "follow", "random" };
+	int matchCount = 4096;
+	int repeats = 200;
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--plugin")
+			specs.push_back(string("plugin:") + args[i + 1]);
+		else if (arg == "--matches")
+			matchCount = atoi(args[i + 1]);
+		else if (arg == "--repeats")
+			repeats = atoi(args[i + 1]);
+	}
+
+	// matches at different points of play
+	std::vector<FixedMatchState> matches(matchCount);
+	std::vector<Random> randoms(matchCount);
+	for (int i = 0; i < matchCount; i++)
+	{
+		randoms[i] = Random(i);
+		randomiseStart(matches[i], randoms[i]);
+		for (int tick = 0; tick < i % 1000; tick++)
+			stepMatchFixed(matches[i]);
+	}
+
+	const int BATCH_SIZES[] = { 1, 16, 256, 4096 };
+	cout << std::fixed << std::setprecision(2) << std::left << std::setw(24) << "ns per decision";
+	for (int batchSize : BATCH_SIZES)
+		cout << std::right << std::setw(12) << ("batch " + std::to_string(batchSize));
+	cout << endl;
+
+	for (const string &spec : specs)
+	{
+		string error;
+		std::unique_ptr<Controller> controller = createController(spec, error);
+		if (!controller)
+		{
+			cout << error << endl;
+			return 1;
+		}
+
+		cout << std::left << std::setw(24) << controller->name();
+		for (int batchSize : BATCH_SIZES)
+			cout << std::right << std::setw(12) << timeBatches(*controller, matches, randoms, batchSize, repeats);
+		cout << endl;
+	}
+
+	return 0;
+}
+// end::runControllerBench[]
@@ -0,0 +1,135 @@
+// PongBench env - throughput of the vectorised RL environment, and that it's deterministic.
+//
+// Steps the same seeds and actions through a one-thread and a many-thread VecEnv and checks
+// every observation, reward and done comes out identical, then times env steps per second.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Benchmarks.h"
+#include "VecEnv.h"
+#include "StateHash.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+// tag::runEnv[]
+// steps env with random actions, hashing everything it returns; returns the number of episodes finished
+int runEnv(VecEnv &env, int steps, uint64_t seed, uint64_t &hash, double &seconds)
+{
+	int count = env.size();
+	std::vector<uint64_t> seeds(count);
+	for (int i = 0; i < count; i++)
+		seeds[i] = seed + i;
+
+	std::vector<float> observations((size_t)count * VecEnv::OBSERVATION_SIZE);
+	std::vector<float> rewards(count);
+	std::vector<uint8_t> dones(count);
+	std::vector<int32_t> actions(count);
+
+	// actions are chosen before timing starts, so only the environment is measured
+	Random random(seed);
+	std::vector<int32_t> actionStream((size_t)count * 64);
+	for (int32_t &action : actionStream)
+		action = (int32_t)random.below(VecEnv::ACTION_COUNT);
+
+	env.reset(&seeds[0], &observations[0]);
+	hash = hashBytes(&observations[0], observations.size() * sizeof(float));
+
+	int episodes = 0;
+	seconds = 0;
+	for (int step = 0; step < steps; step++)
+	{
+		const int32_t *stepActions = &actionStream[(size_t)(step % 64) * count];
+
+		auto start = steady_clock::now();
+		env.step(stepActions, &observations[0], &rewards[0], &dones[0]);
+		seconds += duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+		hash = hashBytes(&observations[0], observations.size() * sizeof(float), hash);
+		hash = hashBytes(&rewards[0], rewards.size() * sizeof(float), hash);
+		hash = hashBytes(&dones[0], dones.size(), hash);
+		for (uint8_t done : dones)
+			episodes += done;
+	}
+	return episodes;
+}
+// end::runEnv[]
+
+// tag::runEnvBench[]
+int runEnvBench(int argc, char *args[])
+{
+	VecEnvConfig config;
+	config.envs = 4096;
+	int steps = 2000;
+	uint64_t seed = 1;
+	string opponentSpec = "predictive";
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--envs")
+			config.envs = atoi(args[i + 1]);
+		else if (arg == "--steps")
+			steps = atoi(args[i + 1]);
+		else if (arg == "--threads")
+			config.threads = atoi(args[i + 1]);
+		else if (arg == "--ticks-per-step")
+			config.ticksPerStep = atoi(args[i + 1]);
+		else if (arg == "--player")
+			config.agentPlayer = atoi(args[i + 1]);
+		else if (arg == "--seed")
+			seed = strtoull(args[i + 1], NULL, 10);
+		else if (arg == "--opponent")
+			opponentSpec = args[i + 1];
+	}
+
+	string error;
+	std::unique_ptr<Controller> opponent = createController(opponentSpec, error);
+	if (!opponent)
+	{
+		cout << error << endl;
+		return 1;
+	}
+	config.opponent = opponent.get();
+
+	bool passed = true;
+	cout << std::fixed;
+
+	// 1. the thread count makes no difference to the results
+	VecEnvConfig single = config;
+	single.threads = 1;
+	VecEnvConfig multi = config;
+	multi.threads = config.threads > 1 ? config.threads : 4;
+
+	// long enough for every environment to finish and auto-reset a few episodes
+	const int CHECK_STEPS = 3000;
+	uint64_t singleHash, multiHash;
+	double unused;
+	VecEnv singleEnv(single), multiEnv(multi);
+	int episodes = runEnv(singleEnv, CHECK_STEPS, seed, singleHash, unused);
+	runEnv(multiEnv, CHECK_STEPS, seed, multiHash, unused);
+	cout << "1 vs " << multi.threads << " threads over " << CHECK_STEPS << " steps (" << episodes << " episodes)"
+	     << (singleHash == multiHash ? " - identical" : " - DIFFERENT") << endl;
+	passed &= singleHash == multiHash;
+
+	// 2. throughput
+	VecEnv env(config);
+	uint64_t hash;
+	double seconds;
+	runEnv(env, steps, seed, hash, seconds);
+	double envSteps = (double)env.size() * steps;
+	int threads = config.threads > 0 ? config.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+	cout << std::setprecision(2) << env.size() << " envs x " << steps << " steps on " << threads << " threads: "
+	     << envSteps / seconds / 1e6 << "M env-steps/s, " << envSteps * config.ticksPerStep / seconds / 1e6 << "M ticks/s" << endl;
+
+	return passed ? 0 : 1;
+}
+// end::runEnvBench[]
@@ -0,0 +1,181 @@
+// PongBench fixed - runs one input stream through the float and fixed point rules.
+//
+// The fixed point rules can't match the float ones bit for bit (the float game doesn't even agree
+// with itself across machines), so the check is that both paths track each other closely until
+// they first make a different discrete decision (a bounce or a point), and that the fixed point
+// path lands on exactly the state recorded below, which any machine must reproduce.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include "Benchmarks.h"
+#include "Simulation.h"
+#include "FixedSimulation.h"
+#include "Replay.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+// tag::golden[]
+// the fixed point state after GOLDEN_TICKS ticks of makeInputStream(GOLDEN_SEED, GOLDEN_TICKS)
+const uint64_t GOLDEN_SEED = 2016;
+const int GOLDEN_TICKS = 100000;
+const int32_t GOLDEN_PADDLE1_X = 22883;
+const int32_t GOLDEN_PADDLE2_X = 12115;
+const int32_t GOLDEN_BALL_X = -41472;
+const int32_t GOLDEN_BALL_Z = -41472;
+const int GOLDEN_PLAYER1_SCORE = 114;
+const int GOLDEN_PLAYER2_SCORE = 117;
+// end::golden[]
+
+FixedMatchState runFixed(const std::vector<TickInput> &inputs)
+{
+	FixedMatchState match;
+	for (const TickInput &input : inputs)
+	{
+		match.paddle1Direction = input.paddle1;
+		match.paddle2Direction = input.paddle2;
+		stepMatchFixed(match);
+	}
+	return match;
+}
+
+// tag::compareFloatAndFixed[]
+// returns the largest position difference seen before the paths first disagree on a discrete event
+float compareFloatAndFixed(const std::vector<TickInput> &inputs, int &firstDivergence)
+{
+	const double FLOAT_TICK = 1.0 / FIXED_TICK_RATE;
+
+	MatchState floatMatch;
+	FixedMatchState fixedMatch;
+	float largestDifference = 0;
+	firstDivergence = -1;
+
+	for (size_t tick = 0; tick < inputs.size(); tick++)
+	{
+		floatMatch.paddle1Direction = inputs[tick].paddle1;
+		floatMatch.paddle2Direction = inputs[tick].paddle2;
+		fixedMatch.paddle1Direction = inputs[tick].paddle1;
+		fixedMatch.paddle2Direction = inputs[tick].paddle2;
+
+		stepMatch(floatMatch, FLOAT_TICK);
+		stepMatchFixed(fixedMatch);
+
+		MatchState converted;
+		toMatchState(fixedMatch, converted);
+
+		if (converted.player1Score != floatMatch.player1Score || converted.player2Score != floatMatch.player2Score ||
+		    converted.ballDirection != floatMatch.ballDirection)
+		{
+			firstDivergence = (int)tick;
+			break;
+		}
+
+		float difference = std::max(std::max(fabsf(converted.paddle1Position.x - floatMatch.paddle1Position.x),
+		                                      fabsf(converted.paddle2Position.x - floatMatch.paddle2Position.x)),
+		                             std::max(fabsf(converted.ballPosition.x - floatMatch.ballPosition.x),
+		                                      fabsf(converted.ballPosition.z - floatMatch.ballPosition.z)));
+		largestDifference = std::max(largestDifference, difference);
+	}
+
+	return largestDifference;
+}
+// end::compareFloatAndFixed[]
+
+// tag::timePaths[]
+// nanoseconds per match per tick for each path, over many matches so the loop looks like a server's
+void timePaths(int matchCount, int ticks, double &floatNanos, double &fixedNanos)
+{
+	std::vector<TickInput> inputs = makeInputStream(1, ticks);
+	const double FLOAT_TICK = 1.0 / FIXED_TICK_RATE;
+
+	std::vector<MatchState> floatMatches(matchCount);
+	auto start = steady_clock::now();
+	for (int tick = 0; tick < ticks; tick++)
+		for (MatchState &match : floatMatches)
+		{
+			match.paddle1Direction = inputs[tick].paddle1;
+			match.paddle2Direction = inputs[tick].paddle2;
+			stepMatch(match, FLOAT_TICK);
+		}
+	floatNanos = duration_cast<nanoseconds>(steady_clock::now() - start).count() / ((double)matchCount * ticks);
+
+	std::vector<FixedMatchState> fixedMatches(matchCount);
+	start = steady_clock::now();
+	for (int tick = 0; tick < ticks; tick++)
+		for (FixedMatchState &match : fixedMatches)
+		{
+			match.paddle1Direction = inputs[tick].paddle1;
+			match.paddle2Direction = inputs[tick].paddle2;
+			stepMatchFixed(match);
+		}
+	fixedNanos = duration_cast<nanoseconds>(steady_clock::now() - start).count() / ((double)matchCount * ticks);
+
+	// use the results so the loops can't be optimised away
+	int scores = 0;
+	for (size_t i = 0; i < floatMatches.size(); i++)
+		scores += floatMatches[i].player1Score + fixedMatches[i].player1Score;
+	if (scores < 0)
+		cout << scores;
+}
+// end::timePaths[]
+
+// tag::runFixedBench[]
+int runFixedBench(int argc, char *args[])
+{
+	int matchCount = 1024;
+	int ticks = 2000;
+	uint64_t seed = 1;
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--matches")
+			matchCount = atoi(args[i + 1]);
+		else if (arg == "--ticks")
+			ticks = atoi(args[i + 1]);
+		else if (arg == "--seed")
+			seed = strtoull(args[i + 1], NULL, 10);
+	}
+
+	bool passed = true;
+	cout << std::fixed;
+
+	// 1. the fixed point path reproduces the recorded state exactly
+	FixedMatchState golden = runFixed(makeInputStream(GOLDEN_SEED, GOLDEN_TICKS));
+	bool goldenMatches = golden.paddle1X.raw == GOLDEN_PADDLE1_X && golden.paddle2X.raw == GOLDEN_PADDLE2_X &&
+	                     golden.ballX.raw == GOLDEN_BALL_X && golden.ballZ.raw == GOLDEN_BALL_Z &&
+	                     golden.player1Score == GOLDEN_PLAYER1_SCORE && golden.player2Score == GOLDEN_PLAYER2_SCORE;
+	cout << "golden state after " << GOLDEN_TICKS << " ticks: paddles " << golden.paddle1X.raw << " " << golden.paddle2X.raw
+	     << " ball " << golden.ballX.raw << " " << golden.ballZ.raw << " score " << golden.player1Score << "-"
+	     << golden.player2Score << (goldenMatches ? " - OK" : " - MISMATCH, fixed point is not bit-exact here") << endl;
+	passed &= goldenMatches;
+
+	// 2. float and fixed follow the same input stream to the same place
+	std::vector<TickInput> inputs = makeInputStream(seed, ticks * 10);
+	int firstDivergence;
+	float largestDifference = compareFloatAndFixed(inputs, firstDivergence);
+	const float TOLERANCE = 0.01f;
+	cout << std::setprecision(6) << "float vs fixed: largest position difference " << largestDifference << " over "
+	     << (firstDivergence == -1 ? (int)inputs.size() : firstDivergence) << " ticks";
+	if (firstDivergence != -1)
+		cout << " (then a bounce or point went differently at tick " << firstDivergence << ")";
+	cout << (largestDifference <= TOLERANCE ? " - OK" : " - FAILED") << endl;
+	passed &= largestDifference <= TOLERANCE;
+
+	// 3. the cost of each
+	double floatNanos, fixedNanos;
+	timePaths(matchCount, ticks, floatNanos, fixedNanos);
+	cout << std::setprecision(2) << "float " << floatNanos << " ns/step, fixed " << fixedNanos << " ns/step ("
+	     << fixedNanos / floatNanos << "x) over " << matchCount << " matches x " << ticks << " ticks" << endl;
+
+	return passed ? 0 : 1;
+}
+// end::runFixedBench[]
@@ -0,0 +1,182 @@
+// PongBench hash - the cost of hashing the state every tick, and that hash logs find a desync.
+//
+// Records a match into a replay, writes it out and reads it back, and checks the re-simulation
+// reproduces every tick's hash. Then runs two peers from the same inputs with one of them nudged
+// by a single Q16.16 unit, and checks the logs point at exactly that tick. With --replay it
+// verifies a file recorded by `3D_Assignment --record-replay` instead.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Benchmarks.h"
+#include "StateHash.h"
+#include "Replay.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+// tag::checkTestVectors[]
+// hashBytes has to be XXH64 itself, so hashes can be checked by other tools
+bool checkTestVectors()
+{
+	struct TestVector
+	{
+		const char *input;
+		uint64_t seed;
+		uint64_t expected;
+	};
+	const TestVector VECTORS[] = {
+		{ "", 0, 0xEF46DB3751D8E999ULL },
+		{ "a", 0, 0xD24EC4F1A98C6E5BULL },
+		{ "abc", 0, 0x44BC2CF5AD770999ULL },
+		{ "Nobody inspects the spammish repetition", 0, 0xFBCEA83C8A378BF1ULL },
+	};
+
+	bool passed = true;
+	for (const TestVector &vector : VECTORS)
+		passed &= hashBytes(vector.input, strlen(vector.input), vector.seed) == vector.expected;
+	return passed;
+}
+// end::checkTestVectors[]
+
+// tag::timeHashing[]
+// nanoseconds per hash of a state, over states that change like a real match's
+template <typename State>
+double timeHashing(const std::vector<State> &states, int repeats, uint64_t &combined)
+{
+	auto start = steady_clock::now();
+	for (int repeat = 0; repeat < repeats; repeat++)
+		for (const State &state : states)
+			combined += hashMatchState(state);
+	return duration_cast<nanoseconds>(steady_clock::now() - start).count() / ((double)states.size() * repeats);
+}
+// end::timeHashing[]
+
+// tag::runPeers[]
+// two peers run the same inputs, but peer 2's ball is one raw unit off from tick nudgeTick on
+int64_t runPeers(const std::vector<TickInput> &inputs, int nudgeTick)
+{
+	FixedMatchState peer1, peer2;
+	HashLog log1, log2;
+
+	for (size_t tick = 0; tick < inputs.size(); tick++)
+	{
+		peer1.paddle1Direction = peer2.paddle1Direction = inputs[tick].paddle1;
+		peer1.paddle2Direction = peer2.paddle2Direction = inputs[tick].paddle2;
+		stepMatchFixed(peer1);
+		stepMatchFixed(peer2);
+		if ((int)tick == nudgeTick)
+			peer2.ballX.raw += 1;
+
+		log1.record(hashMatchState(peer1));
+		log2.record(hashMatchState(peer2));
+	}
+
+	return findFirstDivergence(log1, log2);
+}
+// end::runPeers[]
+
+int verifyReplayFile(const char *path)
+{
+	Replay replay;
+	if (!loadReplay(path, replay))
+	{
+		cout << "could not read a replay from " << path << endl;
+		return 1;
+	}
+
+	HashLog resimulated;
+	FixedMatchState end;
+	int64_t divergence = verifyReplay(replay, resimulated, end);
+	cout << path << ": " << replay.inputs.size() << " ticks, final score " << end.player1Score << "-" << end.player2Score;
+	if (divergence == -1)
+		cout << " - reproduced exactly" << endl;
+	else
+		cout << " - DESYNC, first different state at tick " << divergence << endl;
+	return divergence == -1 ? 0 : 1;
+}
+
+// tag::runHashBench[]
+int runHashBench(int argc, char *args[])
+{
+	int ticks = 100000;
+	uint64_t seed = 1;
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--ticks")
+			ticks = atoi(args[i + 1]);
+		else if (arg == "--seed")
+			seed = strtoull(args[i + 1], NULL, 10);
+		else if (arg == "--replay")
+			return verifyReplayFile(args[i + 1]);
+	}
+
+	bool passed = true;
+	cout << std::fixed;
+
+	// 1. the hash is XXH64
+	bool vectorsMatch = checkTestVectors();
+	cout << "XXH64 test vectors" << (vectorsMatch ? " - OK" : " - MISMATCH") << endl;
+	passed &= vectorsMatch;
+
+	// 2. record a replay, round trip it through a file and re-simulate it
+	std::vector<TickInput> inputs = makeInputStream(seed, ticks);
+	Replay replay;
+	FixedMatchState recorded;
+	std::vector<FixedMatchState> fixedStates;
+	fixedStates.reserve(inputs.size());
+	for (const TickInput &input : inputs)
+	{
+		stepAndRecord(replay, recorded, input);
+		fixedStates.push_back(recorded);
+	}
+
+	const char *REPLAY_PATH = "PongBench_hash.replay";
+	Replay loaded;
+	bool roundTrip = saveReplay(REPLAY_PATH, replay) && loadReplay(REPLAY_PATH, loaded);
+	remove(REPLAY_PATH);
+
+	HashLog resimulated;
+	FixedMatchState end;
+	int64_t replayDivergence = roundTrip ? verifyReplay(loaded, resimulated, end) : 0;
+	bool replayMatches = roundTrip && replayDivergence == -1 && hashMatchState(end) == hashMatchState(recorded);
+	cout << "replay of " << ticks << " ticks (" << ticks * 6 / 1024 << "KB) re-simulated";
+	if (!roundTrip)
+		cout << " - FAILED, could not write and read " << REPLAY_PATH << endl;
+	else if (replayDivergence != -1)
+		cout << " - FAILED, first different state at tick " << replayDivergence << endl;
+	else
+		cout << (replayMatches ? " - OK" : " - FAILED, end state differs") << endl;
+	passed &= replayMatches;
+
+	// 3. a one unit desync between peers is found on the tick it happens
+	int nudgeTick = ticks / 2;
+	int64_t peerDivergence = runPeers(inputs, nudgeTick);
+	cout << "peers nudged at tick " << nudgeTick << ", logs first differ at tick " << peerDivergence
+	     << (peerDivergence == nudgeTick ? " - OK" : " - FAILED") << endl;
+	passed &= peerDivergence == nudgeTick;
+
+	// 4. the cost per hash
+	std::vector<MatchState> floatStates(fixedStates.size());
+	for (size_t i = 0; i < fixedStates.size(); i++)
+		toMatchState(fixedStates[i], floatStates[i]);
+
+	uint64_t combined = 0;
+	int repeats = std::max(1, 1000000 / std::max(ticks, 1));
+	double fixedNanos = timeHashing(fixedStates, repeats, combined);
+	double floatNanos = timeHashing(floatStates, repeats, combined);
+	cout << std::setprecision(2) << "hash: fixed state " << fixedNanos << " ns, float state " << floatNanos << " ns"
+	     << (combined == 1 ? " " : "") << endl;
+
+	return passed ? 0 : 1;
+}
+// end::runHashBench[]
@@ -0,0 +1,364 @@
+// PongBench meshes - what the mesh optimizer (MeshOptimizer.h) does for high-poly models.
+//
+// The game's own models are a few cubes, so this generates spheres (convex, like a ball) and tori
+// (which hide parts of themselves, like anything more interesting) with their triangles shuffled,
+// as an exporter that knows nothing about caches might write them. Each is run through the
+// import-time passes in turn and measured after each: ACMR and ATVR through a 16-entry FIFO
+// cache, and overdraw - pixels shaded per pixel covered - rasterized in software with the depth
+// test and back-face culling, looking along each axis from both sides. Checks every pass keeps
+// every triangle and its winding, and that cache optimization actually lowers the ACMR.
+//
+// PongBench lods - the level of detail chains the mesh simplifier (MeshSimplifier.h) makes of the
+// same meshes, the way the game builds them for its models: triangles, error and time for each
+// level. Checks each level is smaller than the last, stays within the error limit, and - the
+// meshes being closed around their centre - has no triangle turned inwards.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <limits>
+
+#include "Benchmarks.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Random.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+struct BenchMesh
+{
+	string name;
+	std::vector<float> positions; // x, y, z per vertex
+	std::vector<uint16_t> indices;
+};
+
+// tag::generateMeshes[]
+// a grid of segments x rings quads over a parametric surface, wound counter-clockwise seen from
+// outside
+template <typename Surface>
+BenchMesh gridMesh(const string &name, int segments, int rings, Surface surface)
+{
+	BenchMesh mesh;
+	mesh.name = name;
+	for (int ring = 0; ring <= rings; ring++)
+		for (int segment = 0; segment <= segments; segment++)
+		{
+			float point[3];
+			surface((float)segment / segments, (float)ring / rings, point);
+			mesh.positions.insert(mesh.positions.end(), point, point + 3);
+		}
+	for (int ring = 0; ring < rings; ring++)
+		for (int segment = 0; segment < segments; segment++)
+		{
+			uint16_t a = (uint16_t)(ring * (segments + 1) + segment), b = (uint16_t)(a + 1);
+			uint16_t c = (uint16_t)(a + segments + 1), d = (uint16_t)(c + 1);
+			uint16_t quad[6] = { a, b, d, a, d, c };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	return mesh;
+}
+
+BenchMesh sphere(const string &name, int segments, int rings)
+{
+	return gridMesh(name, segments, rings, [](float u, float v, float *point) {
+		float theta = u * 6.2831853f, phi = v * 3.1415927f;
+		point[0] = std::sin(phi) * std::cos(theta);
+		point[1] = -std::cos(phi);
+		point[2] = -std::sin(phi) * std::sin(theta);
+	});
+}
+
+BenchMesh torus(const string &name, int segments, int rings)
+{
+	return gridMesh(name, segments, rings, [](float u, float v, float *point) {
+		float theta = u * 6.2831853f, phi = v * 6.2831853f;
+		float radius = 1 + 0.4f * std::cos(phi);
+		point[0] = radius * std::cos(theta);
+		point[1] = 0.4f * std::sin(phi);
+		point[2] = -radius * std::sin(theta);
+	});
+}
+
+// the triangles in random order, each keeping its winding
+void shuffleTriangles(std::vector<uint16_t> &indices, Random &random)
+{
+	for (size_t triangle = indices.size() / 3 - 1; triangle > 0; triangle--)
+	{
+		size_t other = random.below((uint32_t)triangle + 1);
+		for (int corner = 0; corner < 3; corner++)
+			std::swap(indices[triangle * 3 + corner], indices[other * 3 + corner]);
+	}
+}
+// end::generateMeshes[]
+
+// tag::analyzeOverdraw[]
+// pixels shaded per pixel covered, drawn in index order with the depth test and back faces culled,
+// seen orthographically along each axis from both sides
+float analyzeOverdraw(const std::vector<float> &positions, const std::vector<uint16_t> &indices)
+{
+	const int SIZE = 256;
+
+	float low[3] = { 1e30f, 1e30f, 1e30f }, high[3] = { -1e30f, -1e30f, -1e30f };
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		low[i % 3] = std::min(low[i % 3], positions[i]);
+		high[i % 3] = std::max(high[i % 3], positions[i]);
+	}
+	float extent = std::max(high[0] - low[0], std::max(high[1] - low[1], high[2] - low[2]));
+
+	long long shaded = 0, covered = 0;
+	std::vector<float> depth(SIZE * SIZE);
+	for (int axis = 0; axis < 3; axis++)
+		for (float side = -1; side <= 1; side += 2)
+		{
+			std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::infinity());
+			int uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+			for (size_t triangle = 0; triangle < indices.size() / 3; triangle++)
+			{
+				const float *p[3];
+				for (int corner = 0; corner < 3; corner++)
+					p[corner] = &positions[indices[triangle * 3 + corner] * 3];
+
+				// facing the viewer, who is off towards side along axis
+				float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+				float e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+				float normal = e1[(axis + 1) % 3] * e2[(axis + 2) % 3] - e1[(axis + 2) % 3] * e2[(axis + 1) % 3];
+				if (normal * side <= 0)
+					continue;
+
+				float x[3], y[3], z[3];
+				for (int corner = 0; corner < 3; corner++)
+				{
+					x[corner] = (p[corner][uAxis] - low[uAxis]) / extent * SIZE;
+					y[corner] = (p[corner][vAxis] - low[vAxis]) / extent * SIZE;
+					z[corner] = -side * p[corner][axis]; // nearer the viewer is smaller
+				}
+				float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+				if (area == 0)
+					continue;
+
+				int minX = std::max(0, (int)std::floor(std::min(x[0], std::min(x[1], x[2]))));
+				int maxX = std::min(SIZE - 1, (int)std::ceil(std::max(x[0], std::max(x[1], x[2]))));
+				int minY = std::max(0, (int)std::floor(std::min(y[0], std::min(y[1], y[2]))));
+				int maxY = std::min(SIZE - 1, (int)std::ceil(std::max(y[0], std::max(y[1], y[2]))));
+				for (int py = minY; py <= maxY; py++)
+					for (int px = minX; px <= maxX; px++)
+					{
+						float cx = px + 0.5f, cy = py + 0.5f;
+						float w0 = ((x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1])) / area;
+						float w1 = ((x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2])) / area;
+						float w2 = 1 - w0 - w1;
+						if (w0 < 0 || w1 < 0 || w2 < 0)
+							continue;
+						float fragmentDepth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+						float &stored = depth[py * SIZE + px];
+						if (fragmentDepth < stored)
+						{
+							stored = fragmentDepth;
+							shaded++;
+						}
+					}
+			}
+			for (float stored : depth)
+				covered += stored != std::numeric_limits<float>::infinity();
+		}
+	return covered > 0 ? (float)shaded / covered : 0;
+}
+// end::analyzeOverdraw[]
+
+// each triangle rotated to start at its smallest index, so the same triangles in any order and
+// from any starting corner compare equal once sorted
+std::vector<uint64_t> triangleSet(const std::vector<uint16_t> &indices)
+{
+	std::vector<uint64_t> triangles;
+	for (size_t triangle = 0; triangle < indices.size() / 3; triangle++)
+	{
+		const uint16_t *t = &indices[triangle * 3];
+		int first = t[0] <= t[1] && t[0] <= t[2] ? 0 : t[1] <= t[2] ? 1 : 2;
+		triangles.push_back((uint64_t)t[first] << 32 | (uint64_t)t[(first + 1) % 3] << 16 | t[(first + 2) % 3]);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+// tag::runMeshBench[]
+int runMeshBench(int argc, char *args[])
+{
+	float threshold = 1.05f;
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--threshold")
+			threshold = (float)atof(args[i + 1]);
+	}
+
+	std::vector<BenchMesh> meshes;
+	meshes.push_back(sphere("sphere", 32, 16));
+	meshes.push_back(sphere("sphere", 128, 64));
+	meshes.push_back(torus("torus", 64, 64));
+	meshes.push_back(torus("torus", 128, 128));
+
+	cout << std::left << std::setw(10) << "mesh" << std::right << std::setw(10) << "triangles" << "  " << std::left
+	     << std::setw(14) << "order" << std::right << std::setw(8) << "ACMR" << std::setw(8) << "ATVR" << std::setw(10)
+	     << "overdraw" << std::setw(10) << "ms" << endl;
+	cout << std::fixed;
+
+	bool passed = true;
+	Random random(1);
+	for (BenchMesh &mesh : meshes)
+	{
+		size_t vertexCount = mesh.positions.size() / 3;
+		shuffleTriangles(mesh.indices, random);
+		std::vector<uint64_t> original = triangleSet(mesh.indices);
+
+		VertexCacheStats shuffled = analyzeVertexCache(mesh.indices, vertexCount);
+		VertexCacheStats stats = shuffled;
+		for (int pass = 0; pass < 3; pass++)
+		{
+			const char *PASS_NAMES[] = { "shuffled", "vertex cache", "+ overdraw" };
+			auto start = steady_clock::now();
+			if (pass == 1)
+				optimizeVertexCache(mesh.indices, vertexCount);
+			else if (pass == 2)
+				optimizeOverdraw(mesh.indices, &mesh.positions[0], vertexCount, 3 * sizeof(float), threshold);
+			double milliseconds = duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0;
+
+			if (pass > 0)
+			{
+				stats = analyzeVertexCache(mesh.indices, vertexCount);
+				if (triangleSet(mesh.indices) != original)
+				{
+					cout << mesh.name << ": " << PASS_NAMES[pass] << " lost or changed triangles" << endl;
+					passed = false;
+				}
+			}
+
+			cout << std::left << std::setw(10) << (pass == 0 ? mesh.name : "") << std::right << std::setw(10);
+			if (pass == 0)
+				cout << mesh.indices.size() / 3;
+			else
+				cout << "";
+			cout << "  " << std::left << std::setw(14) << PASS_NAMES[pass] << std::right << std::setprecision(3)
+			     << std::setw(8) << stats.acmr << std::setw(8) << stats.atvr << std::setw(10)
+			     << analyzeOverdraw(mesh.positions, mesh.indices) << std::setw(10);
+			if (pass == 0)
+				cout << "" << endl;
+			else
+				cout << std::setprecision(2) << milliseconds << endl;
+		}
+
+		if (stats.acmr >= shuffled.acmr)
+		{
+			cout << mesh.name << ": optimizing didn't lower the ACMR" << endl;
+			passed = false;
+		}
+	}
+
+	cout << "\nAll passes kept every triangle: " << (passed ? "OK" : "FAILED") << endl;
+	return passed ? 0 : 1;
+}
+// end::runMeshBench[]
+
+// tag::runLodBench[]
+int runLodBench(int argc, char *args[])
+{
+	int maxLods = 4;
+	float maxError = 0.05f;
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--levels")
+			maxLods = std::max(1, atoi(args[i + 1]));
+		else if (arg == "--error")
+			maxError = (float)atof(args[i + 1]);
+	}
+
+	std::vector<BenchMesh> meshes;
+	meshes.push_back(sphere("sphere", 48, 24));
+	meshes.push_back(sphere("sphere", 128, 64));
+	meshes.push_back(torus("torus", 64, 64));
+	meshes.push_back(torus("torus", 128, 128));
+
+	cout << std::left << std::setw(10) << "mesh" << std::right << std::setw(8) << "level" << std::setw(12) << "triangles"
+	     << std::setw(10) << "error" << std::setw(10) << "ACMR" << std::setw(10) << "ms" << endl;
+	cout << std::fixed;
+
+	bool passed = true;
+	for (const BenchMesh &mesh : meshes)
+	{
+		size_t vertexCount = mesh.positions.size() / 3;
+		auto start = steady_clock::now();
+		std::vector<float> errors;
+		std::vector<std::vector<uint16_t>> levels =
+		    simplifyLods(mesh.indices, &mesh.positions[0], vertexCount, 3 * sizeof(float), maxLods, maxError, errors);
+		double milliseconds = duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0;
+
+		for (size_t level = 0; level < levels.size(); level++)
+		{
+			std::vector<uint16_t> &indices = levels[level];
+			optimizeVertexCache(indices, vertexCount);
+
+			// the sphere and torus both have their centre at the origin; a triangle facing it is turned
+			// inwards (the torus's inner side faces the ring through its tube, not the origin)
+			int inwards = 0;
+			for (size_t triangle = 0; triangle < indices.size() / 3; triangle++)
+			{
+				const float *p[3];
+				for (int corner = 0; corner < 3; corner++)
+					p[corner] = &mesh.positions[indices[triangle * 3 + corner] * 3];
+				float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+				float e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+				float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				float centre[3] = { 0, 0, 0 };
+				for (int axis = 0; axis < 3; axis++)
+					centre[axis] = (p[0][axis] + p[1][axis] + p[2][axis]) / 3;
+				if (mesh.name == "torus")
+				{
+					float ring = std::sqrt(centre[0] * centre[0] + centre[2] * centre[2]);
+					centre[0] -= ring > 0 ? centre[0] / ring : 0;
+					centre[2] -= ring > 0 ? centre[2] / ring : 0;
+				}
+				// the slivers at the grid's poles face nowhere in particular
+				float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				if (area > 1e-6f && normal[0] * centre[0] + normal[1] * centre[1] + normal[2] * centre[2] < 0)
+					inwards++;
+			}
+
+			cout << std::left << std::setw(10) << (level == 0 ? mesh.name : "") << std::right << std::setw(8) << level
+			     << std::setw(12) << indices.size() / 3 << std::setprecision(4) << std::setw(10) << errors[level]
+			     << std::setprecision(3) << std::setw(10) << analyzeVertexCache(indices, vertexCount).acmr << std::setw(10);
+			if (level == 0)
+				cout << std::setprecision(2) << milliseconds << endl;
+			else
+				cout << "" << endl;
+
+			if (inwards > 0)
+			{
+				cout << mesh.name << ": level " << level << " has " << inwards << " triangles turned inwards" << endl;
+				passed = false;
+			}
+			if (errors[level] > maxError)
+			{
+				cout << mesh.name << ": level " << level << " is further from the surface than allowed" << endl;
+				passed = false;
+			}
+		}
+		if ((int)levels.size() < std::min(maxLods, 2))
+		{
+			cout << mesh.name << ": didn't simplify at all" << endl;
+			passed = false;
+		}
+	}
+
+	cout << "\nEvery level within the error limit and facing out: " << (passed ? "OK" : "FAILED") << endl;
+	return passed ? 0 : 1;
+}
+// end::runLodBench[]
@@ -0,0 +1,160 @@
+// PongBench outcome - the live win probability estimator in OutcomeEstimator.h.
+//
+// Checks that estimates made from short rollouts and chained points agree with playing whole
+// matches out from the same positions, then times estimates at different latency budgets and
+// shows how many rollouts each gets and how much its answer wanders from call to call.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "Benchmarks.h"
+#include "OutcomeEstimator.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+// tag::outcomePositions[]
+struct Position
+{
+	const char *name;
+	FixedMatchState match;
+};
+
+std::vector<Position> outcomePositions()
+{
+	std::vector<Position> positions;
+
+	FixedMatchState start;
+	positions.push_back({ "0:0 serve", start });
+
+	FixedMatchState ahead;
+	ahead.player1Score = 3;
+	ahead.player2Score = 1;
+	positions.push_back({ "3:1 serve", ahead });
+
+	// player 2 is on match point, but the ball is about to get past them
+	FixedMatchState breakPoint;
+	breakPoint.player1Score = 2;
+	breakPoint.player2Score = 4;
+	breakPoint.ballX = Fixed::fromRatio(9, 10);
+	breakPoint.ballZ = Fixed::fromRatio(-3, 2);
+	breakPoint.ballDirectionX = 1;
+	breakPoint.ballDirectionZ = -1;
+	breakPoint.paddle2X = Fixed::fromRatio(-4, 5);
+	positions.push_back({ "2:4 ball past player 2", breakPoint });
+
+	FixedMatchState rally;
+	rally.player1Score = 4;
+	rally.player2Score = 4;
+	rally.ballX = Fixed::fromRatio(-1, 2);
+	rally.ballZ = Fixed::fromRatio(1, 2);
+	rally.ballDirectionX = -1;
+	rally.ballDirectionZ = 1;
+	rally.paddle1X = Fixed::fromRatio(1, 2);
+	positions.push_back({ "4:4 mid rally", rally });
+
+	return positions;
+}
+// end::outcomePositions[]
+
+// tag::runOutcomeBench[]
+int runOutcomeBench(int argc, char *args[])
+{
+	OutcomeConfig config;
+	int referenceRollouts = 1000;
+	int estimatesPerBudget = 50;
+	string player1Spec = "predictive", player2Spec = "predictive";
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--threads")
+			config.threads = atoi(args[i + 1]);
+		else if (arg == "--lapses1")
+			config.player1LapsesPerSecond = (float)atof(args[i + 1]);
+		else if (arg == "--lapses2")
+			config.player2LapsesPerSecond = (float)atof(args[i + 1]);
+		else if (arg == "--player1")
+			player1Spec = args[i + 1];
+		else if (arg == "--player2")
+			player2Spec = args[i + 1];
+		else if (arg == "--reference")
+			referenceRollouts = atoi(args[i + 1]);
+		else if (arg == "--estimates")
+			estimatesPerBudget = atoi(args[i + 1]);
+		else if (arg == "--seed")
+			config.seed = strtoull(args[i + 1], NULL, 10);
+	}
+
+	string error;
+	std::unique_ptr<Controller> player1 = createController(player1Spec, error);
+	std::unique_ptr<Controller> player2 = player1 ? createController(player2Spec, error) : nullptr;
+	if (!player1 || !player2)
+	{
+		cout << error << endl;
+		return 1;
+	}
+	config.player1 = player1.get();
+	config.player2 = player2.get();
+
+	bool passed = true;
+	cout << std::fixed << std::setprecision(3);
+
+	// 1. chained points agree with whole matches, to within the reference's sampling error plus a
+	// little for assuming every later point is like the one after the live point
+	OutcomeConfig unlimited = config;
+	unlimited.budgetMilliseconds = 1e9;
+	unlimited.maxRollouts = 20000;
+	OutcomeEstimator checker(unlimited);
+	for (const Position &position : outcomePositions())
+	{
+		OutcomeEstimate estimate = checker.estimate(position.match);
+		OutcomeEstimate reference = checker.playOut(position.match, referenceRollouts, config.seed);
+		double p = reference.player1WinProbability;
+		double tolerance = 3 * sqrt(std::max(p * (1 - p), 0.01) / referenceRollouts) + 0.03;
+		bool agrees = fabs(estimate.player1WinProbability - p) <= tolerance;
+		cout << std::left << std::setw(24) << position.name << std::right << " player 1 wins "
+		     << estimate.player1WinProbability << " (whole matches " << p << "), expected score "
+		     << std::setprecision(2) << estimate.expectedPlayer1Score << ":" << estimate.expectedPlayer2Score << " ("
+		     << reference.expectedPlayer1Score << ":" << reference.expectedPlayer2Score << ")" << std::setprecision(3)
+		     << (agrees ? "" : " - DIFFERENT") << endl;
+		passed &= agrees;
+	}
+
+	// 2. latency and precision at a range of budgets
+	cout << endl << std::left << std::setw(12) << "budget ms" << std::right << std::setw(12) << "mean ms" << std::setw(12)
+	     << "worst ms" << std::setw(12) << "rollouts" << std::setw(12) << "spread" << endl;
+	const double BUDGETS[] = { 1, 2, 5, 10 };
+	const Position position = outcomePositions()[3];
+	for (double budget : BUDGETS)
+	{
+		OutcomeConfig timed = config;
+		timed.budgetMilliseconds = budget;
+		OutcomeEstimator estimator(timed);
+
+		double totalMilliseconds = 0, worstMilliseconds = 0, rollouts = 0, sum = 0, sumSquares = 0;
+		for (int i = 0; i < estimatesPerBudget; i++)
+		{
+			OutcomeEstimate estimate = estimator.estimate(position.match);
+			totalMilliseconds += estimate.milliseconds;
+			worstMilliseconds = std::max(worstMilliseconds, estimate.milliseconds);
+			rollouts += estimate.rollouts;
+			sum += estimate.player1WinProbability;
+			sumSquares += estimate.player1WinProbability * estimate.player1WinProbability;
+		}
+		double mean = sum / estimatesPerBudget;
+		double spread = sqrt(std::max(0.0, sumSquares / estimatesPerBudget - mean * mean));
+		cout << std::left << std::setw(12) << budget << std::right << std::setw(12) << totalMilliseconds / estimatesPerBudget
+		     << std::setw(12) << worstMilliseconds << std::setw(12) << (int)(rollouts / estimatesPerBudget) << std::setw(12)
+		     << spread << endl;
+	}
+
+	return passed ? 0 : 1;
+}
+// end::runOutcomeBench[]
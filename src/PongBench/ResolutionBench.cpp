@@ -0,0 +1,144 @@
+// PongBench resolution - the dynamic resolution controller (ResolutionController.h) holding a
+// frame time budget against a simulated renderer.
+//
+// The simulated scene costs a fixed amount plus an amount per pixel, so it scales with the square
+// of the render scale, with some noise on every frame. Its timings reach the controller a few
+// frames late, as GPU timer queries do. The load steps between phases - normal, heavy, more than
+// the smallest scale can cope with, then light - and each phase shows where the scale settled,
+// how long it took to get there and the render time it held. Checks the scale stops moving in
+// the second half of every phase (no oscillation) and holds render time inside the band: under
+// the budget unless the scale is already as low as it goes, and not far under unless it is as
+// high as it goes.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Benchmarks.h"
+#include "ResolutionController.h"
+#include "Random.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+// frames between the scene being drawn and its timer query being read
+const int QUERY_LAG = 3;
+
+// tag::resolutionPhases[]
+struct LoadPhase
+{
+	const char *name;
+	float load; // multiplies the per-pixel cost
+};
+
+const LoadPhase LOAD_PHASES[] = {
+	{ "normal", 1.0f },
+	{ "heavy", 2.5f },
+	{ "overload", 20.0f },
+	{ "light", 0.4f },
+};
+// end::resolutionPhases[]
+
+// tag::runResolutionBench[]
+int runResolutionBench(int argc, char *args[])
+{
+	ResolutionConfig config;
+	int phaseFrames = 300;
+	float noise = 0.05f;
+	double fixedMilliseconds = 1, pixelMilliseconds = 10; // at full scale and normal load
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		string arg = args[i];
+		if (arg == "--budget")
+			config.budgetMilliseconds = atof(args[i + 1]);
+		else if (arg == "--frames")
+			phaseFrames = std::max(2 * QUERY_LAG, atoi(args[i + 1]));
+		else if (arg == "--noise")
+			noise = (float)atof(args[i + 1]);
+	}
+
+	cout << "Simulated scene: " << fixedMilliseconds << " ms + " << pixelMilliseconds << " ms x scale^2 x load, "
+	     << noise * 100 << "% noise, timings " << QUERY_LAG << " frames late\n";
+	cout << "Budget " << config.budgetMilliseconds << " ms, holding above " << config.budgetMilliseconds * config.lowFraction
+	     << " ms, scale " << config.minScale << " to " << config.maxScale << "\n\n";
+	cout << std::left << std::setw(10) << "phase" << std::right << std::setw(8) << "load" << std::setw(10) << "scale"
+	     << std::setw(12) << "render ms" << std::setw(10) << "changes" << std::setw(14) << "settled after" << endl;
+
+	ResolutionController controller(config);
+	Random random(1);
+	std::vector<double> inFlight(QUERY_LAG, 0); // timings not read back yet, oldest first
+	bool passed = true;
+
+	for (const LoadPhase &phase : LOAD_PHASES)
+	{
+		int changesBefore = controller.getStats().changes;
+		int lastChange = 0, lateChanges = 0;
+		double lateMilliseconds = 0;
+		for (int frame = 0; frame < phaseFrames; frame++)
+		{
+			float scale = controller.scale();
+			double jitter = 1 + noise * (2 * random.uniform() - 1);
+			double milliseconds = (fixedMilliseconds + pixelMilliseconds * scale * scale * phase.load) * jitter;
+			inFlight.push_back(milliseconds);
+			double read = inFlight.front();
+			inFlight.erase(inFlight.begin());
+			if (frame < QUERY_LAG && read == 0)
+				continue; // nothing drawn yet
+
+			if (controller.update(read) != scale)
+			{
+				lastChange = frame;
+				if (frame >= phaseFrames / 2)
+					lateChanges++;
+			}
+			if (frame >= phaseFrames / 2)
+				lateMilliseconds += milliseconds;
+		}
+		lateMilliseconds /= phaseFrames - phaseFrames / 2;
+
+		float scale = controller.scale();
+		cout << std::left << std::setw(10) << phase.name << std::right << std::setw(8) << phase.load
+		     << std::fixed << std::setprecision(2) << std::setw(10) << scale << std::setw(12) << lateMilliseconds
+		     << std::setw(10) << controller.getStats().changes - changesBefore << std::setw(14)
+		     << (std::to_string(lastChange) + " frames") << std::defaultfloat << endl;
+
+		if (lateChanges > 0)
+		{
+			cout << phase.name << ": the scale was still moving in the second half of the phase" << endl;
+			passed = false;
+		}
+		if (lateMilliseconds > config.budgetMilliseconds * (1 + noise) && scale > config.minScale)
+		{
+			cout << phase.name << ": over budget without being at the lowest scale" << endl;
+			passed = false;
+		}
+		if (lateMilliseconds < config.budgetMilliseconds * config.lowFraction * (1 - noise) && scale < config.maxScale)
+		{
+			cout << phase.name << ": well under budget without being at the highest scale" << endl;
+			passed = false;
+		}
+	}
+
+	// what a decision costs the game each frame
+	const int CALLS = 1000000;
+	ResolutionController timed(config);
+	Random timedRandom(2);
+	auto start = high_resolution_clock::now();
+	for (int i = 0; i < CALLS; i++)
+		timed.update(config.budgetMilliseconds * (0.5 + timedRandom.uniform()));
+	double perUpdate = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / (double)CALLS;
+
+	const ResolutionStats &stats = controller.getStats();
+	cout << "\n" << stats.measurements << " measurements, " << stats.overBudget << " over budget, " << stats.changes
+	     << " changes, scale " << stats.lowestScale << " to " << stats.highestScale << endl;
+	cout << std::setprecision(3) << perUpdate << " ns per update" << endl;
+	cout << "\nScale settled in every phase, render time held in the band: " << (passed ? "OK" : "FAILED") << endl;
+	return passed ? 0 : 1;
+}
+// end::runResolutionBench[]
@@ -0,0 +1,60 @@
+// Headless benchmarks and checks for the shared game rules in src/common.
+//
+// Usage: PongBench <mode> [options]
+
+#include <iostream>
+#include <string>
+#include <cstring>
+
+#include "Benchmarks.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+// tag::modes[]
+struct Mode
+{
+	const char *name;
+	int (*run)(int argc, char *args[]);
+	const char *description;
+};
+
+const Mode MODES[] = {
+	{ "fixed", runFixedBench, "compare the fixed point rules with the float rules, check they are bit-exact, and time both" },
+	{ "hash", runHashBench, "check state hashes reproduce through a replay and pinpoint a desync, and time hashing (--replay <file> verifies a recording)" },
+	{ "ai", runAIBench, "check the predictive computer player's predictions and results, and time its decisions" },
+	{ "env", runEnvBench, "check the vectorised RL environment gives the same results on any thread count, and time env steps" },
+	{ "controllers", runControllerBench, "time controller decisions at different batch sizes (--plugin <path> adds a plugin)" },
+	{ "outcome", runOutcomeBench, "check live win probability estimates against whole matches played out, and time them at different latency budgets" },
+	{ "assets", runAssetBench, "check the asset pack round trip, and time loading the game's assets from loose files and from a pack, warm and cold (--dir <game directory>)" },
+	{ "meshes", runMeshBench, "check the mesh optimizer keeps every triangle, and measure ACMR, ATVR and overdraw after each pass on high-poly meshes (--threshold <overdraw threshold>)" },
+	{ "lods", runLodBench, "check the mesh simplifier's levels of detail stay within their error and face out, and time building them (--levels <count> --error <relative error>)" },
+	{ "resolution", runResolutionBench, "check the dynamic resolution controller settles and holds a frame time budget as a simulated renderer's load changes (--budget <ms> --frames <per phase> --noise <fraction>)" },
+};
+// end::modes[]
+
+void printUsage(const char *exeName)
+{
+	cout << "Usage: " << exeName << " <mode> [options]\n\nModes:\n";
+	for (const Mode &mode : MODES)
+		cout << "  " << mode.name << " - " << mode.description << "\n";
+}
+
+// tag::main[]
+int main(int argc, char *args[])
+{
+	if (argc < 2)
+	{
+		printUsage(args[0]);
+		return 1;
+	}
+
+	for (const Mode &mode : MODES)
+		if (strcmp(args[1], mode.name) == 0)
+			return mode.run(argc - 2, args + 2);
+
+	printUsage(args[0]);
+	return 1;
+}
+// end::main[]
@@ -0,0 +1,49 @@
+// An example paddle controller plugin, built as a shared library against PongPlugin.h only.
+//
+// It follows the ball while the ball is coming towards it, and drifts back to the middle while
+// the ball is heading away - better than following all the time, worse than predicting.
+//
+//     PongTournament predictive follow plugin:./libPongExamplePlugin.so
+
+#include "PongPlugin.h"
+
+#ifdef _WIN32
+#define PONG_EXPORT extern "C" __declspec(dllexport)
+#else
+#define PONG_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+const int32_t ONE = 65536;           // 1.0 in Q16.16
+const int32_t DEAD_ZONE = ONE / 16;  // close enough to the target not to move
+
+static float towards(int32_t from, int32_t to)
+{
+	if (to < from - DEAD_ZONE)
+		return -1.0f;
+	if (to > from + DEAD_ZONE)
+		return 1.0f;
+	return 0.0f;
+}
+
+PONG_EXPORT int pong_plugin_abi_version(void)
+{
+	return PONG_PLUGIN_ABI_VERSION;
+}
+
+PONG_EXPORT const char *pong_plugin_name(void)
+{
+	return "example-returner";
+}
+
+PONG_EXPORT void pong_decide(const PongState *states, int n, float *out)
+{
+	for (int i = 0; i < n; i++)
+	{
+		const PongState &state = states[i];
+		int32_t paddleX = state.player == 1 ? state.paddle1X : state.paddle2X;
+		int32_t paddleZ = state.player == 1 ? state.paddle1Z : state.paddle2Z;
+
+		bool approaching = (paddleZ > state.ballZ) == (state.ballDirectionZ > 0);
+		out[i] = towards(paddleX, approaching ? state.ballX : 0);
+	}
+}
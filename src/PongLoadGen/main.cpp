@@ -0,0 +1,496 @@
+// Load generator for PongServer - simulates thousands of players and spectators over loopback.
+//
+// Each worker thread owns a slice of the players and drives them from one epoll loop:
+// players connect, get paired into matches by the server, read the state stream and
+// steer their paddle towards the ball at a fixed input rate. Spectators subscribe to one
+// match and decode its snapshot stream, checking it never skips a tick between keyframes.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#include "Protocol.h"
+#include "Snapshot.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+// tag::LoadConfig[]
+struct LoadConfig
+{
+	string host = "127.0.0.1";
+	unsigned short port = DEFAULT_SERVER_PORT;
+	int players = 1000;
+	int threads = 0;     // 0 means one per core
+	int inputRate = 20;  // inputs each player sends per second
+	int duration = 10;   // seconds, 0 runs until interrupted
+
+	int spectators = 0;
+	unsigned short spectatorPort = 0; // 0 means port + 1
+	uint32_t watchMatch = 0;          // match id the spectators watch, see makeMatchId
+};
+// end::LoadConfig[]
+
+struct Player
+{
+	int fd = -1;
+	bool connected = false;
+	int playerIndex = 0; // 0 until the server puts us in a match
+	MatchState view;     // what the server last told us
+	std::vector<uint8_t> inBuffer;
+	std::vector<uint8_t> outBuffer; // what the socket hasn't taken yet, sent on EPOLLOUT
+	bool wantsWrite = false;        // EPOLLOUT is registered
+
+	bool spectator = false;
+	SnapshotDecoder decoder;
+};
+
+// totals across all worker threads
+std::atomic<bool> stopLoad(false);
+std::atomic<uint64_t> playersConnected(0);
+std::atomic<uint64_t> playersInMatch(0);
+std::atomic<uint64_t> connectFailures(0);
+std::atomic<uint64_t> disconnects(0);
+std::atomic<uint64_t> statesReceived(0);
+std::atomic<uint64_t> inputsSent(0);
+std::atomic<uint64_t> bytesReceived(0);
+std::atomic<uint64_t> spectatorsWatching(0);
+std::atomic<uint64_t> snapshotsReceived(0);
+std::atomic<uint64_t> keyframesReceived(0);
+std::atomic<uint64_t> snapshotGaps(0); // deltas that didn't follow on, should only happen after the server drops a backlog
+
+void handleSignal(int)
+{
+	stopLoad = true;
+}
+
+static bool setNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+// tag::readPlayer[]
+// returns false if the player lost its connection
+bool readPlayer(Player &player)
+{
+	uint8_t buffer[4096];
+	while (true)
+	{
+		ssize_t received = recv(player.fd, buffer, sizeof(buffer), 0);
+		if (received > 0)
+		{
+			bytesReceived += received;
+			player.inBuffer.insert(player.inBuffer.end(), buffer, buffer + received);
+			continue;
+		}
+		if (received == -1 && errno == EINTR)
+			continue;
+		if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		return false;
+	}
+
+	size_t offset = 0;
+	uint64_t states = 0;
+	uint64_t snapshots = 0;
+	uint64_t keyframes = 0;
+	uint64_t gaps = 0;
+	while (offset < player.inBuffer.size())
+	{
+		int size = messageSize(player.inBuffer[offset]);
+		if (size == 0)
+			return false;
+		if (offset + size > player.inBuffer.size())
+			break;
+
+		const uint8_t *message = &player.inBuffer[offset];
+		if (message[0] == MSG_MATCH_START)
+		{
+			if (player.playerIndex == 0)
+				playersInMatch++;
+			player.playerIndex = message[1];
+		}
+		else if (message[0] == MSG_STATE)
+		{
+			decodeState(message, player.view);
+			states++;
+		}
+		else if (message[0] == MSG_KEYFRAME || message[0] == MSG_DELTA)
+		{
+			bool wasSynced = player.decoder.synced();
+			if (!player.decoder.apply(message) && wasSynced)
+				gaps++;
+			snapshots++;
+			keyframes += message[0] == MSG_KEYFRAME;
+		}
+		offset += size;
+	}
+	player.inBuffer.erase(player.inBuffer.begin(), player.inBuffer.begin() + offset);
+	statesReceived += states;
+	snapshotsReceived += snapshots;
+	keyframesReceived += keyframes;
+	snapshotGaps += gaps;
+	return true;
+}
+// end::readPlayer[]
+
+// tag::flushPlayer[]
+// sends as much of the player's queued output as the socket will take, and asks epoll for
+// EPOLLOUT while any is left, so a message that doesn't fit is finished later rather than cut
+// short - the server would misread everything after it. Returns false if the connection failed
+bool flushPlayer(int epollFd, Player &player, uint32_t id)
+{
+	size_t offset = 0;
+	while (offset < player.outBuffer.size())
+	{
+		ssize_t written = send(player.fd, &player.outBuffer[offset], player.outBuffer.size() - offset, MSG_NOSIGNAL);
+		if (written > 0)
+		{
+			offset += written;
+			continue;
+		}
+		if (written == -1 && errno == EINTR)
+			continue;
+		if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		return false;
+	}
+	player.outBuffer.erase(player.outBuffer.begin(), player.outBuffer.begin() + offset);
+
+	bool wantsWrite = !player.outBuffer.empty();
+	if (wantsWrite != player.wantsWrite)
+	{
+		player.wantsWrite = wantsWrite;
+		epoll_event event;
+		event.events = EPOLLIN | (wantsWrite ? (uint32_t)EPOLLOUT : 0u);
+		event.data.u32 = id;
+		epoll_ctl(epollFd, EPOLL_CTL_MOD, player.fd, &event);
+	}
+	return true;
+}
+// end::flushPlayer[]
+
+// tag::sendInputs[]
+// every player steers towards where the ball was last seen
+void sendInputs(int epollFd, std::vector<Player> &players, uint32_t tick)
+{
+	uint8_t message[INPUT_MESSAGE_SIZE];
+	uint64_t sent = 0;
+
+	for (Player &player : players)
+	{
+		if (!player.connected || player.playerIndex == 0)
+			continue;
+
+		float paddleX = player.playerIndex == 1 ? player.view.paddle1Position.x : player.view.paddle2Position.x;
+		float offset = player.view.ballPosition.x - paddleX;
+		int direction = offset < -PADDLE_WIDTH / 4 ? -1 : (offset > PADDLE_WIDTH / 4 ? 1 : 0);
+
+		// queued behind anything still waiting, so inputs stay whole and in order; a failed
+		// connection shows up as EPOLLERR/EPOLLHUP and is closed there
+		encodeInput(message, direction, tick);
+		player.outBuffer.insert(player.outBuffer.end(), message, message + sizeof(message));
+		if (!player.wantsWrite)
+			flushPlayer(epollFd, player, (uint32_t)(&player - &players[0]));
+		sent++;
+	}
+
+	inputsSent += sent;
+}
+// end::sendInputs[]
+
+// tag::runWorker[]
+void runWorker(const LoadConfig &config, int playerCount, int spectatorCount)
+{
+	int epollFd = epoll_create1(0);
+	std::vector<Player> players(playerCount + spectatorCount);
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	inet_pton(AF_INET, config.host.c_str(), &address.sin_addr);
+
+	for (int i = 0; i < (int)players.size(); i++)
+	{
+		Player &player = players[i];
+		player.spectator = i >= playerCount;
+		address.sin_port = htons(player.spectator ? config.spectatorPort : config.port);
+
+		player.fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (player.fd == -1)
+		{
+			connectFailures++;
+			continue;
+		}
+		setNonBlocking(player.fd);
+		int one = 1;
+		setsockopt(player.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		if (connect(player.fd, (sockaddr *)&address, sizeof(address)) == -1 && errno != EINPROGRESS)
+		{
+			connectFailures++;
+			close(player.fd);
+			player.fd = -1;
+			continue;
+		}
+
+		// writable means the connection finished, one way or the other
+		epoll_event event;
+		event.events = EPOLLIN | EPOLLOUT;
+		event.data.u32 = i;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, player.fd, &event);
+	}
+
+	int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	itimerspec interval;
+	long inputNanos = 1000000000L / config.inputRate;
+	interval.it_interval.tv_sec = inputNanos / 1000000000L;
+	interval.it_interval.tv_nsec = inputNanos % 1000000000L;
+	interval.it_value = interval.it_interval;
+	timerfd_settime(timerFd, 0, &interval, NULL);
+
+	const uint32_t TIMER_ID = 0xffffffff;
+	epoll_event timerEvent;
+	timerEvent.events = EPOLLIN;
+	timerEvent.data.u32 = TIMER_ID;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &timerEvent);
+
+	uint32_t tick = 0;
+	epoll_event events[256];
+	while (!stopLoad)
+	{
+		int count = epoll_wait(epollFd, events, 256, 100);
+		for (int e = 0; e < count; e++)
+		{
+			if (events[e].data.u32 == TIMER_ID)
+			{
+				uint64_t expirations;
+				if (read(timerFd, &expirations, sizeof(expirations)) == sizeof(expirations))
+					sendInputs(epollFd, players, tick++);
+				continue;
+			}
+
+			Player &player = players[events[e].data.u32];
+			if (player.fd == -1)
+				continue;
+
+			bool lost = (events[e].events & (EPOLLERR | EPOLLHUP)) != 0;
+
+			if (!lost && !player.connected && (events[e].events & EPOLLOUT))
+			{
+				int error = 0;
+				socklen_t length = sizeof(error);
+				getsockopt(player.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+				if (error == 0)
+				{
+					player.connected = true;
+					epoll_event event;
+					event.events = EPOLLIN;
+					event.data.u32 = events[e].data.u32;
+					epoll_ctl(epollFd, EPOLL_CTL_MOD, player.fd, &event);
+
+					if (player.spectator)
+					{
+						uint8_t message[SPECTATE_MESSAGE_SIZE];
+						encodeSpectate(message, config.watchMatch);
+						player.outBuffer.insert(player.outBuffer.end(), message, message + sizeof(message));
+						lost = !flushPlayer(epollFd, player, events[e].data.u32);
+						spectatorsWatching++;
+					}
+					else
+						playersConnected++;
+				}
+				else
+				{
+					connectFailures++;
+					lost = true;
+				}
+			}
+			else if (!lost && (events[e].events & EPOLLOUT))
+				lost = !flushPlayer(epollFd, player, events[e].data.u32);
+
+			if (!lost && (events[e].events & EPOLLIN))
+				lost = !readPlayer(player);
+
+			if (lost)
+			{
+				if (player.connected)
+				{
+					disconnects++;
+					if (player.spectator)
+						spectatorsWatching--;
+					else
+						playersConnected--;
+					if (player.playerIndex != 0)
+						playersInMatch--;
+				}
+				epoll_ctl(epollFd, EPOLL_CTL_DEL, player.fd, NULL);
+				close(player.fd);
+				player.fd = -1;
+				player.connected = false;
+				player.outBuffer.clear();
+				player.wantsWrite = false;
+			}
+		}
+	}
+
+	for (Player &player : players)
+		if (player.fd != -1)
+			close(player.fd);
+	close(timerFd);
+	close(epollFd);
+}
+// end::runWorker[]
+
+void printUsage(const char *exeName)
+{
+	cout << "Usage: " << exeName << " [options]\n"
+	     << "  --host ADDRESS    server address (default 127.0.0.1)\n"
+	     << "  --port N          server port (default " << DEFAULT_SERVER_PORT << ")\n"
+	     << "  --players N       simulated players, two per match (default 1000)\n"
+	     << "  --threads N       worker threads, 0 for one per core (default 0)\n"
+	     << "  --input-rate N    inputs per player per second (default 20)\n"
+	     << "  --duration N      seconds to run, 0 to run until interrupted (default 10)\n"
+	     << "  --spectators N    spectators watching one match (default 0)\n"
+	     << "  --spectator-port N  server spectator port (default port + 1)\n"
+	     << "  --watch-match ID  match id the spectators watch, shard << 20 | match (default 0)\n";
+}
+
+bool parseArguments(int argc, char *args[], LoadConfig &config)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = args[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--host" && hasValue)
+			config.host = args[++i];
+		else if (arg == "--port" && hasValue)
+			config.port = (unsigned short)atoi(args[++i]);
+		else if (arg == "--players" && hasValue)
+			config.players = atoi(args[++i]);
+		else if (arg == "--threads" && hasValue)
+			config.threads = atoi(args[++i]);
+		else if (arg == "--input-rate" && hasValue)
+			config.inputRate = atoi(args[++i]);
+		else if (arg == "--duration" && hasValue)
+			config.duration = atoi(args[++i]);
+		else if (arg == "--spectators" && hasValue)
+			config.spectators = atoi(args[++i]);
+		else if (arg == "--spectator-port" && hasValue)
+			config.spectatorPort = (unsigned short)atoi(args[++i]);
+		else if (arg == "--watch-match" && hasValue)
+			config.watchMatch = (uint32_t)strtoul(args[++i], NULL, 0);
+		else
+			return false;
+	}
+
+	if (config.spectatorPort == 0)
+		config.spectatorPort = config.port + 1;
+
+	return config.players >= 0 && config.spectators >= 0 && config.players + config.spectators > 0 &&
+	       config.threads >= 0 && config.inputRate > 0;
+}
+
+// tag::main[]
+int main(int argc, char *args[])
+{
+	LoadConfig config;
+	if (!parseArguments(argc, args, config))
+	{
+		printUsage(args[0]);
+		return 1;
+	}
+
+	signal(SIGINT, handleSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+		if ((int)limit.rlim_cur < config.players + config.spectators + 64)
+			cerr << "Warning: file descriptor limit " << limit.rlim_cur << " is too low for "
+			     << config.players + config.spectators << " connections" << endl;
+	}
+
+	int threadCount = config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::thread> threads;
+	for (int i = 0; i < threadCount; i++)
+	{
+		int playerCount = config.players / threadCount + (i < config.players % threadCount ? 1 : 0);
+		int spectatorCount = config.spectators / threadCount + (i < config.spectators % threadCount ? 1 : 0);
+		threads.push_back(std::thread(runWorker, std::cref(config), playerCount, spectatorCount));
+	}
+
+	cout << "Connecting " << config.players << " players and " << config.spectators << " spectators to "
+	     << config.host << ":" << config.port << " from " << threadCount << " threads" << endl;
+
+	auto start = steady_clock::now();
+	uint64_t lastStates = 0;
+	uint64_t lastInputs = 0;
+	uint64_t lastBytes = 0;
+	uint64_t lastSnapshots = 0;
+	cout << std::fixed << std::setprecision(0);
+	while (!stopLoad)
+	{
+		std::this_thread::sleep_for(seconds(1));
+
+		uint64_t states = statesReceived;
+		uint64_t inputs = inputsSent;
+		uint64_t bytes = bytesReceived;
+		cout << "connected " << playersConnected << " in match " << playersInMatch << " failed " << connectFailures
+		     << " disconnected " << disconnects << " | states/s " << states - lastStates << " inputs/s " << inputs - lastInputs
+		     << " KiB/s " << (bytes - lastBytes) / 1024.0;
+		if (config.spectators > 0)
+		{
+			uint64_t snapshots = snapshotsReceived;
+			cout << " | watching " << spectatorsWatching << " snapshots/s " << snapshots - lastSnapshots
+			     << " keyframes " << keyframesReceived << " gaps " << snapshotGaps;
+			lastSnapshots = snapshots;
+		}
+		cout << endl;
+		lastStates = states;
+		lastInputs = inputs;
+		lastBytes = bytes;
+
+		if (config.duration > 0 && steady_clock::now() - start >= seconds(config.duration))
+			stopLoad = true;
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	double elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+	cout << "Received " << statesReceived << " states (" << statesReceived / elapsed << "/s), sent "
+	     << inputsSent << " inputs (" << inputsSent / elapsed << "/s)";
+	if (config.spectators > 0)
+		cout << ", " << snapshotsReceived << " snapshots (" << snapshotsReceived / elapsed << "/s, "
+		     << keyframesReceived << " keyframes, " << snapshotGaps << " gaps)";
+	cout << endl;
+	return 0;
+}
+// end::main[]
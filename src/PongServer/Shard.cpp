@@ -0,0 +1,506 @@
+#include "Shard.h"
+#include "SpectatorHub.h"
+#include "PaddleAI.h"
+
+#include <iostream>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using namespace std::chrono;
+
+const size_t MAX_PENDING_BYTES = 16 * 1024; // stop queueing states for a player who is this far behind
+const uint64_t MAX_CATCH_UP_TICKS = 4;      // never simulate more than this many ticks per timer wake-up
+const int MAX_EVENTS = 256;
+
+static bool setNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+Shard::Shard(int index, const ServerConfig &config, int localMatches, SpectatorHub *hub)
+	: index(index), config(config), localMatchCount(localMatches), hub(hub)
+{
+}
+
+Shard::~Shard()
+{
+	for (auto &entry : connections)
+		close(entry.first);
+	if (timerFd != -1)
+		close(timerFd);
+	if (listenFd != -1)
+		close(listenFd);
+	if (epollFd != -1)
+		close(epollFd);
+}
+
+// tag::open[]
+bool Shard::open()
+{
+	epollFd = epoll_create1(0);
+	if (epollFd == -1)
+	{
+		cerr << "Shard " << index << ": epoll_create1 failed: " << strerror(errno) << endl;
+		return false;
+	}
+
+	// every shard listens on the same port, the kernel balances new connections between them
+	listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	int one = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(config.port);
+
+	if (bind(listenFd, (sockaddr *)&address, sizeof(address)) == -1 || listen(listenFd, 1024) == -1 || !setNonBlocking(listenFd))
+	{
+		cerr << "Shard " << index << ": could not listen on port " << config.port << ": " << strerror(errno) << endl;
+		return false;
+	}
+
+	// the fixed tick
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	itimerspec interval;
+	long tickNanos = 1000000000L / config.tickRate;
+	interval.it_interval.tv_sec = tickNanos / 1000000000L;
+	interval.it_interval.tv_nsec = tickNanos % 1000000000L;
+	interval.it_value = interval.it_interval;
+	if (timerFd == -1 || timerfd_settime(timerFd, 0, &interval, NULL) == -1)
+	{
+		cerr << "Shard " << index << ": could not create tick timer: " << strerror(errno) << endl;
+		return false;
+	}
+
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = listenFd;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+	event.data.fd = timerFd;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event);
+
+	for (int i = 0; i < localMatchCount; i++)
+	{
+		int matchIndex = createMatch();
+		matches[matchIndex].local = true;
+		// spread the balls out so the matches don't all score on the same tick
+		matches[matchIndex].state.ballPosition.x = (i % 7 - 3) * 0.15f;
+		fromMatchState(matches[matchIndex].state, matches[matchIndex].fixedState);
+	}
+
+	return true;
+}
+// end::open[]
+
+// tag::run[]
+void Shard::run(const std::atomic<bool> &stop)
+{
+	epoll_event events[MAX_EVENTS];
+
+	while (!stop)
+	{
+		int count = epoll_wait(epollFd, events, MAX_EVENTS, 100); // wake up now and then to check stop
+		if (count == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			cerr << "Shard " << index << ": epoll_wait failed: " << strerror(errno) << endl;
+			break;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			int fd = events[i].data.fd;
+
+			if (fd == timerFd)
+			{
+				uint64_t expirations = 0;
+				if (read(timerFd, &expirations, sizeof(expirations)) == sizeof(expirations) && expirations > 0)
+					tick(expirations);
+			}
+			else if (fd == listenFd)
+			{
+				acceptPlayers();
+			}
+			else
+			{
+				auto found = connections.find(fd);
+				if (found == connections.end() || found->second.closing)
+					continue;
+
+				Connection &connection = found->second;
+				if (events[i].events & (EPOLLHUP | EPOLLERR))
+					dropPlayer(connection);
+				if (!connection.closing && (events[i].events & EPOLLIN))
+					readPlayer(connection);
+				if (!connection.closing && (events[i].events & EPOLLOUT))
+					flushPlayer(connection);
+			}
+		}
+
+		for (int fd : closingFds)
+			closePlayer(fd);
+		closingFds.clear();
+	}
+}
+// end::run[]
+
+// tag::tick[]
+void Shard::tick(uint64_t expirations)
+{
+	auto tickStart = steady_clock::now();
+	const double TICK_DELTA = 1.0 / config.tickRate;
+
+	// if we fell behind, catch up a little rather than stretching the tick
+	uint64_t steps = std::min(expirations, MAX_CATCH_UP_TICKS);
+
+	for (uint64_t step = 0; step < steps; step++)
+	{
+		for (Match &match : matches)
+		{
+			if (!match.active)
+				continue;
+
+			if (match.local)
+			{
+				// server-side bots just follow the ball
+				match.state.paddle1Direction = (float)followBallDirection(match.state.paddle1Position.x, match.state.ballPosition.x);
+				match.state.paddle2Direction = (float)followBallDirection(match.state.paddle2Position.x, match.state.ballPosition.x);
+			}
+
+			if (config.fixedPoint)
+			{
+				match.fixedState.paddle1Direction = (int)match.state.paddle1Direction;
+				match.fixedState.paddle2Direction = (int)match.state.paddle2Direction;
+				stepMatchFixed(match.fixedState);
+				toMatchState(match.fixedState, match.state);
+			}
+			else
+				stepMatch(match.state, TICK_DELTA);
+			match.tick++;
+		}
+	}
+
+	// send the latest state, encoded once per match and shared by both players
+	uint8_t message[STATE_MESSAGE_SIZE];
+	uint64_t dropped = 0;
+	uint64_t sent = 0;
+	for (Match &match : matches)
+	{
+		if (!match.active || match.local)
+			continue;
+
+		encodeState(message, match.state, match.tick);
+		int players[2] = { match.player1Fd, match.player2Fd };
+		for (int fd : players)
+		{
+			Connection &connection = connections.find(fd)->second;
+			if (connection.closing)
+				continue;
+			if (connection.outBuffer.size() - connection.outSent > MAX_PENDING_BYTES)
+			{
+				dropped++;
+				continue;
+			}
+			queueMessage(connection, message, STATE_MESSAGE_SIZE);
+			sent += STATE_MESSAGE_SIZE;
+		}
+	}
+
+	publishSnapshots();
+
+	uint32_t tickNanos = (uint32_t)duration_cast<nanoseconds>(steady_clock::now() - tickStart).count();
+
+	int activeMatches = 0;
+	int localMatches = 0;
+	for (const Match &match : matches)
+	{
+		activeMatches += match.active;
+		localMatches += match.active && match.local;
+	}
+
+	std::lock_guard<std::mutex> lock(reportMutex);
+	report.tickNanos.push_back(tickNanos);
+	report.ticks += steps;
+	report.lateTicks += expirations - 1;
+	report.droppedStates += dropped;
+	report.bytesSent += sent;
+	report.activeMatches = activeMatches;
+	report.localMatches = localMatches;
+	report.players = (int)connections.size();
+}
+// end::tick[]
+
+// tag::publishSnapshots[]
+// encode each watched match once and hand the shared snapshot to the spectator hub
+void Shard::publishSnapshots()
+{
+	hub->watchedMatches(index, watchedVersion, watchedMatches);
+
+	for (int matchIndex : watchedMatches)
+	{
+		if (matchIndex >= (int)matches.size() || !matches[matchIndex].active)
+			continue;
+
+		auto encoder = spectatorEncoders.find(matchIndex);
+		if (encoder == spectatorEncoders.end())
+			encoder = spectatorEncoders.insert(std::make_pair(matchIndex, SnapshotEncoder(config.keyframeInterval))).first;
+
+		const Match &match = matches[matchIndex];
+		snapshots.push_back(std::make_pair(makeMatchId(index, matchIndex), encoder->second.encode(match.state, match.tick)));
+	}
+
+	hub->publish(snapshots);
+}
+// end::publishSnapshots[]
+
+ShardReport Shard::takeReport()
+{
+	std::lock_guard<std::mutex> lock(reportMutex);
+	ShardReport taken = std::move(report);
+	report = ShardReport();
+	report.activeMatches = taken.activeMatches;
+	report.localMatches = taken.localMatches;
+	report.players = taken.players;
+	return taken;
+}
+
+// tag::acceptPlayers[]
+void Shard::acceptPlayers()
+{
+	while (true)
+	{
+		int fd = accept(listenFd, NULL, NULL);
+		if (fd == -1)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				cerr << "Shard " << index << ": accept failed: " << strerror(errno) << endl;
+			return;
+		}
+
+		setNonBlocking(fd);
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // states are tiny and latency matters
+
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+		Connection &connection = connections[fd];
+		connection.fd = fd;
+
+		pairPlayer(fd);
+	}
+}
+// end::acceptPlayers[]
+
+void Shard::pairPlayer(int fd)
+{
+	auto waiting = connections.find(waitingFd);
+	if (waiting == connections.end() || waiting->second.closing || waitingFd == fd)
+	{
+		waitingFd = fd;
+		return;
+	}
+
+	int opponent = waitingFd;
+	waitingFd = -1;
+	startMatch(createMatch(), opponent, fd);
+}
+
+int Shard::createMatch()
+{
+	int matchIndex;
+	if (!freeMatches.empty())
+	{
+		matchIndex = freeMatches.back();
+		freeMatches.pop_back();
+		matches[matchIndex] = Match();
+	}
+	else
+	{
+		matchIndex = (int)matches.size();
+		matches.push_back(Match());
+	}
+	matches[matchIndex].active = true;
+	spectatorEncoders.erase(matchIndex); // a new match in an old slot starts with a keyframe
+	return matchIndex;
+}
+
+void Shard::startMatch(int matchIndex, int player1Fd, int player2Fd)
+{
+	Match &match = matches[matchIndex];
+	match.player1Fd = player1Fd;
+	match.player2Fd = player2Fd;
+
+	uint8_t message[MATCH_START_MESSAGE_SIZE];
+	int players[2] = { player1Fd, player2Fd };
+	for (int i = 0; i < 2; i++)
+	{
+		Connection &connection = connections[players[i]];
+		connection.match = matchIndex;
+		connection.playerIndex = i + 1;
+		encodeMatchStart(message, i + 1);
+		queueMessage(connection, message, MATCH_START_MESSAGE_SIZE);
+	}
+}
+
+// tag::readPlayer[]
+void Shard::readPlayer(Connection &connection)
+{
+	uint8_t buffer[4096];
+	while (true)
+	{
+		ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+		if (received > 0)
+		{
+			connection.inBuffer.insert(connection.inBuffer.end(), buffer, buffer + received);
+			continue;
+		}
+		if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (received == -1 && errno == EINTR)
+			continue;
+
+		dropPlayer(connection); // disconnected or failed
+		return;
+	}
+
+	// only the newest input matters, but apply them in order so the paddle ends up right
+	size_t offset = 0;
+	while (offset < connection.inBuffer.size())
+	{
+		int size = messageSize(connection.inBuffer[offset]);
+		if (size == 0)
+		{
+			cerr << "Shard " << index << ": dropping player sending unknown message " << (int)connection.inBuffer[offset] << endl;
+			dropPlayer(connection);
+			return;
+		}
+		if (offset + size > connection.inBuffer.size())
+			break;
+
+		const uint8_t *message = &connection.inBuffer[offset];
+		if (message[0] == MSG_INPUT && connection.match != -1)
+		{
+			MatchState &state = matches[connection.match].state;
+			float direction = (float)decodeInputDirection(message);
+			if (connection.playerIndex == 1)
+				state.paddle1Direction = direction;
+			else
+				state.paddle2Direction = direction;
+		}
+		offset += size;
+	}
+	connection.inBuffer.erase(connection.inBuffer.begin(), connection.inBuffer.begin() + offset);
+}
+// end::readPlayer[]
+
+// tag::queueMessage[]
+void Shard::queueMessage(Connection &connection, const uint8_t *data, size_t size)
+{
+	bool wasEmpty = connection.outBuffer.size() == connection.outSent;
+	connection.outBuffer.insert(connection.outBuffer.end(), data, data + size);
+
+	// try to send straight away, epoll only gets involved if the socket is full
+	if (wasEmpty)
+		flushPlayer(connection);
+}
+
+void Shard::flushPlayer(Connection &connection)
+{
+	while (connection.outSent < connection.outBuffer.size())
+	{
+		ssize_t sent = send(connection.fd, &connection.outBuffer[connection.outSent],
+		                    connection.outBuffer.size() - connection.outSent, MSG_NOSIGNAL);
+		if (sent > 0)
+		{
+			connection.outSent += sent;
+			continue;
+		}
+		if (sent == -1 && errno == EINTR)
+			continue;
+		if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+
+		dropPlayer(connection);
+		return;
+	}
+
+	bool pending = connection.outSent < connection.outBuffer.size();
+	if (!pending)
+	{
+		connection.outBuffer.clear();
+		connection.outSent = 0;
+	}
+
+	if (pending != connection.wantsWrite)
+	{
+		connection.wantsWrite = pending;
+		epoll_event event;
+		event.events = EPOLLIN | (pending ? (uint32_t)EPOLLOUT : 0u);
+		event.data.fd = connection.fd;
+		epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+	}
+}
+// end::queueMessage[]
+
+// tag::closePlayer[]
+void Shard::dropPlayer(Connection &connection)
+{
+	if (connection.closing)
+		return;
+	connection.closing = true;
+	closingFds.push_back(connection.fd);
+}
+
+void Shard::closePlayer(int fd)
+{
+	auto found = connections.find(fd);
+	if (found == connections.end())
+		return;
+
+	int matchIndex = found->second.match;
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+	close(fd);
+	connections.erase(found);
+
+	if (waitingFd == fd)
+		waitingFd = -1;
+
+	if (matchIndex != -1)
+	{
+		// the match is over, the opponent goes back to waiting for someone new
+		Match &match = matches[matchIndex];
+		int opponent = match.player1Fd == fd ? match.player2Fd : match.player1Fd;
+		match.active = false;
+		freeMatches.push_back(matchIndex);
+
+		auto other = connections.find(opponent);
+		if (other != connections.end())
+		{
+			other->second.match = -1;
+			other->second.playerIndex = 0;
+			if (!other->second.closing)
+				pairPlayer(opponent);
+		}
+	}
+}
+// end::closePlayer[]
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "Simulation.h"
+#include "FixedSimulation.h"
+#include "Protocol.h"
+#include "Snapshot.h"
+#include "TickStats.h"
+
+class SpectatorHub;
+
+// tag::ServerConfig[]
+struct ServerConfig
+{
+	unsigned short port = DEFAULT_SERVER_PORT;
+	int shards = 0;         // 0 means one per core
+	int tickRate = 60;      // simulation ticks per second
+	int localMatches = 0;   // matches played by server-side bots, spread across the shards
+	int reportInterval = 5; // seconds between stats reports
+	int duration = 0;       // seconds to run for, 0 runs until interrupted
+	bool pinThreads = true; // pin each shard thread to its own core
+
+	unsigned short spectatorPort = 0;                 // 0 means port + 1
+	int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL; // ticks between spectator keyframes
+	int maxQueuedSnapshots = 64;                      // spectators further behind than this skip to a keyframe
+
+	bool fixedPoint = false; // deterministic fixed point rules, ticking at FIXED_TICK_RATE
+};
+// end::ServerConfig[]
+
+struct Connection
+{
+	int fd = -1;
+	int match = -1;      // index into Shard::matches, -1 while waiting for an opponent
+	int playerIndex = 0; // 1 or 2 once in a match
+	std::vector<uint8_t> inBuffer;
+	std::vector<uint8_t> outBuffer;
+	size_t outSent = 0;
+	bool wantsWrite = false; // registered for EPOLLOUT because outBuffer could not be flushed
+	bool closing = false;    // closed at the end of the current loop iteration
+};
+
+struct Match
+{
+	MatchState state;
+	FixedMatchState fixedState; // the real state in fixed point mode, copied into state after each tick
+	uint32_t tick = 0;
+	int player1Fd = -1;
+	int player2Fd = -1;
+	bool active = false;
+	bool local = false; // both paddles driven by the server
+};
+
+// tag::Shard[]
+// One shard owns a set of matches and the connections of their players, and runs them all
+// on one thread: an epoll loop over a SO_REUSEPORT listening socket (so the kernel spreads
+// new players across shards), the player sockets, and a timerfd for the fixed tick.
+class Shard
+{
+public:
+	Shard(int index, const ServerConfig &config, int localMatches, SpectatorHub *hub);
+	~Shard();
+
+	bool open(); // create the sockets, returns false (after printing why) on failure
+	void run(const std::atomic<bool> &stop);
+
+	ShardReport takeReport(); // safe to call from any thread
+
+private:
+	void acceptPlayers();
+	void readPlayer(Connection &connection);
+	void flushPlayer(Connection &connection);
+	void dropPlayer(Connection &connection);
+	void closePlayer(int fd);
+	void pairPlayer(int fd);
+	int createMatch();
+	void startMatch(int matchIndex, int player1Fd, int player2Fd);
+	void queueMessage(Connection &connection, const uint8_t *data, size_t size);
+	void tick(uint64_t expirations);
+	void publishSnapshots();
+
+	int index;
+	ServerConfig config;
+	int localMatchCount;
+
+	int epollFd = -1;
+	int listenFd = -1;
+	int timerFd = -1;
+
+	std::unordered_map<int, Connection> connections;
+	std::vector<Match> matches;
+	std::vector<int> freeMatches;
+	int waitingFd = -1; // a player without an opponent yet
+	std::vector<int> closingFds; // closing is deferred so matches never change mid-tick
+
+	// spectators - only matches someone is watching get encoded
+	SpectatorHub *hub;
+	uint64_t watchedVersion = 0;
+	std::vector<int> watchedMatches;
+	std::unordered_map<int, SnapshotEncoder> spectatorEncoders;
+	std::vector<std::pair<uint32_t, SnapshotPtr>> snapshots;
+
+	std::mutex reportMutex;
+	ShardReport report;
+};
+// end::Shard[]
@@ -0,0 +1,431 @@
+#include "SpectatorHub.h"
+#include "Shard.h"
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+using std::cerr;
+using std::endl;
+using namespace std::chrono;
+
+const int MAX_WRITE_BUFFERS = 64; // snapshots per writev call, well under IOV_MAX
+
+static bool setNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+SpectatorHub::SpectatorHub(const ServerConfig &config)
+	: port(config.spectatorPort), maxQueued(config.maxQueuedSnapshots), watchedVersion(0)
+{
+}
+
+SpectatorHub::~SpectatorHub()
+{
+	for (auto &entry : subscribers)
+		close(entry.first);
+	if (wakeFd != -1)
+		close(wakeFd);
+	if (listenFd != -1)
+		close(listenFd);
+	if (epollFd != -1)
+		close(epollFd);
+}
+
+// tag::open[]
+bool SpectatorHub::open()
+{
+	epollFd = epoll_create1(0);
+	wakeFd = eventfd(0, EFD_NONBLOCK);
+	listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	if (epollFd == -1 || wakeFd == -1 || listenFd == -1)
+	{
+		cerr << "Spectator hub: could not create sockets: " << strerror(errno) << endl;
+		return false;
+	}
+
+	int one = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+
+	if (bind(listenFd, (sockaddr *)&address, sizeof(address)) == -1 || listen(listenFd, 1024) == -1 || !setNonBlocking(listenFd))
+	{
+		cerr << "Spectator hub: could not listen on port " << port << ": " << strerror(errno) << endl;
+		return false;
+	}
+
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = listenFd;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+	event.data.fd = wakeFd;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+	return true;
+}
+// end::open[]
+
+// tag::run[]
+void SpectatorHub::run(const std::atomic<bool> &stop)
+{
+	epoll_event events[256];
+
+	while (!stop)
+	{
+		int count = epoll_wait(epollFd, events, 256, 100);
+		if (count == -1 && errno != EINTR)
+		{
+			cerr << "Spectator hub: epoll_wait failed: " << strerror(errno) << endl;
+			break;
+		}
+
+		bool published = false;
+		bool subscriptionsChanged = false;
+		for (int i = 0; i < count; i++)
+		{
+			int fd = events[i].data.fd;
+			if (fd == wakeFd)
+			{
+				uint64_t wakes;
+				if (read(wakeFd, &wakes, sizeof(wakes)) == sizeof(wakes))
+					published = true;
+			}
+			else if (fd == listenFd)
+				acceptSubscribers();
+			else
+			{
+				auto found = subscribers.find(fd);
+				if (found == subscribers.end())
+					continue;
+
+				Subscriber &subscriber = found->second;
+				bool wasSubscribed = subscriber.subscribed;
+				if (events[i].events & (EPOLLHUP | EPOLLERR))
+					closingFds.push_back(fd);
+				else
+				{
+					if (events[i].events & EPOLLIN)
+						readSubscriber(subscriber);
+					if (events[i].events & EPOLLOUT)
+						flushSubscriber(subscriber);
+				}
+				subscriptionsChanged |= subscriber.subscribed != wasSubscribed;
+			}
+		}
+
+		if (published)
+			fanOut();
+
+		subscriptionsChanged |= !closingFds.empty();
+		for (int fd : closingFds)
+			closeSubscriber(fd);
+		closingFds.clear();
+
+		if (subscriptionsChanged)
+			updateWatched();
+	}
+}
+// end::run[]
+
+// tag::fanOut[]
+void SpectatorHub::fanOut()
+{
+	{
+		std::lock_guard<std::mutex> lock(inboxMutex);
+		draining.swap(inbox);
+	}
+
+	auto start = steady_clock::now();
+
+	// queue every snapshot on its subscribers first, then write each subscriber once
+	uint64_t deliveries = 0;
+	std::vector<int> touched;
+	for (auto &published : draining)
+	{
+		auto found = subscribersByMatch.find(published.first);
+		if (found == subscribersByMatch.end())
+			continue;
+
+		for (int fd : found->second)
+		{
+			Subscriber &subscriber = subscribers[fd];
+			bool wasIdle = subscriber.queue.empty();
+			deliver(subscriber, published.second);
+			deliveries++;
+			if (wasIdle && !subscriber.queue.empty())
+				touched.push_back(fd);
+		}
+	}
+
+	for (int fd : touched)
+	{
+		Subscriber &subscriber = subscribers[fd];
+		if (!subscriber.wantsWrite) // otherwise epoll will tell us when it can take more
+			flushSubscriber(subscriber);
+	}
+
+	uint32_t nanos = (uint32_t)duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(reportMutex);
+	report.snapshots += draining.size();
+	report.deliveries += deliveries;
+	report.fanOutNanos.push_back(nanos);
+
+	draining.clear();
+}
+// end::fanOut[]
+
+// tag::deliver[]
+void SpectatorHub::deliver(Subscriber &subscriber, const SnapshotPtr &snapshot)
+{
+	if (subscriber.waitingForKeyframe)
+	{
+		if (!snapshot->keyframe)
+			return;
+		subscriber.waitingForKeyframe = false;
+	}
+
+	if ((int)subscriber.queue.size() >= maxQueued)
+	{
+		// too far behind - keep only what is already half written so the stream stays intact,
+		// and start again at the next keyframe
+		size_t keep = subscriber.frontSent > 0 ? 1 : 0;
+		subscriber.queue.resize(keep);
+		subscriber.waitingForKeyframe = !snapshot->keyframe;
+
+		std::lock_guard<std::mutex> lock(reportMutex);
+		report.resyncs++;
+
+		if (subscriber.waitingForKeyframe)
+			return;
+	}
+
+	subscriber.queue.push_back(snapshot);
+}
+// end::deliver[]
+
+// tag::flushSubscriber[]
+void SpectatorHub::flushSubscriber(Subscriber &subscriber)
+{
+	uint64_t calls = 0;
+	uint64_t bytes = 0;
+
+	while (!subscriber.queue.empty())
+	{
+		// point straight at the shared snapshot buffers
+		iovec buffers[MAX_WRITE_BUFFERS];
+		int bufferCount = 0;
+		for (auto it = subscriber.queue.begin(); it != subscriber.queue.end() && bufferCount < MAX_WRITE_BUFFERS; ++it)
+		{
+			size_t skip = bufferCount == 0 ? subscriber.frontSent : 0;
+			buffers[bufferCount].iov_base = (void *)((*it)->bytes.data() + skip);
+			buffers[bufferCount].iov_len = (*it)->bytes.size() - skip;
+			bufferCount++;
+		}
+
+		msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = buffers;
+		message.msg_iovlen = bufferCount;
+
+		ssize_t sent = sendmsg(subscriber.fd, &message, MSG_NOSIGNAL);
+		calls++;
+		if (sent == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				closingFds.push_back(subscriber.fd);
+			break;
+		}
+		bytes += sent;
+
+		// pop whatever went out completely
+		size_t remaining = (size_t)sent;
+		while (remaining > 0)
+		{
+			size_t left = subscriber.queue.front()->bytes.size() - subscriber.frontSent;
+			if (remaining < left)
+			{
+				subscriber.frontSent += remaining;
+				break;
+			}
+			remaining -= left;
+			subscriber.queue.pop_front();
+			subscriber.frontSent = 0;
+		}
+
+		if (subscriber.frontSent > 0)
+			break; // the socket is full
+	}
+
+	bool pending = !subscriber.queue.empty();
+	if (pending != subscriber.wantsWrite)
+	{
+		subscriber.wantsWrite = pending;
+		epoll_event event;
+		event.events = EPOLLIN | (pending ? (uint32_t)EPOLLOUT : 0u);
+		event.data.fd = subscriber.fd;
+		epoll_ctl(epollFd, EPOLL_CTL_MOD, subscriber.fd, &event);
+	}
+
+	std::lock_guard<std::mutex> lock(reportMutex);
+	report.writeCalls += calls;
+	report.bytesSent += bytes;
+}
+// end::flushSubscriber[]
+
+void SpectatorHub::acceptSubscribers()
+{
+	while (true)
+	{
+		int fd = accept(listenFd, NULL, NULL);
+		if (fd == -1)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				cerr << "Spectator hub: accept failed: " << strerror(errno) << endl;
+			std::lock_guard<std::mutex> lock(reportMutex);
+			report.subscribers = (int)subscribers.size();
+			return;
+		}
+
+		setNonBlocking(fd);
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+		subscribers[fd].fd = fd;
+	}
+}
+
+void SpectatorHub::readSubscriber(Subscriber &subscriber)
+{
+	uint8_t buffer[256];
+	while (true)
+	{
+		ssize_t received = recv(subscriber.fd, buffer, sizeof(buffer), 0);
+		if (received > 0)
+		{
+			subscriber.inBuffer.insert(subscriber.inBuffer.end(), buffer, buffer + received);
+			continue;
+		}
+		if (received == -1 && errno == EINTR)
+			continue;
+		if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		closingFds.push_back(subscriber.fd);
+		return;
+	}
+
+	// spectators only ever ask to watch one match, so anything sent after that is dropped
+	if (!subscriber.subscribed)
+	{
+		if (subscriber.inBuffer.size() < (size_t)SPECTATE_MESSAGE_SIZE)
+			return; // the rest of the message is still on its way
+		if (subscriber.inBuffer[0] != MSG_SPECTATE)
+		{
+			closingFds.push_back(subscriber.fd);
+			return;
+		}
+		subscriber.matchId = getU32(&subscriber.inBuffer[4]);
+		subscriber.subscribed = true;
+		subscribersByMatch[subscriber.matchId].push_back(subscriber.fd);
+	}
+	subscriber.inBuffer.clear();
+}
+
+void SpectatorHub::closeSubscriber(int fd)
+{
+	auto found = subscribers.find(fd);
+	if (found == subscribers.end())
+		return;
+
+	if (found->second.subscribed)
+	{
+		std::vector<int> &watchers = subscribersByMatch[found->second.matchId];
+		watchers.erase(std::remove(watchers.begin(), watchers.end(), fd), watchers.end());
+		if (watchers.empty())
+			subscribersByMatch.erase(found->second.matchId);
+	}
+
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+	close(fd);
+	subscribers.erase(found);
+
+	std::lock_guard<std::mutex> lock(reportMutex);
+	report.subscribers = (int)subscribers.size();
+}
+
+// tag::watched[]
+void SpectatorHub::updateWatched()
+{
+	std::lock_guard<std::mutex> lock(watchedMutex);
+	watched.clear();
+	for (auto &entry : subscribersByMatch)
+		watched[entry.first >> 20].push_back(entry.first & 0xfffff);
+	watchedVersion++;
+}
+
+void SpectatorHub::watchedMatches(int shard, uint64_t &version, std::vector<int> &matches)
+{
+	if (version == watchedVersion.load())
+		return;
+
+	std::lock_guard<std::mutex> lock(watchedMutex);
+	version = watchedVersion.load();
+	auto found = watched.find(shard);
+	if (found != watched.end())
+		matches = found->second;
+	else
+		matches.clear();
+}
+
+void SpectatorHub::publish(std::vector<std::pair<uint32_t, SnapshotPtr>> &snapshots)
+{
+	if (snapshots.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(inboxMutex);
+		for (auto &snapshot : snapshots)
+			inbox.push_back(std::move(snapshot));
+	}
+	snapshots.clear();
+
+	uint64_t one = 1;
+	if (write(wakeFd, &one, sizeof(one)) != sizeof(one))
+		cerr << "Spectator hub: could not wake the hub thread" << endl;
+}
+// end::watched[]
+
+SpectatorReport SpectatorHub::takeReport()
+{
+	std::lock_guard<std::mutex> lock(reportMutex);
+	SpectatorReport taken = std::move(report);
+	report = SpectatorReport();
+	report.subscribers = taken.subscribers;
+	return taken;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+#include "Snapshot.h"
+
+struct ServerConfig;
+
+// tag::SpectatorReport[]
+struct SpectatorReport
+{
+	std::vector<uint32_t> fanOutNanos; // time to hand one batch of snapshots to every subscriber
+	int subscribers = 0;
+	uint64_t snapshots = 0;   // snapshots received from the shards
+	uint64_t deliveries = 0;  // snapshots queued to a subscriber
+	uint64_t writeCalls = 0;  // writev calls made, each sending many queued snapshots
+	uint64_t bytesSent = 0;
+	uint64_t resyncs = 0;     // subscribers that fell behind and skipped to the next keyframe
+};
+// end::SpectatorReport[]
+
+struct Subscriber
+{
+	int fd = -1;
+	bool subscribed = false;
+	uint32_t matchId = 0;
+	std::vector<uint8_t> inBuffer;
+	std::deque<SnapshotPtr> queue; // shared, immutable snapshots waiting to be written
+	size_t frontSent = 0;          // bytes of queue.front() already written
+	bool waitingForKeyframe = true;
+	bool wantsWrite = false;
+};
+
+// tag::SpectatorHub[]
+// Fans match snapshots out to spectators on its own thread. Shards encode a snapshot of each
+// watched match once per tick and publish a pointer to it; the hub queues that same buffer
+// on every subscriber and writes queues out with writev, so nothing is copied per spectator
+// in user space. A subscriber whose queue gets too long drops it and resumes at a keyframe.
+class SpectatorHub
+{
+public:
+	explicit SpectatorHub(const ServerConfig &config);
+	~SpectatorHub();
+
+	bool open(); // returns false (after printing why) on failure
+	void run(const std::atomic<bool> &stop);
+
+	// called by shard threads: refreshes matches (the watched matches of a shard) if they changed
+	void watchedMatches(int shard, uint64_t &version, std::vector<int> &matches);
+	// called by shard threads once per tick with every snapshot they encoded
+	void publish(std::vector<std::pair<uint32_t, SnapshotPtr>> &snapshots);
+
+	SpectatorReport takeReport(); // safe to call from any thread
+
+private:
+	void acceptSubscribers();
+	void readSubscriber(Subscriber &subscriber);
+	void deliver(Subscriber &subscriber, const SnapshotPtr &snapshot);
+	void flushSubscriber(Subscriber &subscriber);
+	void closeSubscriber(int fd);
+	void updateWatched();
+	void fanOut();
+
+	unsigned short port;
+	int maxQueued;
+
+	int epollFd = -1;
+	int listenFd = -1;
+	int wakeFd = -1; // eventfd the shards poke after publishing
+
+	std::unordered_map<int, Subscriber> subscribers;
+	std::unordered_map<uint32_t, std::vector<int>> subscribersByMatch;
+	std::vector<int> closingFds;
+
+	std::mutex inboxMutex;
+	std::vector<std::pair<uint32_t, SnapshotPtr>> inbox;
+	std::vector<std::pair<uint32_t, SnapshotPtr>> draining;
+
+	// which matches each shard should publish, versioned so shards only lock when it changes
+	std::mutex watchedMutex;
+	std::unordered_map<int, std::vector<int>> watched;
+	std::atomic<uint64_t> watchedVersion;
+
+	std::mutex reportMutex;
+	SpectatorReport report;
+};
+// end::SpectatorHub[]
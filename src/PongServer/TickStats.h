@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+// percentile (0-100) of a set of tick durations, reorders the samples
+inline uint32_t percentile(std::vector<uint32_t> &samples, double p)
+{
+	if (samples.empty())
+		return 0;
+
+	size_t index = (size_t)((p / 100.0) * (samples.size() - 1) + 0.5);
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+// tag::ShardReport[]
+// what a shard did since the last report, handed to the main thread for printing
+struct ShardReport
+{
+	std::vector<uint32_t> tickNanos; // how long every tick took to simulate and broadcast
+	int activeMatches = 0;
+	int localMatches = 0;
+	int players = 0;
+	uint64_t ticks = 0;
+	uint64_t lateTicks = 0;     // timer expirations we had to catch up on
+	uint64_t droppedStates = 0; // state messages not queued because a client was not reading
+	uint64_t bytesSent = 0;
+};
+// end::ShardReport[]
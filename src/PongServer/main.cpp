@@ -0,0 +1,248 @@
+// Headless dedicated server - runs thousands of Pong matches using the same rules as the game.
+//
+// Matches are sharded across cores: every shard thread owns its matches and players outright,
+// so a tick never takes a lock. Every few seconds the tick durations of each shard are reported
+// as percentiles, along with an estimate of how many matches a core could run within the tick.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <csignal>
+#include <cstdlib>
+
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include "Shard.h"
+#include "SpectatorHub.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+std::atomic<bool> stopServer(false);
+
+void handleSignal(int)
+{
+	stopServer = true;
+}
+
+// tag::parseArguments[]
+void printUsage(const char *exeName)
+{
+	cout << "Usage: " << exeName << " [options]\n"
+	     << "  --port N             port to listen on (default " << DEFAULT_SERVER_PORT << ")\n"
+	     << "  --shards N           simulation threads, 0 for one per core (default 0)\n"
+	     << "  --tick-rate N        ticks per second (default 60)\n"
+	     << "  --local-matches N    bot-vs-bot matches to host without any clients (default 0)\n"
+	     << "  --report-interval N  seconds between stats reports (default 5)\n"
+	     << "  --duration N         stop after N seconds, 0 to run until interrupted (default 0)\n"
+	     << "  --no-pin             don't pin shard threads to cores\n"
+	     << "  --spectator-port N   port spectators connect to (default port + 1)\n"
+	     << "  --keyframe-interval N  ticks between spectator keyframes (default " << DEFAULT_KEYFRAME_INTERVAL << ")\n"
+	     << "  --max-queued N       snapshots queued per spectator before it skips to a keyframe (default 64)\n"
+	     << "  --fixed-point        deterministic fixed point rules, ticks at " << FIXED_TICK_RATE << "/s\n";
+}
+
+bool parseArguments(int argc, char *args[], ServerConfig &config)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = args[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--port" && hasValue)
+			config.port = (unsigned short)atoi(args[++i]);
+		else if (arg == "--shards" && hasValue)
+			config.shards = atoi(args[++i]);
+		else if (arg == "--tick-rate" && hasValue)
+			config.tickRate = atoi(args[++i]);
+		else if (arg == "--local-matches" && hasValue)
+			config.localMatches = atoi(args[++i]);
+		else if (arg == "--report-interval" && hasValue)
+			config.reportInterval = atoi(args[++i]);
+		else if (arg == "--duration" && hasValue)
+			config.duration = atoi(args[++i]);
+		else if (arg == "--no-pin")
+			config.pinThreads = false;
+		else if (arg == "--spectator-port" && hasValue)
+			config.spectatorPort = (unsigned short)atoi(args[++i]);
+		else if (arg == "--keyframe-interval" && hasValue)
+			config.keyframeInterval = atoi(args[++i]);
+		else if (arg == "--max-queued" && hasValue)
+			config.maxQueuedSnapshots = atoi(args[++i]);
+		else if (arg == "--fixed-point")
+			config.fixedPoint = true;
+		else
+			return false;
+	}
+
+	if (config.spectatorPort == 0)
+		config.spectatorPort = config.port + 1;
+
+	// a fixed point tick is a fixed length of game time
+	if (config.fixedPoint)
+		config.tickRate = FIXED_TICK_RATE;
+
+	return config.tickRate > 0 && config.reportInterval > 0 && config.shards >= 0 && config.localMatches >= 0 &&
+	       config.keyframeInterval > 0 && config.maxQueuedSnapshots > 0;
+}
+// end::parseArguments[]
+
+// thousands of players need thousands of file descriptors
+void raiseFileLimit()
+{
+	rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+		cout << "File descriptor limit: " << limit.rlim_cur << endl;
+}
+
+void pinToCore(std::thread &thread, int core)
+{
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(core, &cpus);
+	if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) != 0)
+		cerr << "Could not pin shard thread to core " << core << endl;
+}
+
+// tag::printReport[]
+void printReport(std::vector<ShardReport> &reports, const ServerConfig &config, double seconds)
+{
+	const double TICK_BUDGET_US = 1000000.0 / config.tickRate;
+
+	int totalMatches = 0;
+	int totalPlayers = 0;
+	double totalCapacity = 0;
+	int measuredShards = 0; // ran matches, so their capacity means something
+	std::vector<uint32_t> allTicks;
+
+	cout << std::fixed << std::setprecision(1);
+	for (size_t i = 0; i < reports.size(); i++)
+	{
+		ShardReport &report = reports[i];
+		allTicks.insert(allTicks.end(), report.tickNanos.begin(), report.tickNanos.end());
+
+		double p50 = percentile(report.tickNanos, 50) / 1000.0;
+		double p90 = percentile(report.tickNanos, 90) / 1000.0;
+		double p99 = percentile(report.tickNanos, 99) / 1000.0;
+		double worst = percentile(report.tickNanos, 100) / 1000.0;
+
+		// how many matches this core could run if the 99th percentile tick filled the whole budget
+		double capacity = p99 > 0 ? report.activeMatches * TICK_BUDGET_US / p99 : 0;
+		totalCapacity += capacity;
+		measuredShards += capacity > 0;
+		totalMatches += report.activeMatches;
+		totalPlayers += report.players;
+
+		cout << "  shard " << i << ": " << report.activeMatches << " matches (" << report.localMatches << " local), "
+		     << report.players << " players, " << report.ticks / seconds << " ticks/s, tick us p50 " << p50
+		     << " p90 " << p90 << " p99 " << p99 << " max " << worst << ", late " << report.lateTicks
+		     << ", dropped " << report.droppedStates << ", " << report.bytesSent / seconds / 1024 << " KiB/s, capacity ~"
+		     << (long)capacity << " matches\n";
+	}
+
+	cout << "total: " << totalMatches << " matches, " << totalPlayers << " players on " << reports.size()
+	     << " shards, tick us p50 " << percentile(allTicks, 50) / 1000.0 << " p99 " << percentile(allTicks, 99) / 1000.0
+	     << ", capacity ~" << (long)(measuredShards > 0 ? totalCapacity / measuredShards : 0) << " matches per core" << endl;
+}
+// end::printReport[]
+
+// tag::printSpectatorReport[]
+void printSpectatorReport(SpectatorReport &report, double seconds)
+{
+	if (report.subscribers == 0 && report.snapshots == 0)
+		return;
+
+	cout << "spectators: " << report.subscribers << " subscribed, " << report.snapshots / seconds << " snapshots/s encoded, "
+	     << report.deliveries / seconds << " deliveries/s in " << report.writeCalls / seconds << " writes/s, "
+	     << report.bytesSent / seconds / 1024 << " KiB/s, fan-out us p50 " << percentile(report.fanOutNanos, 50) / 1000.0
+	     << " p99 " << percentile(report.fanOutNanos, 99) / 1000.0 << ", resyncs " << report.resyncs << endl;
+}
+// end::printSpectatorReport[]
+
+// tag::main[]
+int main(int argc, char *args[])
+{
+	ServerConfig config;
+	if (!parseArguments(argc, args, config))
+	{
+		printUsage(args[0]);
+		return 1;
+	}
+
+	signal(SIGINT, handleSignal);
+	signal(SIGTERM, handleSignal);
+	signal(SIGPIPE, SIG_IGN);
+	raiseFileLimit();
+
+	int cores = std::max(1u, std::thread::hardware_concurrency());
+	int shardCount = config.shards > 0 ? config.shards : cores;
+
+	SpectatorHub hub(config);
+	if (!hub.open())
+		return 1;
+
+	std::vector<std::unique_ptr<Shard>> shards;
+	for (int i = 0; i < shardCount; i++)
+	{
+		// spread the local matches evenly, the first shards take any remainder
+		int localMatches = config.localMatches / shardCount + (i < config.localMatches % shardCount ? 1 : 0);
+		shards.push_back(std::unique_ptr<Shard>(new Shard(i, config, localMatches, &hub)));
+		if (!shards.back()->open())
+			return 1;
+	}
+	cout << "Listening on port " << config.port << " with " << shardCount << " shards at " << config.tickRate
+	     << " ticks/s, spectators on port " << config.spectatorPort << endl;
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < shardCount; i++)
+	{
+		threads.push_back(std::thread(&Shard::run, shards[i].get(), std::cref(stopServer)));
+		if (config.pinThreads)
+			pinToCore(threads.back(), i % cores);
+	}
+	threads.push_back(std::thread(&SpectatorHub::run, &hub, std::cref(stopServer)));
+
+	auto start = steady_clock::now();
+	auto lastReport = start;
+	while (!stopServer)
+	{
+		std::this_thread::sleep_for(milliseconds(100));
+		auto now = steady_clock::now();
+
+		if (now - lastReport >= seconds(config.reportInterval))
+		{
+			std::vector<ShardReport> reports;
+			for (auto &shard : shards)
+				reports.push_back(shard->takeReport());
+			double elapsed = duration_cast<duration<double>>(now - lastReport).count();
+			printReport(reports, config, elapsed);
+			SpectatorReport spectatorReport = hub.takeReport();
+			printSpectatorReport(spectatorReport, elapsed);
+			lastReport = now;
+		}
+
+		if (config.duration > 0 && now - start >= seconds(config.duration))
+			stopServer = true;
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	cout << "Server stopped OK!" << endl;
+	return 0;
+}
+// end::main[]
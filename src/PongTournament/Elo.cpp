@@ -0,0 +1,104 @@
+#include "Elo.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Random.h"
+
+const double ELO_MEAN = 1500;
+const int FIT_ITERATIONS = 500;
+
+// tag::fitElo[]
+// Hunter's MM algorithm for Bradley-Terry strengths: gamma_i = wins_i / sum_j(games_ij / (gamma_i + gamma_j))
+static std::vector<double> fitElo(const std::vector<GameResult> &games, const std::vector<int> &picked, int controllerCount)
+{
+	std::vector<double> wins(controllerCount, 0);
+	std::vector<double> played((size_t)controllerCount * controllerCount, 0);
+
+	// the imaginary draw between every pair
+	for (int i = 0; i < controllerCount; i++)
+		for (int j = 0; j < controllerCount; j++)
+			if (i != j)
+			{
+				wins[i] += 0.5;
+				played[(size_t)i * controllerCount + j] += 1;
+			}
+
+	for (int index : picked)
+	{
+		const GameResult &game = games[index];
+		double score = game.player1Score();
+		wins[game.player1] += score;
+		wins[game.player2] += 1 - score;
+		played[(size_t)game.player1 * controllerCount + game.player2] += 1;
+		played[(size_t)game.player2 * controllerCount + game.player1] += 1;
+	}
+
+	std::vector<double> strength(controllerCount, 1.0);
+	for (int iteration = 0; iteration < FIT_ITERATIONS; iteration++)
+	{
+		double largestChange = 0;
+		for (int i = 0; i < controllerCount; i++)
+		{
+			double denominator = 0;
+			for (int j = 0; j < controllerCount; j++)
+				if (i != j)
+					denominator += played[(size_t)i * controllerCount + j] / (strength[i] + strength[j]);
+			double updated = wins[i] / denominator;
+			largestChange = std::max(largestChange, fabs(log(updated / strength[i])));
+			strength[i] = updated;
+		}
+		if (largestChange < 1e-9)
+			break;
+	}
+
+	// convert to Elo, shifted so the average is ELO_MEAN
+	std::vector<double> elo(controllerCount);
+	double total = 0;
+	for (int i = 0; i < controllerCount; i++)
+	{
+		elo[i] = 400 * log10(strength[i]);
+		total += elo[i];
+	}
+	for (double &rating : elo)
+		rating += ELO_MEAN - total / controllerCount;
+	return elo;
+}
+// end::fitElo[]
+
+// tag::computeRatings[]
+std::vector<Rating> computeRatings(const std::vector<GameResult> &games, int controllerCount, int bootstrapSamples, uint64_t seed)
+{
+	std::vector<int> all(games.size());
+	for (size_t i = 0; i < games.size(); i++)
+		all[i] = (int)i;
+	std::vector<double> best = fitElo(games, all, controllerCount);
+
+	// re-fit on resamples of the games to see how much the ratings could move
+	std::vector<std::vector<double>> samples(controllerCount);
+	Random random(seed);
+	std::vector<int> picked(games.size());
+	for (int sample = 0; sample < bootstrapSamples && !games.empty(); sample++)
+	{
+		for (int &index : picked)
+			index = (int)random.below((uint32_t)games.size());
+		std::vector<double> elo = fitElo(games, picked, controllerCount);
+		for (int i = 0; i < controllerCount; i++)
+			samples[i].push_back(elo[i]);
+	}
+
+	std::vector<Rating> ratings(controllerCount);
+	for (int i = 0; i < controllerCount; i++)
+	{
+		ratings[i].elo = best[i];
+		ratings[i].low = ratings[i].high = best[i];
+		if (!samples[i].empty())
+		{
+			std::sort(samples[i].begin(), samples[i].end());
+			ratings[i].low = samples[i][(size_t)(0.025 * (samples[i].size() - 1))];
+			ratings[i].high = samples[i][(size_t)(0.975 * (samples[i].size() - 1))];
+		}
+	}
+	return ratings;
+}
+// end::computeRatings[]
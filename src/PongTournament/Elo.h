@@ -0,0 +1,41 @@
+#pragma once
+
+// Ratings from a set of game results, on the Elo scale (a 400 point gap means 10:1 odds).
+//
+// Rather than updating ratings game by game, which makes the answer depend on the order the
+// games finished in, this fits the Bradley-Terry model to all of them at once. Every pair also
+// gets one imaginary draw, so a controller that never loses still gets a finite rating. The
+// confidence intervals come from re-fitting on bootstrap resamples of the games.
+
+#include <cstdint>
+#include <vector>
+
+// tag::GameResult[]
+struct GameResult
+{
+	int player1;     // controller indices
+	int player2;
+	int player1Points;
+	int player2Points;
+	int ticks;
+
+	// 1 for a player1 win, 0.5 for a draw, 0 for a loss
+	double player1Score() const
+	{
+		return player1Points > player2Points ? 1.0 : (player1Points == player2Points ? 0.5 : 0.0);
+	}
+};
+// end::GameResult[]
+
+// tag::Rating[]
+struct Rating
+{
+	double elo;
+	double low;  // 95% confidence interval
+	double high;
+};
+
+// ratings for controllers 0 to controllerCount - 1, averaging 1500
+std::vector<Rating> computeRatings(const std::vector<GameResult> &games, int controllerCount, int bootstrapSamples = 200,
+                                   uint64_t seed = 1);
+// end::Rating[]
@@ -0,0 +1,238 @@
+// Headless round-robin tournament between paddle controllers, with Elo ratings.
+//
+// Every pair of controllers plays the same number of games, half from each end, each game
+// starting from its own seeded random serve. The games are split across every core and run as
+// fast as the fixed point rules allow, so a whole tournament is reproducible from its seed.
+//
+// Usage: PongTournament [options] controller controller [controller...]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#include "Controller.h"
+#include "WorkerPool.h"
+#include "Elo.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using namespace std::chrono;
+
+// tag::TournamentConfig[]
+struct TournamentConfig
+{
+	std::vector<string> controllers;
+	int gamesPerPair = 100;
+	int pointsToWin = 5;
+	int maxTicks = 5 * 60 * FIXED_TICK_RATE; // a game still going after this is a draw (or a win on points)
+	int threads = 0;
+	uint64_t seed = 1;
+};
+// end::TournamentConfig[]
+
+// tag::parseArguments[]
+void printUsage(const char *exeName)
+{
+	cout << "Usage: " << exeName << " [options] controller controller [controller...]\n"
+	     << "  controllers are " << controllerSpecs() << "\n"
+	     << "  --games N      games between each pair of controllers (default 100)\n"
+	     << "  --points N     points needed to win a game (default 5)\n"
+	     << "  --max-ticks N  ticks before a game is stopped and decided on points (default " << 5 * 60 * FIXED_TICK_RATE << ")\n"
+	     << "  --threads N    threads, 0 for one per core (default 0)\n"
+	     << "  --seed N       seed for the serves and random controllers (default 1)\n";
+}
+
+bool parseArguments(int argc, char *args[], TournamentConfig &config)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = args[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--games" && hasValue)
+			config.gamesPerPair = atoi(args[++i]);
+		else if (arg == "--points" && hasValue)
+			config.pointsToWin = atoi(args[++i]);
+		else if (arg == "--max-ticks" && hasValue)
+			config.maxTicks = atoi(args[++i]);
+		else if (arg == "--threads" && hasValue)
+			config.threads = atoi(args[++i]);
+		else if (arg == "--seed" && hasValue)
+			config.seed = strtoull(args[++i], NULL, 10);
+		else if (arg.compare(0, 2, "--") == 0)
+			return false;
+		else
+			config.controllers.push_back(arg);
+	}
+
+	return config.controllers.size() >= 2 && config.gamesPerPair > 0 && config.pointsToWin > 0 && config.maxTicks > 0 &&
+	       config.threads >= 0;
+}
+// end::parseArguments[]
+
+// tag::playGames[]
+// plays games[first, last), which all have the same two controllers at the same ends, in lockstep
+// so each controller decides for every unfinished game in one call per tick
+void playGames(std::vector<GameResult> &games, int first, int last, const Controller &player1, const Controller &player2,
+               const TournamentConfig &config)
+{
+	int count = last - first;
+	std::vector<FixedMatchState> matches(count);
+	std::vector<Random> randoms(count);
+	std::vector<int> gameIndex(count);
+	std::vector<int> directions1(count), directions2(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		gameIndex[i] = first + i;
+		randoms[i] = Random(config.seed * 0x100000001B3ULL + first + i);
+		randomiseStart(matches[i], randoms[i]);
+	}
+
+	// the unfinished games are kept at the front, so every batch is contiguous
+	int active = count;
+	for (int tick = 1; active > 0; tick++)
+	{
+		player1.decide(&matches[0], active, 1, &randoms[0], &directions1[0]);
+		player2.decide(&matches[0], active, 2, &randoms[0], &directions2[0]);
+
+		for (int i = 0; i < active; i++)
+		{
+			FixedMatchState &match = matches[i];
+			match.paddle1Direction = directions1[i];
+			match.paddle2Direction = directions2[i];
+			stepMatchFixed(match);
+
+			if (tick >= config.maxTicks || match.player1Score >= config.pointsToWin || match.player2Score >= config.pointsToWin)
+			{
+				GameResult &result = games[gameIndex[i]];
+				result.player1Points = match.player1Score;
+				result.player2Points = match.player2Score;
+				result.ticks = tick;
+
+				// swap the last unfinished game in, and look at this slot again
+				active--;
+				std::swap(matches[i], matches[active]);
+				std::swap(randoms[i], randoms[active]);
+				std::swap(gameIndex[i], gameIndex[active]);
+				std::swap(directions1[i], directions1[active]);
+				std::swap(directions2[i], directions2[active]);
+				i--;
+			}
+		}
+	}
+}
+// end::playGames[]
+
+// tag::printResults[]
+void printResults(const std::vector<std::unique_ptr<Controller>> &controllers, const std::vector<GameResult> &games)
+{
+	int count = (int)controllers.size();
+	std::vector<Rating> ratings = computeRatings(games, count);
+
+	std::vector<int> wins(count, 0), draws(count, 0), losses(count, 0);
+	for (const GameResult &game : games)
+	{
+		double score = game.player1Score();
+		if (score == 0.5)
+		{
+			draws[game.player1]++;
+			draws[game.player2]++;
+		}
+		else
+		{
+			wins[score == 1 ? game.player1 : game.player2]++;
+			losses[score == 1 ? game.player2 : game.player1]++;
+		}
+	}
+
+	std::vector<int> order(count);
+	for (int i = 0; i < count; i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](int a, int b) { return ratings[a].elo > ratings[b].elo; });
+
+	cout << std::fixed << std::setprecision(0) << "\n"
+	     << std::left << std::setw(5) << "rank" << std::setw(24) << "controller" << std::right << std::setw(7) << "elo"
+	     << std::setw(18) << "95% interval" << std::setw(18) << "won-drawn-lost" << "\n";
+	for (int rank = 0; rank < count; rank++)
+	{
+		int i = order[rank];
+		string interval = std::to_string((int)lround(ratings[i].low)) + " to " + std::to_string((int)lround(ratings[i].high));
+		string record = std::to_string(wins[i]) + "-" + std::to_string(draws[i]) + "-" + std::to_string(losses[i]);
+		cout << std::left << std::setw(5) << rank + 1 << std::setw(24) << controllers[i]->name() << std::right
+		     << std::setw(7) << ratings[i].elo << std::setw(18) << interval << std::setw(18) << record << "\n";
+	}
+}
+// end::printResults[]
+
+// tag::main[]
+int main(int argc, char *args[])
+{
+	TournamentConfig config;
+	if (!parseArguments(argc, args, config))
+	{
+		printUsage(args[0]);
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<Controller>> controllers;
+	for (const string &spec : config.controllers)
+	{
+		string error;
+		controllers.push_back(createController(spec, error));
+		if (!controllers.back())
+		{
+			cerr << error << endl;
+			return 1;
+		}
+	}
+
+	// every pair, gamesPerPair times, half from each end
+	std::vector<GameResult> games;
+	for (int a = 0; a < (int)controllers.size(); a++)
+		for (int b = a + 1; b < (int)controllers.size(); b++)
+			for (int game = 0; game < config.gamesPerPair; game++)
+			{
+				GameResult result = {};
+				result.player1 = game < config.gamesPerPair / 2 ? a : b;
+				result.player2 = game < config.gamesPerPair / 2 ? b : a;
+				games.push_back(result);
+			}
+
+	WorkerPool pool(config.threads);
+	cout << "Playing " << games.size() << " games between " << controllers.size() << " controllers on " << pool.size()
+	     << " threads" << endl;
+
+	auto start = steady_clock::now();
+	pool.parallelFor((int)games.size(), [&](int, int begin, int end) {
+		// games with the same controllers at the same ends are next to each other, so play each run as one batch
+		while (begin < end)
+		{
+			int last = begin + 1;
+			while (last < end && games[last].player1 == games[begin].player1 && games[last].player2 == games[begin].player2)
+				last++;
+			playGames(games, begin, last, *controllers[games[begin].player1], *controllers[games[begin].player2], config);
+			begin = last;
+		}
+	});
+	double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+	uint64_t ticks = 0;
+	for (const GameResult &game : games)
+		ticks += game.ticks;
+
+	printResults(controllers, games);
+	cout << "\n" << games.size() << " games (" << ticks << " ticks) in " << std::setprecision(3) << seconds << "s: "
+	     << std::setprecision(0) << games.size() / seconds << " games/s, " << std::setprecision(1) << ticks / seconds / 1e6
+	     << "M ticks/s" << endl;
+
+	return 0;
+}
+// end::main[]
@@ -0,0 +1,136 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+static const char ASSET_PACK_MAGIC[8] = { 'P', 'O', 'N', 'G', 'P', 'A', 'K', '1' };
+
+const size_t PACK_HEADER_SIZE = sizeof(ASSET_PACK_MAGIC) + 4 + 4;
+const size_t PACK_ENTRY_SIZE = ASSET_NAME_LENGTH + 8 + 8;
+const size_t PACK_ALIGNMENT = 16;
+
+// tag::openAssetPack[]
+bool AssetPack::open(const std::string &path, std::string &error)
+{
+	close();
+	if (!file.open(path))
+	{
+		error = "could not open asset pack " + path;
+		return false;
+	}
+
+	const uint8_t *bytes = file.data();
+	if (file.size() < PACK_HEADER_SIZE || memcmp(bytes, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0)
+	{
+		error = path + " is not an asset pack";
+		close();
+		return false;
+	}
+	memcpy(&entryCount, bytes + sizeof(ASSET_PACK_MAGIC), 4);
+
+	// check every entry once here, so find() can trust them
+	bool valid = file.size() >= PACK_HEADER_SIZE + (size_t)entryCount * PACK_ENTRY_SIZE;
+	for (uint32_t i = 0; valid && i < entryCount; i++)
+	{
+		const uint8_t *entry = bytes + PACK_HEADER_SIZE + i * PACK_ENTRY_SIZE;
+		uint64_t offset, size;
+		memcpy(&offset, entry + ASSET_NAME_LENGTH, 8);
+		memcpy(&size, entry + ASSET_NAME_LENGTH + 8, 8);
+		valid = entry[ASSET_NAME_LENGTH - 1] == 0 && offset <= file.size() && size <= file.size() - offset;
+	}
+	if (!valid)
+	{
+		error = path + " is truncated or corrupt";
+		close();
+		return false;
+	}
+	return true;
+}
+// end::openAssetPack[]
+
+void AssetPack::close()
+{
+	file.close();
+	entryCount = 0;
+}
+
+// tag::findAsset[]
+AssetView AssetPack::find(const std::string &name) const
+{
+	AssetView view;
+	if (!isOpen() || name.size() >= ASSET_NAME_LENGTH)
+		return view;
+
+	const uint8_t *entries = file.data() + PACK_HEADER_SIZE;
+	uint32_t low = 0, high = entryCount;
+	while (low < high)
+	{
+		uint32_t middle = low + (high - low) / 2;
+		const uint8_t *entry = entries + middle * PACK_ENTRY_SIZE;
+		int order = strcmp((const char *)entry, name.c_str());
+		if (order == 0)
+		{
+			uint64_t offset, size;
+			memcpy(&offset, entry + ASSET_NAME_LENGTH, 8);
+			memcpy(&size, entry + ASSET_NAME_LENGTH + 8, 8);
+			view.data = file.data() + offset;
+			view.size = (size_t)size;
+			return view;
+		}
+		if (order < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return view;
+}
+// end::findAsset[]
+
+// tag::writeAssetPack[]
+bool writeAssetPack(const std::string &path, std::vector<PackEntry> entries, std::string &error)
+{
+	std::sort(entries.begin(), entries.end(),
+	          [](const PackEntry &a, const PackEntry &b) { return strcmp(a.name.c_str(), b.name.c_str()) < 0; });
+
+	std::vector<uint8_t> header(PACK_HEADER_SIZE + entries.size() * PACK_ENTRY_SIZE, 0);
+	memcpy(&header[0], ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC));
+	uint32_t count = (uint32_t)entries.size();
+	memcpy(&header[sizeof(ASSET_PACK_MAGIC)], &count, 4);
+
+	uint64_t offset = header.size();
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].name.size() >= ASSET_NAME_LENGTH)
+		{
+			error = "asset name " + entries[i].name + " is too long for a pack";
+			return false;
+		}
+		offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+		uint64_t size = entries[i].bytes.size();
+		uint8_t *entry = &header[PACK_HEADER_SIZE + i * PACK_ENTRY_SIZE];
+		memcpy(entry, entries[i].name.c_str(), entries[i].name.size());
+		memcpy(entry + ASSET_NAME_LENGTH, &offset, 8);
+		memcpy(entry + ASSET_NAME_LENGTH + 8, &size, 8);
+		offset += size;
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write((const char *)&header[0], header.size());
+	uint64_t written = header.size();
+	const char PADDING[PACK_ALIGNMENT] = {};
+	for (const PackEntry &entry : entries)
+	{
+		file.write(PADDING, (PACK_ALIGNMENT - written % PACK_ALIGNMENT) % PACK_ALIGNMENT);
+		written = (written + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+		file.write(entry.bytes.data(), entry.bytes.size());
+		written += entry.bytes.size();
+	}
+	if (!file)
+	{
+		error = "could not write asset pack " + path;
+		return false;
+	}
+	return true;
+}
+// end::writeAssetPack[]
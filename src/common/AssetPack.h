@@ -0,0 +1,64 @@
+#pragma once
+
+// Every file the game loads at startup (shaders, preprocessed meshes, the HUD font, textures) in
+// one archive, memory-mapped whole. Finding an asset is a binary search of the table of
+// contents, and what comes back points into the mapping, so it goes to glShaderSource,
+// glBufferData or SDL_RWFromConstMem with no read() and no heap copy on the way. One open file
+// instead of a dozen also means one set of metadata lookups, and the data is contiguous on disk.
+//
+// Layout (little-endian):
+//   "PONGPAK1", entry count (u32), 0 (u32)
+//   table of contents, sorted by name: name (48 bytes, NUL padded), offset (u64), size (u64)
+//   the data of each entry, starting on a 16 byte boundary
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+// names are paths relative to the game's working directory, like "models/paddle.mesh"
+const size_t ASSET_NAME_LENGTH = 48;
+
+// tag::AssetView[]
+// bytes owned by whatever they were found in - a pack or a mapped file - and valid while it's open
+struct AssetView
+{
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+
+	explicit operator bool() const { return data != nullptr; }
+};
+// end::AssetView[]
+
+// tag::AssetPack[]
+class AssetPack
+{
+public:
+	// returns false and sets error if path isn't a readable pack
+	bool open(const std::string &path, std::string &error);
+	void close();
+	bool isOpen() const { return file.isOpen(); }
+
+	// the asset called name, or an empty view if the pack doesn't have it
+	AssetView find(const std::string &name) const;
+
+	int count() const { return (int)entryCount; }
+	size_t size() const { return file.size(); }
+
+private:
+	MappedFile file;
+	uint32_t entryCount = 0;
+};
+// end::AssetPack[]
+
+struct PackEntry
+{
+	std::string name;
+	std::string bytes;
+};
+
+// write entries (in any order) as a pack; false with error if a name is too long or the file
+// can't be written
+bool writeAssetPack(const std::string &path, std::vector<PackEntry> entries, std::string &error);
@@ -0,0 +1,201 @@
+#include "Controller.h"
+
+#include <vector>
+
+#include "PaddleAI.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// tag::builtInControllers[]
+class PredictiveController : public Controller
+{
+public:
+	std::string name() const { return "predictive"; }
+	void decide(const FixedMatchState *matches, int count, int player, Random *, int *directions) const
+	{
+		for (int i = 0; i < count; i++)
+			directions[i] = predictiveDirectionFixed(matches[i], player);
+	}
+};
+
+class FollowController : public Controller
+{
+public:
+	std::string name() const { return "follow"; }
+	void decide(const FixedMatchState *matches, int count, int player, Random *, int *directions) const
+	{
+		for (int i = 0; i < count; i++)
+		{
+			Fixed paddleX = player == 1 ? matches[i].paddle1X : matches[i].paddle2X;
+			directions[i] = followBallDirection(paddleX.toFloat(), matches[i].ballX.toFloat());
+		}
+	}
+};
+
+// holds a random direction for about half a second at a time
+class RandomController : public Controller
+{
+public:
+	std::string name() const { return "random"; }
+	void decide(const FixedMatchState *matches, int count, int player, Random *randoms, int *directions) const
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (randoms[i].below(FIXED_TICK_RATE / 2) == 0)
+				directions[i] = randoms[i].direction();
+			else
+				directions[i] = player == 1 ? matches[i].paddle1Direction : matches[i].paddle2Direction;
+		}
+	}
+};
+
+class StillController : public Controller
+{
+public:
+	std::string name() const { return "still"; }
+	void decide(const FixedMatchState *, int count, int, Random *, int *directions) const
+	{
+		for (int i = 0; i < count; i++)
+			directions[i] = 0;
+	}
+};
+// end::builtInControllers[]
+
+// tag::PluginController[]
+class PluginController : public Controller
+{
+public:
+	~PluginController()
+	{
+		if (library)
+#ifdef _WIN32
+			FreeLibrary((HMODULE)library);
+#else
+			dlclose(library);
+#endif
+	}
+
+	bool load(const std::string &path, std::string &error)
+	{
+#ifdef _WIN32
+		library = (void *)LoadLibraryA(path.c_str());
+#else
+		library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+		if (!library)
+		{
+			error = "could not load plugin " + path;
+#ifndef _WIN32
+			error += std::string(": ") + dlerror();
+#endif
+			return false;
+		}
+
+		PongPluginAbiVersionFunction abiVersion = (PongPluginAbiVersionFunction)findSymbol("pong_plugin_abi_version");
+		PongPluginNameFunction pluginName = (PongPluginNameFunction)findSymbol("pong_plugin_name");
+		decideBatch = (PongDecideFunction)findSymbol("pong_decide");
+		if (!abiVersion || !pluginName || !decideBatch)
+		{
+			error = path + " is missing pong_plugin_abi_version, pong_plugin_name or pong_decide";
+			return false;
+		}
+		if (abiVersion() != PONG_PLUGIN_ABI_VERSION)
+		{
+			error = path + " was built for plugin ABI " + std::to_string(abiVersion()) + ", not " +
+			        std::to_string(PONG_PLUGIN_ABI_VERSION);
+			return false;
+		}
+		pluginNameString = pluginName();
+		return true;
+	}
+
+	std::string name() const { return pluginNameString; }
+
+	// one call into the plugin for the whole batch, through per-thread buffers that only grow
+	void decide(const FixedMatchState *matches, int count, int player, Random *, int *directions) const
+	{
+		static thread_local std::vector<PongState> states;
+		static thread_local std::vector<float> out;
+		if (count <= 0)
+			return;
+		if ((int)states.size() < count)
+		{
+			states.resize(count);
+			out.resize(count);
+		}
+
+		for (int i = 0; i < count; i++)
+			toPongState(matches[i], player, states[i]);
+		decideBatch(&states[0], count, &out[0]);
+		for (int i = 0; i < count; i++)
+			directions[i] = out[i] < -0.5f ? -1 : (out[i] > 0.5f ? 1 : 0);
+	}
+
+private:
+	void *findSymbol(const char *symbol)
+	{
+#ifdef _WIN32
+		return (void *)GetProcAddress((HMODULE)library, symbol);
+#else
+		return dlsym(library, symbol);
+#endif
+	}
+
+	void *library = nullptr;
+	PongDecideFunction decideBatch = nullptr;
+	std::string pluginNameString;
+};
+// end::PluginController[]
+
+// tag::createController[]
+std::unique_ptr<Controller> createController(const std::string &spec, std::string &error)
+{
+	const std::string PLUGIN_PREFIX = "plugin:";
+
+	if (spec == "predictive")
+		return std::unique_ptr<Controller>(new PredictiveController());
+	if (spec == "follow")
+		return std::unique_ptr<Controller>(new FollowController());
+	if (spec == "random")
+		return std::unique_ptr<Controller>(new RandomController());
+	if (spec == "still")
+		return std::unique_ptr<Controller>(new StillController());
+	if (spec.compare(0, PLUGIN_PREFIX.size(), PLUGIN_PREFIX) == 0)
+	{
+		std::unique_ptr<PluginController> plugin(new PluginController());
+		if (!plugin->load(spec.substr(PLUGIN_PREFIX.size()), error))
+			return std::unique_ptr<Controller>();
+		return std::unique_ptr<Controller>(plugin.release());
+	}
+
+	error = "unknown controller " + spec + " (expected " + controllerSpecs() + ")";
+	return std::unique_ptr<Controller>();
+}
+// end::createController[]
+
+const char *controllerSpecs()
+{
+	return "predictive, follow, random, still or plugin:<path>";
+}
+
+void toPongState(const FixedMatchState &match, int player, PongState &state)
+{
+	state.player = player;
+	state.paddle1X = match.paddle1X.raw;
+	state.paddle2X = match.paddle2X.raw;
+	state.paddle1Z = match.paddle1Z.raw;
+	state.paddle2Z = match.paddle2Z.raw;
+	state.ballX = match.ballX.raw;
+	state.ballZ = match.ballZ.raw;
+	state.ballDirectionX = match.ballDirectionX;
+	state.ballDirectionZ = match.ballDirectionZ;
+	state.paddle1Direction = match.paddle1Direction;
+	state.paddle2Direction = match.paddle2Direction;
+	state.player1Score = match.player1Score;
+	state.player2Score = match.player2Score;
+}
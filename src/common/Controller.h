@@ -0,0 +1,41 @@
+#pragma once
+
+// Keyboard-free paddle controllers: the built in computer players, and plugins loaded from
+// shared libraries through the C interface in PongPlugin.h.
+//
+// Controllers decide for a batch of matches per call - everything one thread is running with
+// that controller - so the virtual call (or call into a plugin) happens once per batch per tick,
+// not once per paddle per tick, and the per-match work is a tight loop the compiler can see.
+// A controller is shared by every match it plays in, possibly on several threads at once, so
+// decide() is const; anything that varies per match comes from the match and its Random.
+
+#include <memory>
+#include <string>
+
+#include "FixedSimulation.h"
+#include "Random.h"
+#include "PongPlugin.h"
+
+// tag::Controller[]
+class Controller
+{
+public:
+	virtual ~Controller() {}
+
+	virtual std::string name() const = 0;
+
+	// -1, 0 or 1 for player's (1 or 2) paddle in each of the count matches; randoms[i] is
+	// matches[i]'s own random stream
+	virtual void decide(const FixedMatchState *matches, int count, int player, Random *randoms, int *directions) const = 0;
+};
+
+// "predictive", "follow", "random", "still" or "plugin:<path to .so>"; returns null and sets
+// error if spec isn't one of those or the plugin can't be loaded
+std::unique_ptr<Controller> createController(const std::string &spec, std::string &error);
+
+// the names createController accepts, for usage messages
+const char *controllerSpecs();
+// end::Controller[]
+
+// the plugin's view of a match
+void toPongState(const FixedMatchState &match, int player, PongState &state);
@@ -0,0 +1,59 @@
+#pragma once
+
+// Q16.16 fixed point numbers - 16 integer bits and 16 fraction bits in an int32_t.
+//
+// Everything is integer arithmetic with explicitly defined rounding, so the same inputs give the
+// same bits on every compiler and CPU, which floating point (with its contraction, x87 precision
+// and library differences) does not promise.
+
+#include <cstdint>
+#include <cmath>
+
+// tag::Fixed[]
+struct Fixed
+{
+	int32_t raw;
+
+	static const int FRACTION_BITS = 16;
+	static const int32_t ONE = 1 << FRACTION_BITS;
+
+	static constexpr Fixed fromRaw(int32_t raw) { return Fixed{ raw }; }
+	static constexpr Fixed fromInt(int value) { return Fixed{ (int32_t)value * ONE }; }
+
+	// numerator / denominator rounded to the nearest step, for exact constants without floats
+	static constexpr Fixed fromRatio(int64_t numerator, int64_t denominator)
+	{
+		return Fixed{ (int32_t)(numerator >= 0 ? (numerator * ONE * 2 + denominator) / (denominator * 2)
+		                                       : -((-numerator * ONE * 2 + denominator) / (denominator * 2))) };
+	}
+
+	// only for moving state in and out of the float world, never used inside the simulation
+	static Fixed fromFloat(float value) { return Fixed{ (int32_t)lroundf(value * ONE) }; }
+	float toFloat() const { return raw / (float)ONE; }
+};
+// end::Fixed[]
+
+// tag::FixedOperators[]
+// floor(value / 2^16), written out because shifting a negative number right is implementation defined
+inline int32_t floorShift16(int64_t value)
+{
+	return (int32_t)(value >= 0 ? value / Fixed::ONE : -((-value + Fixed::ONE - 1) / Fixed::ONE));
+}
+
+inline constexpr Fixed operator+(Fixed a, Fixed b) { return Fixed{ a.raw + b.raw }; }
+inline constexpr Fixed operator-(Fixed a, Fixed b) { return Fixed{ a.raw - b.raw }; }
+inline constexpr Fixed operator-(Fixed a) { return Fixed{ -a.raw }; }
+inline Fixed operator*(Fixed a, Fixed b) { return Fixed{ floorShift16((int64_t)a.raw * b.raw) }; }
+inline constexpr Fixed operator*(Fixed a, int b) { return Fixed{ a.raw * b }; }
+inline constexpr Fixed operator/(Fixed a, int b) { return Fixed{ a.raw / b }; } // rounds towards zero
+
+inline Fixed &operator+=(Fixed &a, Fixed b) { a.raw += b.raw; return a; }
+inline Fixed &operator-=(Fixed &a, Fixed b) { a.raw -= b.raw; return a; }
+
+inline constexpr bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+inline constexpr bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+inline constexpr bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+inline constexpr bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+inline constexpr bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+inline constexpr bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+// end::FixedOperators[]
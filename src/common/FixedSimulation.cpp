@@ -0,0 +1,147 @@
+#include "FixedSimulation.h"
+
+// tag::checkSideBoundsFixed[]
+bool checkSideBoundsFixed(Fixed *value, bool leftSide, const Fixed ITEM_WIDTH)
+{
+	if (leftSide)
+	{
+		const Fixed LIMIT = (-FIXED_AREA_WIDTH / 2) + ITEM_WIDTH / 2 + FIXED_WORLD_BOUNDS_WIDTH / 2;
+		if (*value < LIMIT)
+		{
+			*value = LIMIT;
+			return true;
+		}
+		else
+			return false;
+	}
+	else {
+		const Fixed LIMIT = (FIXED_AREA_WIDTH / 2) - ITEM_WIDTH / 2 - FIXED_WORLD_BOUNDS_WIDTH / 2;
+		if (*value > LIMIT)
+		{
+			*value = LIMIT;
+			return true;
+		}
+		else
+			return false;
+	}
+}
+// end::checkSideBoundsFixed[]
+
+// tag::checkBallPaddleCollisionFixed[]
+bool checkBallPaddleCollisionFixed(const FixedMatchState &match, Fixed paddleX, Fixed paddleZ)
+{
+	return paddleX - FIXED_PADDLE_WIDTH / 2 < match.ballX + FIXED_BALL_WIDTH / 2 &&
+	       paddleX + FIXED_PADDLE_WIDTH / 2 > match.ballX - FIXED_BALL_WIDTH / 2 &&
+	       paddleZ - FIXED_PADDLE_DEPTH / 2 < match.ballZ + FIXED_BALL_WIDTH / 2 &&
+	       paddleZ + FIXED_PADDLE_DEPTH / 2 > match.ballZ - FIXED_BALL_WIDTH / 2;
+}
+// end::checkBallPaddleCollisionFixed[]
+
+// tag::stepMatchFixed[]
+int stepMatchFixed(FixedMatchState &match, Fixed delta)
+{
+	int scorer = 0;
+
+	// move paddle
+	const Fixed PADDLE_STEP = FIXED_PADDLE_VELOCITY * delta;
+	match.paddle1X += PADDLE_STEP * match.paddle1Direction;
+
+	// make sure that the paddles can't go out of bounds
+	checkSideBoundsFixed(&match.paddle1X, true, FIXED_PADDLE_WIDTH);
+	checkSideBoundsFixed(&match.paddle1X, false, FIXED_PADDLE_WIDTH);
+
+	match.paddle2X += PADDLE_STEP * match.paddle2Direction;
+
+	checkSideBoundsFixed(&match.paddle2X, true, FIXED_PADDLE_WIDTH);
+	checkSideBoundsFixed(&match.paddle2X, false, FIXED_PADDLE_WIDTH);
+
+	// move the ball
+	const Fixed BALL_STEP = FIXED_BALL_VELOCITY * delta;
+	match.ballX += BALL_STEP * match.ballDirectionX;
+	match.ballZ += BALL_STEP * match.ballDirectionZ;
+
+	// reverse the direction of the ball if it hits the side wall
+	if (checkSideBoundsFixed(&match.ballX, false, FIXED_BALL_WIDTH) || checkSideBoundsFixed(&match.ballX, true, FIXED_BALL_WIDTH))
+		match.ballDirectionX = -match.ballDirectionX;
+
+	// check for paddle collisions
+	if (checkBallPaddleCollisionFixed(match, match.paddle1X, match.paddle1Z) || checkBallPaddleCollisionFixed(match, match.paddle2X, match.paddle2Z))
+	{
+		if (!match.isColliding)
+		{
+			match.ballDirectionZ = -match.ballDirectionZ;
+			match.isColliding = true;
+		}
+	}
+	else {
+		match.isColliding = false;
+	}
+
+	// check if a player has missed
+	if ((FIXED_AREA_DEPTH / 2 - FIXED_WORLD_BOUNDS_WIDTH / 2 < match.ballZ + FIXED_BALL_WIDTH / 2) ||
+	    (-FIXED_AREA_DEPTH / 2 + FIXED_WORLD_BOUNDS_WIDTH / 2 > match.ballZ - FIXED_BALL_WIDTH / 2))
+	{
+		if (match.ballZ < Fixed::fromInt(0))
+		{
+			match.player1Score++;
+			scorer = 1;
+		}
+		else
+		{
+			match.player2Score++;
+			scorer = 2;
+		}
+		match.ballDirectionX = -match.ballDirectionX;
+		match.ballDirectionZ = -match.ballDirectionZ;
+		match.ballX = Fixed::fromInt(0);
+		match.ballZ = Fixed::fromInt(0);
+	}
+
+	return scorer;
+}
+// end::stepMatchFixed[]
+
+// tag::randomiseStart[]
+void randomiseStart(FixedMatchState &match, Random &random)
+{
+	const Fixed PADDLE_RANGE = FIXED_AREA_WIDTH - FIXED_PADDLE_WIDTH - FIXED_WORLD_BOUNDS_WIDTH;
+
+	match = FixedMatchState();
+	match.paddle1X = Fixed::fromRaw((int32_t)random.below(PADDLE_RANGE.raw)) - PADDLE_RANGE / 2;
+	match.paddle2X = Fixed::fromRaw((int32_t)random.below(PADDLE_RANGE.raw)) - PADDLE_RANGE / 2;
+	match.ballDirectionX = random.below(2) ? 1 : -1;
+	match.ballDirectionZ = random.below(2) ? 1 : -1;
+}
+// end::randomiseStart[]
+
+// tag::convertMatchState[]
+void toMatchState(const FixedMatchState &fixed, MatchState &match)
+{
+	match.paddle1Position = glm::vec3(fixed.paddle1X.toFloat(), 0, fixed.paddle1Z.toFloat());
+	match.paddle2Position = glm::vec3(fixed.paddle2X.toFloat(), 0, fixed.paddle2Z.toFloat());
+	match.paddle1Direction = (float)fixed.paddle1Direction;
+	match.paddle2Direction = (float)fixed.paddle2Direction;
+	match.ballPosition = glm::vec3(fixed.ballX.toFloat(), 0, fixed.ballZ.toFloat());
+	match.ballDirection = glm::vec3((float)fixed.ballDirectionX, 0, (float)fixed.ballDirectionZ);
+	match.player1Score = fixed.player1Score;
+	match.player2Score = fixed.player2Score;
+	match.isColliding = fixed.isColliding;
+}
+
+void fromMatchState(const MatchState &match, FixedMatchState &fixed)
+{
+	fixed.paddle1X = Fixed::fromFloat(match.paddle1Position.x);
+	fixed.paddle2X = Fixed::fromFloat(match.paddle2Position.x);
+	fixed.paddle1Z = Fixed::fromFloat(match.paddle1Position.z);
+	fixed.paddle2Z = Fixed::fromFloat(match.paddle2Position.z);
+	fixed.paddle1Direction = match.paddle1Direction < 0 ? -1 : (match.paddle1Direction > 0 ? 1 : 0);
+	fixed.paddle2Direction = match.paddle2Direction < 0 ? -1 : (match.paddle2Direction > 0 ? 1 : 0);
+	fixed.ballX = Fixed::fromFloat(match.ballPosition.x);
+	fixed.ballZ = Fixed::fromFloat(match.ballPosition.z);
+	fixed.ballDirectionX = match.ballDirection.x < 0 ? -1 : 1;
+	fixed.ballDirectionZ = match.ballDirection.z < 0 ? -1 : 1;
+	fixed.player1Score = match.player1Score;
+	fixed.player2Score = match.player2Score;
+	fixed.isColliding = match.isColliding;
+}
+// end::convertMatchState[]
@@ -0,0 +1,62 @@
+#pragma once
+
+// The Pong rules from Simulation.h in Q16.16 fixed point, for lockstep play and replays where
+// every machine has to arrive at exactly the same state. Time advances in whole ticks of
+// FIXED_TICK rather than by however long the last frame took.
+
+#include "FixedPoint.h"
+#include "Simulation.h"
+#include "Random.h"
+
+// the same constants as Simulation.h, as exact ratios
+const Fixed FIXED_PADDLE_WIDTH = Fixed::fromRatio(1, 2);
+const Fixed FIXED_PADDLE_DEPTH = Fixed::fromRatio(1, 4);
+const Fixed FIXED_AREA_WIDTH = Fixed::fromRatio(13, 5);
+const Fixed FIXED_AREA_DEPTH = Fixed::fromInt(6);
+const Fixed FIXED_WORLD_BOUNDS_WIDTH = Fixed::fromRatio(1, 4);
+const Fixed FIXED_BALL_WIDTH = Fixed::fromRatio(1, 10);
+
+const Fixed FIXED_PADDLE_VELOCITY = Fixed::fromRatio(6, 5);
+const Fixed FIXED_BALL_VELOCITY = Fixed::fromRatio(3, 2);
+
+// a power of two, so a tick and the ball's movement in a tick are exact in binary - this keeps
+// the fixed point rules in step with the float rules when both run at this rate
+const int FIXED_TICK_RATE = 128;
+const Fixed FIXED_TICK = Fixed::fromRatio(1, FIXED_TICK_RATE);
+
+// tag::FixedMatchState[]
+struct FixedMatchState
+{
+	Fixed paddle1X = Fixed::fromInt(0);
+	Fixed paddle2X = Fixed::fromInt(0);
+	Fixed paddle1Z = Fixed::fromInt(2);
+	Fixed paddle2Z = Fixed::fromInt(-2);
+
+	int paddle1Direction = 0; // -1 left, 0 still, 1 right
+	int paddle2Direction = 0;
+
+	Fixed ballX = Fixed::fromInt(0);
+	Fixed ballZ = Fixed::fromInt(0);
+	int ballDirectionX = 1; // the ball only ever moves diagonally
+	int ballDirectionZ = 1;
+
+	int player1Score = 0;
+	int player2Score = 0;
+
+	bool isColliding = false;
+};
+// end::FixedMatchState[]
+
+bool checkSideBoundsFixed(Fixed *value, bool leftSide, const Fixed ITEM_WIDTH);
+
+bool checkBallPaddleCollisionFixed(const FixedMatchState &match, Fixed paddleX, Fixed paddleZ);
+
+// advance the match by one tick of length delta, returns the player who scored (1 or 2) or 0
+int stepMatchFixed(FixedMatchState &match, Fixed delta = FIXED_TICK);
+
+// a new match with the paddles somewhere random and the ball served in a random diagonal
+void randomiseStart(FixedMatchState &match, Random &random);
+
+// convert to and from the float state, e.g. for rendering or to start from a float match
+void toMatchState(const FixedMatchState &fixed, MatchState &match);
+void fromMatchState(const MatchState &match, FixedMatchState &fixed);
@@ -0,0 +1,101 @@
+#include "MappedFile.h"
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "StateHash.h"
+
+// tag::openMappedFile[]
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path)
+{
+	close();
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		file = nullptr;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping)
+		bytes = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!bytes)
+	{
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes)
+		UnmapViewOfFile(bytes);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+	bytes = nullptr;
+	mapping = file = nullptr;
+	length = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path)
+{
+	close();
+	int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0)
+		return false;
+
+	// an empty file can't be mapped, and is no use anyway
+	struct stat status;
+	if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+	{
+		void *memory = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (memory != MAP_FAILED)
+		{
+			bytes = (const uint8_t *)memory;
+			length = (size_t)status.st_size;
+		}
+	}
+	::close(descriptor); // the mapping keeps the file open
+	return bytes != nullptr;
+}
+
+void MappedFile::close()
+{
+	if (bytes)
+		munmap((void *)bytes, length);
+	bytes = nullptr;
+	length = 0;
+}
+
+#endif
+// end::openMappedFile[]
+
+uint64_t fileStamp(const std::string &path)
+{
+	struct stat status;
+	if (stat(path.c_str(), &status) != 0)
+		return 0;
+	int64_t stamp[2] = { (int64_t)status.st_size, (int64_t)status.st_mtime };
+	return hashBytes(stamp, sizeof(stamp));
+}
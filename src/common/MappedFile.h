@@ -0,0 +1,41 @@
+#pragma once
+
+// A whole file mapped read-only into memory, so data that's already in the layout it's needed in
+// (preprocessed meshes, packed assets) can be handed straight to its consumer - glBufferData,
+// glShaderSource - with no read() into a buffer first. The pages come from the OS file cache,
+// so a file opened for the second time costs a page table update rather than a copy.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// tag::MappedFile[]
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// map the whole of path, replacing any file already mapped; false if it can't be opened
+	bool open(const std::string &path);
+	void close();
+
+	bool isOpen() const { return bytes != nullptr; }
+	const uint8_t *data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const uint8_t *bytes = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void *file = nullptr;
+	void *mapping = nullptr;
+#endif
+};
+// end::MappedFile[]
+
+// size and modification time of path, hashed - cheap to check on every launch and changes
+// whenever the file is saved. 0 if it doesn't exist
+uint64_t fileStamp(const std::string &path);
@@ -0,0 +1,254 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// tag::FifoCache[]
+// a post-transform cache: a vertex is in it if fewer than size misses have happened since it was
+// last missed
+class FifoCache
+{
+public:
+	FifoCache(size_t vertexCount, int size) : stamps(vertexCount, 0), size((uint32_t)size), time((uint32_t)size + 1) {}
+
+	// cache misses for one vertex
+	int add(uint16_t vertex)
+	{
+		if (time - stamps[vertex] <= size)
+			return 0;
+		stamps[vertex] = time++;
+		return 1;
+	}
+
+	// for a triangle
+	int add(const uint16_t *triangle) { return add(triangle[0]) + add(triangle[1]) + add(triangle[2]); }
+
+	// misses since vertex last entered the cache - it's still in while this is at most the size
+	uint32_t age(uint16_t vertex) const { return time - stamps[vertex]; }
+
+	void clear() { time += size + 1; }
+
+private:
+	std::vector<uint32_t> stamps;
+	uint32_t size;
+	uint32_t time;
+};
+// end::FifoCache[]
+
+// tag::analyzeVertexCache[]
+VertexCacheStats analyzeVertexCache(const std::vector<uint16_t> &indices, size_t vertexCount, int cacheSize)
+{
+	FifoCache cache(vertexCount, cacheSize);
+	std::vector<bool> used(vertexCount, false);
+	size_t misses = 0, usedCount = 0;
+	for (uint16_t vertex : indices)
+	{
+		if (!used[vertex])
+		{
+			used[vertex] = true;
+			usedCount++;
+		}
+		misses += cache.add(vertex);
+	}
+
+	VertexCacheStats stats;
+	stats.acmr = indices.size() >= 3 ? (float)misses / (indices.size() / 3) : 0;
+	stats.atvr = usedCount > 0 ? (float)misses / usedCount : 0;
+	return stats;
+}
+// end::analyzeVertexCache[]
+
+// tag::optimizeVertexCache[]
+// Tipsify: fan out from one vertex at a time, emitting every triangle left around it, then move to
+// the vertex just emitted that will still be in the cache once its own remaining triangles are
+// emitted and has been there longest - or, if there isn't one, back to the most recent vertex that
+// still has triangles (a dead end), or else the next such vertex in index order
+static int skipDeadEnd(std::vector<uint16_t> &deadEnds, const std::vector<uint32_t> &live, size_t &cursor)
+{
+	while (!deadEnds.empty())
+	{
+		uint16_t vertex = deadEnds.back();
+		deadEnds.pop_back();
+		if (live[vertex] > 0)
+			return vertex;
+	}
+	for (; cursor < live.size(); cursor++)
+		if (live[cursor] > 0)
+			return (int)cursor;
+	return -1;
+}
+
+void optimizeVertexCache(std::vector<uint16_t> &indices, size_t vertexCount, int cacheSize)
+{
+	size_t triangleCount = indices.size() / 3;
+
+	// the triangles around each vertex, and how many of them are still to be emitted
+	std::vector<uint32_t> live(vertexCount, 0), firstTriangle(vertexCount + 1, 0), triangles(triangleCount * 3);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		live[indices[i]]++;
+	for (size_t vertex = 0; vertex < vertexCount; vertex++)
+		firstTriangle[vertex + 1] = firstTriangle[vertex] + live[vertex];
+	std::vector<uint32_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		triangles[filled[indices[i]]++] = (uint32_t)(i / 3);
+
+	std::vector<uint16_t> output, deadEnds, candidates;
+	output.reserve(triangleCount * 3);
+	deadEnds.reserve(triangleCount * 3);
+	std::vector<bool> emitted(triangleCount, false);
+	FifoCache cache(vertexCount, cacheSize);
+	size_t cursor = 0;
+
+	int fanning = skipDeadEnd(deadEnds, live, cursor);
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		for (uint32_t i = firstTriangle[fanning]; i < firstTriangle[fanning + 1]; i++)
+		{
+			uint32_t triangle = triangles[i];
+			if (emitted[triangle])
+				continue;
+			emitted[triangle] = true;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint16_t vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				live[vertex]--;
+				cache.add(vertex);
+			}
+		}
+
+		// each of a vertex's remaining triangles can push up to two new vertices into the cache
+		int next = -1;
+		long long bestPriority = -1;
+		for (uint16_t vertex : candidates)
+		{
+			if (live[vertex] == 0)
+				continue;
+			long long priority = 0;
+			if (cache.age(vertex) + 2 * live[vertex] <= (uint32_t)cacheSize)
+				priority = cache.age(vertex);
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+		fanning = next >= 0 ? next : skipDeadEnd(deadEnds, live, cursor);
+	}
+
+	indices.swap(output);
+}
+// end::optimizeVertexCache[]
+
+// tag::optimizeOverdraw[]
+struct TriangleCluster
+{
+	size_t begin, end; // triangles
+	float sortKey;
+};
+
+void optimizeOverdraw(std::vector<uint16_t> &indices, const float *positions, size_t vertexCount, size_t stride,
+                      float threshold, int cacheSize)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+		return;
+
+	// hard boundaries: triangles the cache order reaches with nothing of them cached
+	std::vector<size_t> hardStarts;
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		int misses = cache.add(&indices[triangle * 3]);
+		if (triangle == 0 || misses == 3)
+			hardStarts.push_back(triangle);
+	}
+	hardStarts.push_back(triangleCount);
+
+	// soft boundaries: within each, wherever starting again cold costs little
+	std::vector<TriangleCluster> clusters;
+	for (size_t hard = 0; hard + 1 < hardStarts.size(); hard++)
+	{
+		size_t begin = hardStarts[hard], end = hardStarts[hard + 1];
+		cache.clear();
+		int clusterMisses = 0;
+		for (size_t triangle = begin; triangle < end; triangle++)
+			clusterMisses += cache.add(&indices[triangle * 3]);
+		float clusterACMR = (float)clusterMisses / (end - begin);
+
+		cache.clear();
+		int misses = 0;
+		size_t first = begin;
+		for (size_t triangle = begin; triangle < end; triangle++)
+		{
+			misses += cache.add(&indices[triangle * 3]);
+			if (triangle + 1 < end && misses <= threshold * clusterACMR * (triangle + 1 - first))
+			{
+				TriangleCluster cluster = { first, triangle + 1, 0 };
+				clusters.push_back(cluster);
+				first = triangle + 1;
+				misses = 0;
+				cache.clear();
+			}
+		}
+		TriangleCluster cluster = { first, end, 0 };
+		clusters.push_back(cluster);
+	}
+
+	// area-weighted centroid and normal of each cluster, and of the whole mesh
+	auto position = [&](uint16_t vertex) { return (const float *)((const char *)positions + vertex * stride); };
+	std::vector<float> centroids(clusters.size() * 3, 0), normals(clusters.size() * 3, 0);
+	float meshCentroid[3] = { 0, 0, 0 }, meshArea = 0;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		float area = 0;
+		for (size_t triangle = clusters[c].begin; triangle < clusters[c].end; triangle++)
+		{
+			const float *a = position(indices[triangle * 3]);
+			const float *b = position(indices[triangle * 3 + 1]);
+			const float *d = position(indices[triangle * 3 + 2]);
+			float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			float ad[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+			float normal[3] = { ab[1] * ad[2] - ab[2] * ad[1], ab[2] * ad[0] - ab[0] * ad[2], ab[0] * ad[1] - ab[1] * ad[0] };
+			float triangleArea = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				centroids[c * 3 + axis] += (a[axis] + b[axis] + d[axis]) / 3 * triangleArea;
+				normals[c * 3 + axis] += normal[axis];
+			}
+			area += triangleArea;
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			meshCentroid[axis] += centroids[c * 3 + axis];
+			centroids[c * 3 + axis] = area > 0 ? centroids[c * 3 + axis] / area : 0;
+		}
+		meshArea += area;
+	}
+	for (int axis = 0; axis < 3; axis++)
+		meshCentroid[axis] = meshArea > 0 ? meshCentroid[axis] / meshArea : 0;
+
+	// how far out and facing outwards: these are the clusters most likely to hide the others
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		const float *normal = &normals[c * 3];
+		float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float key = 0;
+		for (int axis = 0; axis < 3; axis++)
+			key += (centroids[c * 3 + axis] - meshCentroid[axis]) * normal[axis];
+		clusters[c].sortKey = length > 0 ? key / length : 0;
+	}
+	std::stable_sort(clusters.begin(), clusters.end(),
+	                 [](const TriangleCluster &a, const TriangleCluster &b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint16_t> output;
+	output.reserve(indices.size());
+	for (const TriangleCluster &cluster : clusters)
+		output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	output.insert(output.end(), indices.begin() + triangleCount * 3, indices.end()); // any stray indices
+	indices.swap(output);
+}
+// end::optimizeOverdraw[]
@@ -0,0 +1,49 @@
+#pragma once
+
+// Triangle and vertex order for indexed triangle lists, so a mesh costs as little as possible to
+// draw whatever it looks like. Run on a model once, when it's imported, in this order:
+//
+//   optimizeVertexCache - Tipsify (Sander, Nehab and Barczak 2007): reorders triangles so most
+//                         vertices are still in the GPU's post-transform cache when they're used
+//                         again, and the vertex shader runs about once per vertex instead of up
+//                         to six times
+//   optimizeOverdraw    - cuts that order into clusters where the cache starts cold anyway (plus
+//                         a few more, as long as that costs little cache efficiency) and draws
+//                         the clusters facing furthest out first, so later, hidden triangles fail
+//                         the depth test rather than being shaded and then covered
+//   (vertex fetch)      - then renumber the vertices in first-use order (Mesh.h's
+//                         optimizeVertexFetch, which needs the game's vertex layout)
+//
+// None of it needs a GL context, so the headless tools can measure it. Indices are 16-bit, like
+// the game's meshes.
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// the FIFO post-transform cache every measurement here assumes; Tipsify is tuned for it, and a
+// bigger real cache only does better
+const int VERTEX_CACHE_SIZE = 16;
+
+// tag::VertexCacheStats[]
+struct VertexCacheStats
+{
+	float acmr; // average cache miss ratio: vertex shader runs per triangle - 0.5 at best, 3 at worst
+	float atvr; // average transformed vertex ratio: runs per vertex used - 1 at best
+};
+// end::VertexCacheStats[]
+
+// simulate drawing the triangles through a FIFO cache of cacheSize vertices
+VertexCacheStats analyzeVertexCache(const std::vector<uint16_t> &indices, size_t vertexCount,
+                                    int cacheSize = VERTEX_CACHE_SIZE);
+
+// reorder the triangles of indices (over vertexCount vertices) for a cache of cacheSize; each
+// triangle keeps its winding
+void optimizeVertexCache(std::vector<uint16_t> &indices, size_t vertexCount, int cacheSize = VERTEX_CACHE_SIZE);
+
+// reorder clusters of a cache-optimized triangle order to cut overdraw. positions are x, y, z
+// floats at the start of each vertex, stride bytes apart. A cluster boundary is added wherever the
+// ACMR so far in the cluster is within threshold times the whole cluster's, so 1 keeps the cache
+// order almost untouched and bigger values trade cache efficiency for overdraw
+void optimizeOverdraw(std::vector<uint16_t> &indices, const float *positions, size_t vertexCount, size_t stride,
+                      float threshold = 1.05f, int cacheSize = VERTEX_CACHE_SIZE);
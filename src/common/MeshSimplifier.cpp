@@ -0,0 +1,246 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+// tag::Quadric[]
+// sum of squared distances to a set of planes, as the symmetric 4x4 matrix of Garland and Heckbert
+struct Quadric
+{
+	double a2 = 0, b2 = 0, c2 = 0, ab = 0, ac = 0, bc = 0, ad = 0, bd = 0, cd = 0, d2 = 0;
+
+	void addPlane(double a, double b, double c, double d)
+	{
+		a2 += a * a; b2 += b * b; c2 += c * c;
+		ab += a * b; ac += a * c; bc += b * c;
+		ad += a * d; bd += b * d; cd += c * d;
+		d2 += d * d;
+	}
+
+	void add(const Quadric &other)
+	{
+		a2 += other.a2; b2 += other.b2; c2 += other.c2;
+		ab += other.ab; ac += other.ac; bc += other.bc;
+		ad += other.ad; bd += other.bd; cd += other.cd;
+		d2 += other.d2;
+	}
+
+	double error(const float *p) const
+	{
+		double x = p[0], y = p[1], z = p[2];
+		double value = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z) +
+		               2 * (ad * x + bd * y + cd * z) + d2;
+		return std::max(0.0, value); // rounding can take it just below 0
+	}
+};
+// end::Quadric[]
+
+// a collapse may turn a triangle by up to about 75 degrees; any more and it's likely to be folding
+// over its neighbours or standing on edge
+const double MAX_TURN_COSINE = 0.25;
+
+struct Collapse
+{
+	uint16_t from, to;
+	double error;
+};
+
+static void cross(const float *a, const float *b, const float *c, double *normal)
+{
+	double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+	normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+	normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+	normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+}
+
+static double dot(const double *a, const double *b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+float meshRadius(const float *positions, size_t vertexCount, size_t stride)
+{
+	float low[3] = { 1e30f, 1e30f, 1e30f }, high[3] = { -1e30f, -1e30f, -1e30f };
+	for (size_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		const float *p = (const float *)((const char *)positions + vertex * stride);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			low[axis] = std::min(low[axis], p[axis]);
+			high[axis] = std::max(high[axis], p[axis]);
+		}
+	}
+	if (vertexCount == 0)
+		return 0;
+	float size[3] = { high[0] - low[0], high[1] - low[1], high[2] - low[2] };
+	return 0.5f * std::sqrt(size[0] * size[0] + size[1] * size[1] + size[2] * size[2]);
+}
+
+// tag::simplifyMesh[]
+std::vector<uint16_t> simplifyMesh(const std::vector<uint16_t> &indices, const float *positions, size_t vertexCount,
+                                   size_t stride, size_t targetIndexCount, float targetError, float &error)
+{
+	auto position = [&](uint16_t vertex) { return (const float *)((const char *)positions + vertex * stride); };
+	std::vector<uint16_t> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+	error = 0;
+
+	float radius = meshRadius(positions, vertexCount, stride);
+	if (radius == 0)
+		return result;
+	double errorLimit = (double)targetError * radius * targetError * radius; // quadric errors are squared distances
+
+	// every plane through each vertex; degenerate triangles have no plane
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		double normal[3];
+		cross(position(result[i]), position(result[i + 1]), position(result[i + 2]), normal);
+		double length = std::sqrt(dot(normal, normal));
+		if (length == 0)
+			continue;
+		double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+		const float *p = position(result[i]);
+		double d = -(a * p[0] + b * p[1] + c * p[2]);
+		for (int corner = 0; corner < 3; corner++)
+			quadrics[result[i + corner]].addPlane(a, b, c, d);
+	}
+
+	// a vertex is locked if it's on a half-edge with no opposite
+	std::unordered_set<uint32_t> halfEdges;
+	for (size_t i = 0; i < result.size(); i += 3)
+		for (int corner = 0; corner < 3; corner++)
+			halfEdges.insert((uint32_t)result[i + corner] << 16 | result[i + (corner + 1) % 3]);
+	std::vector<bool> locked(vertexCount, false);
+	for (uint32_t edge : halfEdges)
+		if (!halfEdges.count(edge << 16 | edge >> 16))
+			locked[edge >> 16] = locked[edge & 0xffff] = true;
+
+	// passes of independent collapses, each pass re-costing what's left, until the target is met
+	// or nothing cheap enough is left
+	std::vector<uint32_t> firstTriangle(vertexCount + 1), triangles;
+	std::vector<Collapse> candidates;
+	std::vector<bool> touched(vertexCount);
+	std::vector<uint16_t> remap(vertexCount);
+	while (result.size() > targetIndexCount)
+	{
+		// the triangles round each vertex
+		std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+		for (uint16_t vertex : result)
+			firstTriangle[vertex + 1]++;
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+			firstTriangle[vertex + 1] += firstTriangle[vertex];
+		triangles.resize(result.size());
+		std::vector<uint32_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < result.size(); i++)
+			triangles[filled[result[i]]++] = (uint32_t)(i / 3);
+
+		// the cheapest collapse of each vertex that can move
+		candidates.clear();
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			if (locked[vertex])
+				continue;
+			Collapse best = { (uint16_t)vertex, 0, -1 };
+			for (uint32_t t = firstTriangle[vertex]; t < firstTriangle[vertex + 1]; t++)
+				for (int corner = 0; corner < 3; corner++)
+				{
+					uint16_t other = result[triangles[t] * 3 + corner];
+					if (other == vertex)
+						continue;
+					double cost = quadrics[vertex].error(position(other));
+					if (best.error < 0 || cost < best.error)
+					{
+						best.to = other;
+						best.error = cost;
+					}
+				}
+			if (best.error >= 0 && best.error <= errorLimit)
+				candidates.push_back(best);
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+		// each collapse takes out about two triangles
+		size_t wanted = std::max<size_t>(1, (result.size() - targetIndexCount) / 6);
+		size_t applied = 0;
+		std::fill(touched.begin(), touched.end(), false);
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+			remap[vertex] = (uint16_t)vertex;
+		for (const Collapse &collapse : candidates)
+		{
+			if (applied >= wanted)
+				break;
+			if (touched[collapse.from] || touched[collapse.to])
+				continue;
+
+			// no triangle round from that stays a triangle may turn over, or nearly
+			bool flips = false;
+			for (uint32_t t = firstTriangle[collapse.from]; t < firstTriangle[collapse.from + 1] && !flips; t++)
+			{
+				const uint16_t *triangle = &result[triangles[t] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					continue;
+				const float *before[3], *after[3];
+				for (int corner = 0; corner < 3; corner++)
+				{
+					before[corner] = position(triangle[corner]);
+					after[corner] = triangle[corner] == collapse.from ? position(collapse.to) : before[corner];
+				}
+				double normalBefore[3], normalAfter[3];
+				cross(before[0], before[1], before[2], normalBefore);
+				cross(after[0], after[1], after[2], normalAfter);
+				flips = dot(normalBefore, normalAfter) <= MAX_TURN_COSINE * std::sqrt(dot(normalBefore, normalBefore) * dot(normalAfter, normalAfter));
+			}
+			if (flips)
+				continue;
+
+			// nothing sharing a triangle with it changes again this pass, so every check above holds
+			for (uint32_t t = firstTriangle[collapse.from]; t < firstTriangle[collapse.from + 1]; t++)
+				for (int corner = 0; corner < 3; corner++)
+					touched[result[triangles[t] * 3 + corner]] = true;
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+			error = std::max(error, (float)(std::sqrt(collapse.error) / radius));
+			applied++;
+		}
+		if (applied == 0)
+			break;
+
+		// move the collapsed vertices and drop the triangles that have become lines
+		size_t kept = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint16_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+			result[kept++] = a;
+			result[kept++] = b;
+			result[kept++] = c;
+		}
+		result.resize(kept);
+	}
+	return result;
+}
+// end::simplifyMesh[]
+
+// tag::simplifyLods[]
+std::vector<std::vector<uint16_t>> simplifyLods(const std::vector<uint16_t> &indices, const float *positions,
+                                                size_t vertexCount, size_t stride, int maxLods, float maxError,
+                                                std::vector<float> &errors)
+{
+	std::vector<std::vector<uint16_t>> levels(1, indices);
+	errors.assign(1, 0.0f);
+	while ((int)levels.size() < maxLods)
+	{
+		size_t target = (indices.size() >> levels.size()) / 3 * 3;
+		float error;
+		std::vector<uint16_t> simplified = simplifyMesh(indices, positions, vertexCount, stride, target, maxError, error);
+		if (simplified.empty() || simplified.size() > levels.back().size() * 4 / 5)
+			break;
+		levels.push_back(simplified);
+		errors.push_back(error);
+	}
+	return levels;
+}
+// end::simplifyLods[]
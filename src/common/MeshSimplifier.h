@@ -0,0 +1,34 @@
+#pragma once
+
+// Fewer triangles for the same shape, for levels of detail. Edges are collapsed cheapest first,
+// costed with quadric error metrics (Garland and Heckbert 1997): every vertex carries the planes
+// of the triangles around it, and moving it costs the sum of squared distances from its new place
+// to them. A vertex only ever moves onto one of its neighbours, so the simplified mesh is just
+// new indices into the same vertices - every level of detail can share one vertex buffer.
+//
+// Vertices on an edge only one triangle uses - the border of an open mesh, or a seam where the
+// model's colour or texture coordinates change and the vertices are split - never move, so seams
+// stay where they are and borders don't shrink. Collapses that would turn a triangle over are
+// skipped.
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// half the diagonal of the box round the vertices - the size simplification errors are relative to
+float meshRadius(const float *positions, size_t vertexCount, size_t stride);
+
+// simplify the triangles in indices towards targetIndexCount indices, without moving the surface
+// more than about targetError times meshRadius. positions are x, y, z floats at the start of each
+// vertex, stride bytes apart. Returns the new indices, and the error reached, relative to
+// meshRadius, in error
+std::vector<uint16_t> simplifyMesh(const std::vector<uint16_t> &indices, const float *positions, size_t vertexCount,
+                                   size_t stride, size_t targetIndexCount, float targetError, float &error);
+
+// levels of detail for a mesh: the full one first, then each simplified from it (so errors don't
+// pile up) towards half the triangles of the one before, up to maxLods in all. Stops early once a
+// level wouldn't be at least a fifth smaller than the last - a mesh of nothing but seams doesn't
+// simplify at all. errors gets each level's error relative to meshRadius, 0 for the first
+std::vector<std::vector<uint16_t>> simplifyLods(const std::vector<uint16_t> &indices, const float *positions,
+                                                size_t vertexCount, size_t stride, int maxLods, float maxError,
+                                                std::vector<float> &errors);
@@ -0,0 +1,318 @@
+#include "OutcomeEstimator.h"
+
+#include <algorithm>
+
+using namespace std::chrono;
+
+// rollouts each worker keeps in flight; finished ones are replaced straight away, so a batch
+// call covers this many matches for as long as there is budget left
+const int ROLLOUTS_IN_FLIGHT = 16;
+
+// ticks between looks at the clock
+const int CLOCK_CHECK_TICKS = 32;
+
+// a lapse lasts this many ticks plus up to as many again
+const int LAPSE_TICKS = FIXED_TICK_RATE / 4;
+
+OutcomeEstimator::OutcomeEstimator(const OutcomeConfig &config)
+	: config(config), pool(config.threads), streamSeeds(config.seed)
+{
+	player1 = config.player1;
+	player2 = config.player2;
+	if (!player1 || !player2)
+	{
+		std::string error;
+		defaultController = createController("predictive", error);
+		if (!player1)
+			player1 = defaultController.get();
+		if (!player2)
+			player2 = defaultController.get();
+	}
+
+	lapseChance[0] = config.player1LapsesPerSecond / FIXED_TICK_RATE;
+	lapseChance[1] = config.player2LapsesPerSecond / FIXED_TICK_RATE;
+
+	// everything a worker needs is allocated here, so an estimate doesn't allocate
+	workerRollouts.resize(pool.size());
+	for (Rollouts &rollouts : workerRollouts)
+	{
+		rollouts.matches.reserve(ROLLOUTS_IN_FLIGHT);
+		rollouts.randoms.reserve(ROLLOUTS_IN_FLIGHT);
+		rollouts.directions1.reserve(ROLLOUTS_IN_FLIGHT);
+		rollouts.directions2.reserve(ROLLOUTS_IN_FLIGHT);
+		rollouts.rollouts.reserve(ROLLOUTS_IN_FLIGHT);
+	}
+	tallies.resize(pool.size());
+}
+
+// tag::applyLapse[]
+// the direction a player actually moves: the controller's, unless they are in or start a lapse
+static int applyLapse(int direction, int &lapseTicks, int &lapseDirection, float lapseChance, Random &random)
+{
+	if (lapseTicks > 0)
+	{
+		lapseTicks--;
+		return lapseDirection;
+	}
+	if (random.uniform() < lapseChance)
+	{
+		lapseTicks = LAPSE_TICKS + (int)random.below(2 * LAPSE_TICKS);
+		lapseDirection = random.direction();
+		return lapseDirection;
+	}
+	return direction;
+}
+// end::applyLapse[]
+
+// tag::runWorker[]
+void OutcomeEstimator::runWorker(int worker, const FixedMatchState &start, uint64_t streamSeed, int rolloutLimit,
+                                 steady_clock::time_point deadline, Tally &tally)
+{
+	Rollouts &inFlight = workerRollouts[worker];
+	inFlight.matches.clear();
+	inFlight.randoms.clear();
+	inFlight.directions1.clear();
+	inFlight.directions2.clear();
+	inFlight.rollouts.clear();
+	tally = Tally();
+
+	// this worker's own stream, which every rollout it starts takes its seed from
+	Random stream(streamSeed);
+	int started = 0;
+
+	auto startRollout = [&](int i) {
+		Rollout rollout;
+		Random random(stream.next());
+		if (i == (int)inFlight.matches.size())
+		{
+			inFlight.matches.push_back(start);
+			inFlight.randoms.push_back(random);
+			inFlight.directions1.push_back(0);
+			inFlight.directions2.push_back(0);
+			inFlight.rollouts.push_back(rollout);
+		}
+		else
+		{
+			inFlight.matches[i] = start;
+			inFlight.randoms[i] = random;
+			inFlight.rollouts[i] = rollout;
+		}
+		started++;
+	};
+
+	// the last rollout takes the place of one that's finished
+	auto removeRollout = [&](int i) {
+		int last = (int)inFlight.matches.size() - 1;
+		inFlight.matches[i] = inFlight.matches[last];
+		inFlight.randoms[i] = inFlight.randoms[last];
+		inFlight.directions1[i] = inFlight.directions1[last];
+		inFlight.directions2[i] = inFlight.directions2[last];
+		inFlight.rollouts[i] = inFlight.rollouts[last];
+		inFlight.matches.pop_back();
+		inFlight.randoms.pop_back();
+		inFlight.directions1.pop_back();
+		inFlight.directions2.pop_back();
+		inFlight.rollouts.pop_back();
+	};
+
+	while (started < std::min(rolloutLimit, ROLLOUTS_IN_FLIGHT))
+		startRollout(started);
+
+	for (int tick = 0; !inFlight.matches.empty(); tick++)
+	{
+		// rollouts still going at the deadline are dropped
+		if (tick % CLOCK_CHECK_TICKS == 0 && steady_clock::now() >= deadline)
+			break;
+
+		int count = (int)inFlight.matches.size();
+		player1->decide(&inFlight.matches[0], count, 1, &inFlight.randoms[0], &inFlight.directions1[0]);
+		player2->decide(&inFlight.matches[0], count, 2, &inFlight.randoms[0], &inFlight.directions2[0]);
+
+		for (int i = 0; i < count;)
+		{
+			FixedMatchState &match = inFlight.matches[i];
+			Random &random = inFlight.randoms[i];
+			Rollout &rollout = inFlight.rollouts[i];
+
+			match.paddle1Direction = applyLapse(inFlight.directions1[i], rollout.lapseTicks[0], rollout.lapseDirection[0],
+			                                    lapseChance[0], random);
+			match.paddle2Direction = applyLapse(inFlight.directions2[i], rollout.lapseTicks[1], rollout.lapseDirection[1],
+			                                    lapseChance[1], random);
+			int scorer = stepMatchFixed(match);
+			rollout.ticks++;
+
+			bool finished = false;
+			if (scorer != 0 || rollout.ticks >= config.maxPointTicks)
+			{
+				double player1Won = scorer == 1 ? 1.0 : (scorer == 2 ? 0.0 : 0.5);
+				if (rollout.livePointWinner == 0)
+				{
+					tally.livePointWins += player1Won;
+					tally.livePoints++;
+					// a drawn point has no winner to condition the next point on
+					finished = scorer == 0;
+					rollout.livePointWinner = scorer;
+					rollout.ticks = 0;
+				}
+				else
+				{
+					tally.nextPointWins[rollout.livePointWinner - 1] += player1Won;
+					tally.nextPoints[rollout.livePointWinner - 1]++;
+					finished = true;
+				}
+			}
+
+			if (finished)
+				tally.rollouts++;
+
+			if (!finished)
+				i++;
+			else if (started < rolloutLimit)
+				startRollout(i++);
+			else
+			{
+				removeRollout(i);
+				count--;
+			}
+		}
+	}
+}
+// end::runWorker[]
+
+// tag::estimate[]
+OutcomeEstimate OutcomeEstimator::estimate(const FixedMatchState &match)
+{
+	steady_clock::time_point startTime = steady_clock::now();
+	OutcomeEstimate result;
+
+	if (match.player1Score >= config.pointsToWin || match.player2Score >= config.pointsToWin)
+	{
+		result.player1WinProbability = match.player1Score > match.player2Score ? 1 : 0;
+		result.expectedPlayer1Score = match.player1Score;
+		result.expectedPlayer2Score = match.player2Score;
+		return result;
+	}
+
+	steady_clock::time_point deadline =
+		startTime + duration_cast<steady_clock::duration>(duration<double, std::milli>(config.budgetMilliseconds));
+	uint64_t estimateSeed = streamSeeds.next();
+
+	pool.parallelFor(pool.size(), [&](int worker, int, int) {
+		int rolloutLimit = (int)((long long)config.maxRollouts * (worker + 1) / pool.size()) -
+		                   (int)((long long)config.maxRollouts * worker / pool.size());
+		runWorker(worker, match, Random(estimateSeed + worker).next(), rolloutLimit, deadline, tallies[worker]);
+	});
+
+	Tally total;
+	for (const Tally &tally : tallies)
+	{
+		total.livePointWins += tally.livePointWins;
+		total.livePoints += tally.livePoints;
+		for (int last = 0; last < 2; last++)
+		{
+			total.nextPointWins[last] += tally.nextPointWins[last];
+			total.nextPoints[last] += tally.nextPoints[last];
+		}
+		total.rollouts += tally.rollouts;
+	}
+
+	// half a win in hand for each side, so a handful of rollouts - or none - lean towards evens
+	// rather than certainty
+	double livePoint = (total.livePointWins + 0.5) / (total.livePoints + 1);
+	double nextPoint[2];
+	for (int last = 0; last < 2; last++)
+		nextPoint[last] = (total.nextPointWins[last] + 0.5) / (total.nextPoints[last] + 1);
+
+	chainPoints(match.player1Score, match.player2Score, config.pointsToWin, livePoint, nextPoint, result);
+	result.rollouts = total.rollouts;
+	result.milliseconds = duration<double, std::milli>(steady_clock::now() - startTime).count();
+	return result;
+}
+// end::estimate[]
+
+// tag::playOut[]
+OutcomeEstimate OutcomeEstimator::playOut(const FixedMatchState &match, int rollouts, uint64_t seed)
+{
+	steady_clock::time_point startTime = steady_clock::now();
+	std::vector<double> player1Won(rollouts), score1(rollouts), score2(rollouts);
+
+	pool.parallelFor(rollouts, [&](int, int begin, int end) {
+		for (int r = begin; r < end; r++)
+		{
+			FixedMatchState rollout = match;
+			Random random(Random(seed + r).next());
+			Rollout state;
+
+			while (rollout.player1Score < config.pointsToWin && rollout.player2Score < config.pointsToWin &&
+			       state.ticks < config.maxPointTicks)
+			{
+				int direction1, direction2;
+				player1->decide(&rollout, 1, 1, &random, &direction1);
+				player2->decide(&rollout, 1, 2, &random, &direction2);
+				rollout.paddle1Direction =
+					applyLapse(direction1, state.lapseTicks[0], state.lapseDirection[0], lapseChance[0], random);
+				rollout.paddle2Direction =
+					applyLapse(direction2, state.lapseTicks[1], state.lapseDirection[1], lapseChance[1], random);
+				state.ticks = stepMatchFixed(rollout) != 0 ? 0 : state.ticks + 1;
+			}
+
+			// a match stuck on a drawn point counts half to each side, as in estimate()
+			player1Won[r] = rollout.player1Score >= config.pointsToWin ? 1.0 :
+			                (rollout.player2Score >= config.pointsToWin ? 0.0 : 0.5);
+			score1[r] = rollout.player1Score;
+			score2[r] = rollout.player2Score;
+		}
+	});
+
+	OutcomeEstimate result;
+	result.player1WinProbability = result.expectedPlayer1Score = result.expectedPlayer2Score = 0;
+	for (int r = 0; r < rollouts; r++)
+	{
+		result.player1WinProbability += player1Won[r] / rollouts;
+		result.expectedPlayer1Score += score1[r] / rollouts;
+		result.expectedPlayer2Score += score2[r] / rollouts;
+	}
+	result.rollouts = rollouts;
+	result.milliseconds = duration<double, std::milli>(steady_clock::now() - startTime).count();
+	return result;
+}
+// end::playOut[]
+
+// tag::chainPoints[]
+void chainPoints(int player1Score, int player2Score, int pointsToWin, double livePoint, const double nextPoint[2],
+                 OutcomeEstimate &estimate)
+{
+	// win probability and expected final scores from every scoreline a:b, after player 1 (last 0)
+	// or player 2 (last 1) won the point before, working back from the end of the match
+	int side = pointsToWin + 1;
+	std::vector<double> win(side * side * 2), score1(side * side * 2), score2(side * side * 2);
+	auto at = [side](int a, int b, int last) { return (a * side + b) * 2 + last; };
+
+	for (int a = pointsToWin; a >= player1Score; a--)
+		for (int b = pointsToWin; b >= player2Score; b--)
+			for (int last = 0; last < 2; last++)
+			{
+				int here = at(a, b, last);
+				if (a == pointsToWin || b == pointsToWin)
+				{
+					win[here] = a == pointsToWin ? 1 : 0;
+					score1[here] = a;
+					score2[here] = b;
+				}
+				else
+				{
+					double p = nextPoint[last];
+					int won = at(a + 1, b, 0), lost = at(a, b + 1, 1);
+					win[here] = p * win[won] + (1 - p) * win[lost];
+					score1[here] = p * score1[won] + (1 - p) * score1[lost];
+					score2[here] = p * score2[won] + (1 - p) * score2[lost];
+				}
+			}
+
+	int won = at(player1Score + 1, player2Score, 0), lost = at(player1Score, player2Score + 1, 1);
+	estimate.player1PointProbability = livePoint;
+	estimate.player1WinProbability = livePoint * win[won] + (1 - livePoint) * win[lost];
+	estimate.expectedPlayer1Score = livePoint * score1[won] + (1 - livePoint) * score1[lost];
+	estimate.expectedPlayer2Score = livePoint * score2[won] + (1 - livePoint) * score2[lost];
+}
+// end::chainPoints[]
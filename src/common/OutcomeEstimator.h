@@ -0,0 +1,133 @@
+#pragma once
+
+// Live win probability for a match in progress, e.g. for a broadcast overlay: fork the current
+// state into many rollouts under the fixed point rules, with the players' lapses sampled in each
+// rollout, and see who comes out ahead - within a latency budget.
+//
+// Playing every rollout to the end of the match takes thousands of ticks, far too many to get
+// thousands of rollouts into a few milliseconds. Rollouts instead play the point in progress
+// and the point after it. Every point after the first starts the same way - ball in the middle,
+// heading towards whoever scored last - so the second point of each rollout samples the chance of
+// winning a point after winning or losing the one before. Those chances and the chance of winning
+// the live point are then chained over the remaining scorelines exactly, giving the match win
+// probability and the expected final score.
+//
+// Chaining points treats every later point as independent of the others, so the players'
+// behaviour mustn't carry from one point to the next: lapses come at random at a fixed rate
+// for each player, rather than some rollouts having a sloppier player throughout.
+//
+// Each worker thread has its own random stream for its rollouts, and stops starting rollouts as
+// the budget runs out; whatever has finished by the deadline is what the answer is made from.
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+#include "FixedSimulation.h"
+#include "Random.h"
+#include "WorkerPool.h"
+#include "Controller.h"
+
+// tag::OutcomeConfig[]
+struct OutcomeConfig
+{
+	const Controller *player1 = nullptr; // how each player is assumed to play; null for predictive
+	const Controller *player2 = nullptr;
+
+	// how often a player lapses - holds a random direction for a quarter to three quarters of a
+	// second, whatever their controller says. Without lapses the predictive player never misses;
+	// with them rollouts differ, and the more often a player lapses the more points they lose
+	float player1LapsesPerSecond = 4.0f;
+	float player2LapsesPerSecond = 4.0f;
+
+	int pointsToWin = 5;
+	int maxPointTicks = 60 * FIXED_TICK_RATE; // a point still going after this long is a draw
+
+	double budgetMilliseconds = 5;  // answer within this long...
+	int maxRollouts = 16384;        // ...or once this many rollouts have finished
+	int threads = 0;                // 0 for one per core
+	uint64_t seed = 1;
+};
+// end::OutcomeConfig[]
+
+// tag::OutcomeEstimate[]
+struct OutcomeEstimate
+{
+	double player1WinProbability = 0.5;
+	double expectedPlayer1Score = 0;   // final scores, including the points already won
+	double expectedPlayer2Score = 0;
+
+	double player1PointProbability = 0.5; // player 1 winning the point in progress
+
+	int rollouts = 0;            // rollouts that finished in the budget
+	double milliseconds = 0;     // how long the estimate took
+};
+// end::OutcomeEstimate[]
+
+// tag::OutcomeEstimator[]
+class OutcomeEstimator
+{
+public:
+	explicit OutcomeEstimator(const OutcomeConfig &config);
+
+	const OutcomeConfig &getConfig() const { return config; }
+
+	// the outcome of the match from this state; successive calls use fresh random streams
+	OutcomeEstimate estimate(const FixedMatchState &match);
+
+	// player 1's win rate and the mean final scores over this many rollouts played all the way to
+	// the end of the match, with no budget - far too slow to use live, but what estimate() is
+	// approximating, so it can be checked against it
+	OutcomeEstimate playOut(const FixedMatchState &match, int rollouts, uint64_t seed);
+
+private:
+	// what one worker's rollouts found
+	struct Tally
+	{
+		double livePointWins = 0;       // for player 1, a draw counting half
+		int livePoints = 0;
+		double nextPointWins[2] = {};   // for player 1, after player 1 / player 2 won the live point
+		int nextPoints[2] = {};
+		int rollouts = 0;               // finished
+	};
+
+	// per rollout state besides the match and its random stream
+	struct Rollout
+	{
+		int ticks = 0;                  // into the current point
+		int livePointWinner = 0;        // 0 while the live point is being played
+		int lapseTicks[2] = {};         // left of each player's current lapse
+		int lapseDirection[2] = {};
+	};
+
+	// one worker's rollouts in flight, kept contiguous for the controllers' batch calls
+	struct Rollouts
+	{
+		std::vector<FixedMatchState> matches;
+		std::vector<Random> randoms;
+		std::vector<int> directions1;
+		std::vector<int> directions2;
+		std::vector<Rollout> rollouts;
+	};
+
+	void runWorker(int worker, const FixedMatchState &start, uint64_t streamSeed, int rolloutLimit,
+	               std::chrono::steady_clock::time_point deadline, Tally &tally);
+
+	OutcomeConfig config;
+	std::unique_ptr<Controller> defaultController;
+	const Controller *player1;
+	const Controller *player2;
+	float lapseChance[2];            // per tick
+	WorkerPool pool;
+	std::vector<Rollouts> workerRollouts;
+	std::vector<Tally> tallies;
+	Random streamSeeds;             // a seed per estimate for the workers' streams
+};
+// end::OutcomeEstimator[]
+
+// player 1's chance of winning the match from player1Score:player2Score and the expected final
+// scores, given player 1's chance of winning the point being played (livePoint) and of winning
+// each later point after player 1 (nextPoint[0]) or player 2 (nextPoint[1]) won the one before
+void chainPoints(int player1Score, int player2Score, int pointsToWin, double livePoint, const double nextPoint[2],
+                 OutcomeEstimate &estimate);
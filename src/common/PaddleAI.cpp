@@ -0,0 +1,156 @@
+#include "PaddleAI.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+// the furthest the ball's centre gets from the middle before checkSideBounds bounces it
+const float BALL_X_LIMIT = AREA_WIDTH / 2 - BALL_WIDTH / 2 - WORLD_BOUNDS_WIDTH / 2;
+const Fixed FIXED_BALL_X_LIMIT = FIXED_AREA_WIDTH / 2 - FIXED_BALL_WIDTH / 2 - FIXED_WORLD_BOUNDS_WIDTH / 2;
+
+// don't chase a target closer than this, or the paddle jitters either side of it
+const float AIM_DEAD_ZONE = PADDLE_WIDTH / 8;
+const Fixed FIXED_AIM_DEAD_ZONE = FIXED_PADDLE_WIDTH / 8;
+
+// tag::unfold[]
+// fold a straight-line x back between the walls at +-limit: the arena repeats every 4 * limit,
+// mirrored every other 2 * limit
+static float foldIntoArena(float x, float limit)
+{
+	float period = 4 * limit;
+	float folded = fmodf(x + limit, period);
+	if (folded < 0)
+		folded += period;
+	if (folded > 2 * limit)
+		folded = period - folded;
+	return folded - limit;
+}
+
+static Fixed foldIntoArenaFixed(int64_t x, Fixed limit)
+{
+	int64_t period = 4 * (int64_t)limit.raw;
+	int64_t folded = (x + limit.raw) % period;
+	if (folded < 0)
+		folded += period;
+	if (folded > 2 * (int64_t)limit.raw)
+		folded = period - folded;
+	return Fixed::fromRaw((int32_t)(folded - limit.raw));
+}
+// end::unfold[]
+
+// tag::predictBallX[]
+// the z of the ball's centre when it touches a paddle at paddleZ
+static float contactZ(float paddleZ)
+{
+	float reach = PADDLE_DEPTH / 2 + BALL_WIDTH / 2;
+	return paddleZ > 0 ? paddleZ - reach : paddleZ + reach;
+}
+
+float predictBallX(const MatchState &match, int player)
+{
+	float ownZ = contactZ(player == 1 ? match.paddle1Position.z : match.paddle2Position.z);
+	float otherZ = contactZ(player == 1 ? match.paddle2Position.z : match.paddle1Position.z);
+
+	// how far the ball travels in z before it reaches us, going via the other paddle if it's heading away
+	bool approaching = (ownZ - match.ballPosition.z) * match.ballDirection.z > 0;
+	float travel = approaching ? fabsf(ownZ - match.ballPosition.z)
+	                           : fabsf(otherZ - match.ballPosition.z) + fabsf(ownZ - otherZ);
+
+	float sideways = match.ballDirection.x < 0 ? -travel : travel;
+	return foldIntoArena(match.ballPosition.x + sideways, BALL_X_LIMIT);
+}
+
+static Fixed contactZFixed(Fixed paddleZ)
+{
+	Fixed reach = FIXED_PADDLE_DEPTH / 2 + FIXED_BALL_WIDTH / 2;
+	return paddleZ > Fixed::fromInt(0) ? paddleZ - reach : paddleZ + reach;
+}
+
+Fixed predictBallXFixed(const FixedMatchState &match, int player)
+{
+	Fixed ownZ = contactZFixed(player == 1 ? match.paddle1Z : match.paddle2Z);
+	Fixed otherZ = contactZFixed(player == 1 ? match.paddle2Z : match.paddle1Z);
+
+	bool approaching = (ownZ > match.ballZ) == (match.ballDirectionZ > 0);
+	int64_t travel = approaching ? llabs((int64_t)ownZ.raw - match.ballZ.raw)
+	                             : llabs((int64_t)otherZ.raw - match.ballZ.raw) + llabs((int64_t)ownZ.raw - otherZ.raw);
+
+	return foldIntoArenaFixed((int64_t)match.ballX.raw + match.ballDirectionX * travel, FIXED_BALL_X_LIMIT);
+}
+// end::predictBallX[]
+
+// tag::predictBallPath[]
+int predictBallPath(const MatchState &match, glm::vec3 *points, int maxPoints)
+{
+	if (maxPoints <= 0)
+		return 0;
+
+	float x = match.ballPosition.x;
+	float z = match.ballPosition.z;
+	float directionX = match.ballDirection.x < 0 ? -1.0f : 1.0f;
+	float directionZ = match.ballDirection.z < 0 ? -1.0f : 1.0f;
+
+	// the paddle ahead of the ball, or the line it scores at if there isn't one
+	float targetZ = directionZ * (AREA_DEPTH / 2 - WORLD_BOUNDS_WIDTH / 2 - BALL_WIDTH / 2);
+	const float PADDLE_ZS[] = { match.paddle1Position.z, match.paddle2Position.z };
+	for (float paddleZ : PADDLE_ZS)
+	{
+		float contact = contactZ(paddleZ);
+		if ((contact - z) * directionZ > 0 && fabsf(contact - z) < fabsf(targetZ - z))
+			targetZ = contact;
+	}
+
+	int count = 0;
+	points[count++] = glm::vec3(x, match.ballPosition.y, z);
+
+	// x and z change at the same rate, so each leg is as long in z as the distance to the next wall in x
+	float remaining = fabsf(targetZ - z);
+	while (remaining > 0 && count < maxPoints)
+	{
+		float toWall = directionX > 0 ? BALL_X_LIMIT - x : x + BALL_X_LIMIT;
+		float leg = std::max(0.0f, std::min(toWall, remaining));
+		x += directionX * leg;
+		z += directionZ * leg;
+		remaining -= leg;
+		if (leg > 0)
+			points[count++] = glm::vec3(x, match.ballPosition.y, z);
+		if (leg == toWall || toWall <= 0)
+			directionX = -directionX;
+	}
+	return count;
+}
+// end::predictBallPath[]
+
+// tag::predictiveDirection[]
+int predictiveDirection(const MatchState &match, int player)
+{
+	float paddleX = player == 1 ? match.paddle1Position.x : match.paddle2Position.x;
+	float target = predictBallX(match, player);
+	if (target < paddleX - AIM_DEAD_ZONE)
+		return -1;
+	if (target > paddleX + AIM_DEAD_ZONE)
+		return 1;
+	return 0;
+}
+
+int predictiveDirectionFixed(const FixedMatchState &match, int player)
+{
+	Fixed paddleX = player == 1 ? match.paddle1X : match.paddle2X;
+	Fixed target = predictBallXFixed(match, player);
+	if (target < paddleX - FIXED_AIM_DEAD_ZONE)
+		return -1;
+	if (target > paddleX + FIXED_AIM_DEAD_ZONE)
+		return 1;
+	return 0;
+}
+// end::predictiveDirection[]
+
+int followBallDirection(float paddleX, float ballX)
+{
+	const float DEAD_ZONE = PADDLE_WIDTH / 4;
+	if (ballX < paddleX - DEAD_ZONE)
+		return -1;
+	if (ballX > paddleX + DEAD_ZONE)
+		return 1;
+	return 0;
+}
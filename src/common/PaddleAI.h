@@ -0,0 +1,31 @@
+#pragma once
+
+// Computer players: something to set paddleNDirection each tick instead of a keyboard.
+//
+// The predictive player works out where the ball will be when it reaches its paddle without
+// stepping the simulation. The ball always moves diagonally at the same speed in x and z, so the
+// distance it travels sideways equals the distance it travels forwards, and bounces off the
+// side walls can be undone by "unfolding" - carry on in a straight line, then fold the result
+// back into the arena. That makes a decision O(1), whatever the distance or number of bounces.
+
+#include "Simulation.h"
+#include "FixedSimulation.h"
+
+// tag::PaddleAI[]
+// the x the ball's centre will have when it next reaches player's (1 or 2) paddle, assuming the
+// other paddle returns it if it's going the other way
+float predictBallX(const MatchState &match, int player);
+Fixed predictBallXFixed(const FixedMatchState &match, int player);
+
+// the ball's path until it next reaches a paddle (or, if it's already past one, the end of the
+// arena): its position now, every wall bounce on the way, and where it arrives - the same
+// geometry predictBallX unfolds, laid out for drawing. Writes at most maxPoints, returns how many
+int predictBallPath(const MatchState &match, glm::vec3 *points, int maxPoints);
+
+// -1, 0 or 1 to move player's paddle towards where the ball will arrive
+int predictiveDirection(const MatchState &match, int player);
+int predictiveDirectionFixed(const FixedMatchState &match, int player);
+
+// the simple bot the server has always used: follow the ball's current x
+int followBallDirection(float paddleX, float ballX);
+// end::PaddleAI[]
@@ -0,0 +1,46 @@
+#ifndef PONG_PLUGIN_H
+#define PONG_PLUGIN_H
+
+/* The C interface for paddle controller plugins: shared libraries loaded with dlopen by
+ * "plugin:<path>" controllers (Controller.h). It's plain C with fixed-size fields so a plugin can
+ * be written in anything that produces a C shared library, and doesn't need this repo's code.
+ *
+ * A plugin exports:
+ *   int pong_plugin_abi_version(void);   returns PONG_PLUGIN_ABI_VERSION
+ *   const char *pong_plugin_name(void);  a short name for results tables
+ *   void pong_decide(const PongState *states, int n, float *out);
+ *
+ * pong_decide is called once per tick for a whole batch of matches - every match a controller is
+ * playing on one thread - rather than once per paddle, so the cost of calling through a function
+ * pointer into another library is paid once per batch. out[i] is the direction for
+ * states[i].player's paddle: below -0.5 is left, above 0.5 is right, anything else stays still.
+ * It may be called from several threads at once, with different states.
+ */
+
+#include <stdint.h>
+
+#define PONG_PLUGIN_ABI_VERSION 2
+
+/* positions are Q16.16 fixed point metres (divide by 65536.0), as in FixedSimulation.h */
+typedef struct PongState
+{
+	int32_t player;          /* the paddle to decide for, 1 (at +z) or 2 (at -z) */
+	int32_t paddle1X;
+	int32_t paddle2X;
+	int32_t paddle1Z;
+	int32_t paddle2Z;
+	int32_t ballX;
+	int32_t ballZ;
+	int32_t ballDirectionX;  /* -1 or 1 */
+	int32_t ballDirectionZ;
+	int32_t paddle1Direction;
+	int32_t paddle2Direction;
+	int32_t player1Score;
+	int32_t player2Score;
+} PongState;
+
+typedef int (*PongPluginAbiVersionFunction)(void);
+typedef const char *(*PongPluginNameFunction)(void);
+typedef void (*PongDecideFunction)(const PongState *states, int n, float *out);
+
+#endif
@@ -0,0 +1,144 @@
+#pragma once
+
+// Messages exchanged between PongServer and its clients over TCP.
+// Every message has a fixed size for its type and all fields are little-endian,
+// so a reader only has to look at the first byte to know how much to wait for.
+
+#include <cstdint>
+#include <cstring>
+
+#include "Simulation.h"
+
+const unsigned short DEFAULT_SERVER_PORT = 27015;
+
+enum MessageType : uint8_t
+{
+	MSG_INPUT = 1,       // client -> server, the paddle direction the player is holding
+	MSG_MATCH_START = 2, // server -> client, which paddle the player controls
+	MSG_STATE = 3,       // server -> client, the match state after a tick
+	MSG_SPECTATE = 4,    // spectator -> server, the match to watch
+	MSG_KEYFRAME = 5,    // server -> spectator, the full match state (see Snapshot.h)
+	MSG_DELTA = 6,       // server -> spectator, movement since the previous tick (see Snapshot.h)
+};
+
+const int INPUT_MESSAGE_SIZE = 8;        // type, direction, 2 padding, uint32 tick
+const int MATCH_START_MESSAGE_SIZE = 4;  // type, player index, 2 padding
+const int STATE_MESSAGE_SIZE = 28;       // type, 3 padding, uint32 tick, 4 floats, 2 int16 scores
+const int SPECTATE_MESSAGE_SIZE = 8;     // type, 3 padding, uint32 match id
+const int KEYFRAME_MESSAGE_SIZE = 36;    // type, 3 padding, uint32 tick, 6 floats, 2 int16 scores
+const int DELTA_MESSAGE_SIZE = 16;       // type, 3 padding, uint32 tick, 4 int16 deltas
+
+// size of a message given its type byte, or 0 if the type is unknown
+inline int messageSize(uint8_t type)
+{
+	switch (type)
+	{
+	case MSG_INPUT: return INPUT_MESSAGE_SIZE;
+	case MSG_MATCH_START: return MATCH_START_MESSAGE_SIZE;
+	case MSG_STATE: return STATE_MESSAGE_SIZE;
+	case MSG_SPECTATE: return SPECTATE_MESSAGE_SIZE;
+	case MSG_KEYFRAME: return KEYFRAME_MESSAGE_SIZE;
+	case MSG_DELTA: return DELTA_MESSAGE_SIZE;
+	default: return 0;
+	}
+}
+
+// tag::littleEndian[]
+inline void putU16(uint8_t *out, uint16_t value)
+{
+	out[0] = (uint8_t)value;
+	out[1] = (uint8_t)(value >> 8);
+}
+
+inline void putU32(uint8_t *out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		out[i] = (uint8_t)(value >> (8 * i));
+}
+
+inline void putF32(uint8_t *out, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	putU32(out, bits);
+}
+
+inline uint16_t getU16(const uint8_t *in)
+{
+	return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+inline uint32_t getU32(const uint8_t *in)
+{
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+inline float getF32(const uint8_t *in)
+{
+	uint32_t bits = getU32(in);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+// end::littleEndian[]
+
+// tag::encodeMessages[]
+inline void encodeInput(uint8_t *out, int direction, uint32_t tick)
+{
+	out[0] = MSG_INPUT;
+	out[1] = (uint8_t)(int8_t)(direction < 0 ? -1 : (direction > 0 ? 1 : 0));
+	out[2] = out[3] = 0;
+	putU32(out + 4, tick);
+}
+
+inline int decodeInputDirection(const uint8_t *in)
+{
+	return (int8_t)in[1];
+}
+
+inline void encodeMatchStart(uint8_t *out, int playerIndex)
+{
+	out[0] = MSG_MATCH_START;
+	out[1] = (uint8_t)playerIndex;
+	out[2] = out[3] = 0;
+}
+
+// the state is the same for both players, so it is encoded once per match per tick
+inline void encodeState(uint8_t *out, const MatchState &match, uint32_t tick)
+{
+	out[0] = MSG_STATE;
+	out[1] = out[2] = out[3] = 0;
+	putU32(out + 4, tick);
+	putF32(out + 8, match.paddle1Position.x);
+	putF32(out + 12, match.paddle2Position.x);
+	putF32(out + 16, match.ballPosition.x);
+	putF32(out + 20, match.ballPosition.z);
+	putU16(out + 24, (uint16_t)match.player1Score);
+	putU16(out + 26, (uint16_t)match.player2Score);
+}
+
+// match ids are global across the server: the shard in the top bits, the match in that shard below
+inline uint32_t makeMatchId(int shard, int match)
+{
+	return ((uint32_t)shard << 20) | (uint32_t)match;
+}
+
+inline void encodeSpectate(uint8_t *out, uint32_t matchId)
+{
+	out[0] = MSG_SPECTATE;
+	out[1] = out[2] = out[3] = 0;
+	putU32(out + 4, matchId);
+}
+
+// fills in the parts of match carried by a state message, returns the tick
+inline uint32_t decodeState(const uint8_t *in, MatchState &match)
+{
+	match.paddle1Position.x = getF32(in + 8);
+	match.paddle2Position.x = getF32(in + 12);
+	match.ballPosition.x = getF32(in + 16);
+	match.ballPosition.z = getF32(in + 20);
+	match.player1Score = getU16(in + 24);
+	match.player2Score = getU16(in + 26);
+	return getU32(in + 4);
+}
+// end::encodeMessages[]
@@ -0,0 +1,35 @@
+#pragma once
+
+// Small, fast random numbers that come out the same on every platform (unlike std::rand or the
+// std:: distributions), so a seed always reproduces the same inputs and matches.
+
+#include <cstdint>
+
+// tag::Random[]
+// SplitMix64 - one 64 bit state word, good enough statistically for game inputs and rollouts
+class Random
+{
+public:
+	explicit Random(uint64_t seed = 0) : state(seed) {}
+
+	uint64_t next()
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	// uniform in [0, bound)
+	uint32_t below(uint32_t bound) { return (uint32_t)(((next() >> 32) * bound) >> 32); }
+
+	// uniform in [0, 1)
+	float uniform() { return (next() >> 40) * (1.0f / 16777216.0f); }
+
+	// -1, 0 or 1
+	int direction() { return (int)below(3) - 1; }
+
+private:
+	uint64_t state;
+};
+// end::Random[]
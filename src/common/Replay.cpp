@@ -0,0 +1,152 @@
+#include "Replay.h"
+
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+
+#include "Random.h"
+#include "StateHash.h"
+#include "Protocol.h"
+
+static const char REPLAY_MAGIC[8] = { 'P', 'O', 'N', 'G', 'R', 'P', 'L', '1' };
+
+std::vector<TickInput> makeInputStream(uint64_t seed, int ticks)
+{
+	Random random(seed);
+	std::vector<TickInput> inputs(ticks);
+	TickInput held = { 0, 0 };
+	int holdPaddle1 = 0;
+	int holdPaddle2 = 0;
+
+	for (int i = 0; i < ticks; i++)
+	{
+		if (holdPaddle1-- <= 0)
+		{
+			held.paddle1 = (int8_t)random.direction();
+			holdPaddle1 = 1 + random.below(60);
+		}
+		if (holdPaddle2-- <= 0)
+		{
+			held.paddle2 = (int8_t)random.direction();
+			holdPaddle2 = 1 + random.below(60);
+		}
+		inputs[i] = held;
+	}
+	return inputs;
+}
+
+// tag::findFirstDivergence[]
+int64_t findFirstDivergence(const HashLog &a, const HashLog &b)
+{
+	uint32_t from = std::max(a.firstTick(), b.firstTick());
+	uint32_t to = std::min(a.endTick(), b.endTick());
+	for (uint32_t tick = from; tick < to; tick++)
+		if (a.at(tick) != b.at(tick))
+			return tick;
+	return -1;
+}
+// end::findFirstDivergence[]
+
+// tag::stepAndRecord[]
+void stepAndRecord(Replay &replay, FixedMatchState &match, TickInput input)
+{
+	if (replay.inputs.empty())
+	{
+		replay.start = match;
+		replay.hashes.clear(0);
+	}
+
+	match.paddle1Direction = input.paddle1;
+	match.paddle2Direction = input.paddle2;
+	stepMatchFixed(match);
+
+	replay.inputs.push_back(input);
+	replay.hashes.record(hashMatchState(match));
+}
+// end::stepAndRecord[]
+
+// tag::verifyReplay[]
+int64_t verifyReplay(const Replay &replay, HashLog &resimulated, FixedMatchState &end)
+{
+	end = replay.start;
+	resimulated.clear(0);
+	resimulated.data().reserve(replay.inputs.size());
+
+	for (const TickInput &input : replay.inputs)
+	{
+		end.paddle1Direction = input.paddle1;
+		end.paddle2Direction = input.paddle2;
+		stepMatchFixed(end);
+		resimulated.record(hashMatchState(end));
+	}
+
+	return findFirstDivergence(replay.hashes, resimulated);
+}
+// end::verifyReplay[]
+
+// tag::saveReplay[]
+bool saveReplay(const char *path, const Replay &replay)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	uint32_t ticks = (uint32_t)replay.inputs.size();
+	std::vector<uint8_t> bytes(sizeof(REPLAY_MAGIC) + 4 + CANONICAL_STATE_SIZE + ticks * 6);
+	uint8_t *out = &bytes[0];
+
+	memcpy(out, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+	out += sizeof(REPLAY_MAGIC);
+	putU32(out, ticks);
+	out += 4;
+	canonicalState(replay.start, out);
+	out += CANONICAL_STATE_SIZE;
+	for (const TickInput &input : replay.inputs)
+	{
+		*out++ = (uint8_t)input.paddle1;
+		*out++ = (uint8_t)input.paddle2;
+	}
+	for (uint32_t tick = 0; tick < ticks; tick++, out += 4)
+		putU32(out, replay.hashes.has(tick) ? replay.hashes.at(tick) : 0);
+
+	file.write((const char *)&bytes[0], bytes.size());
+	return (bool)file;
+}
+// end::saveReplay[]
+
+// tag::loadReplay[]
+bool loadReplay(const char *path, Replay &replay)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	const size_t HEADER_SIZE = sizeof(REPLAY_MAGIC) + 4 + CANONICAL_STATE_SIZE;
+	if (bytes.size() < HEADER_SIZE || memcmp(&bytes[0], REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0)
+		return false;
+
+	const uint8_t *in = &bytes[sizeof(REPLAY_MAGIC)];
+	uint32_t ticks = getU32(in);
+	if (bytes.size() != HEADER_SIZE + (size_t)ticks * 6)
+		return false;
+	in += 4;
+
+	readCanonicalState(in, replay.start);
+	in += CANONICAL_STATE_SIZE;
+
+	replay.inputs.resize(ticks);
+	for (TickInput &input : replay.inputs)
+	{
+		input.paddle1 = (int8_t)*in++;
+		input.paddle2 = (int8_t)*in++;
+	}
+	replay.hashes.clear(0);
+	replay.hashes.data().resize(ticks);
+	for (uint32_t &hash : replay.hashes.data())
+	{
+		hash = getU32(in);
+		in += 4;
+	}
+	return true;
+}
+// end::loadReplay[]
@@ -0,0 +1,71 @@
+#pragma once
+
+// Recording a fixed point match as its inputs plus a hash of the state after every tick, and
+// finding the first tick where two runs of a match stop agreeing.
+//
+// Only the low 32 bits of each hash are kept, so a tick costs 6 bytes (2 of input, 4 of hash)
+// and an hour at FIXED_TICK_RATE is under 3MB. A desync shows up in the hash on the tick it
+// happens, so comparing two logs pinpoints it rather than noticing a point later.
+
+#include <cstdint>
+#include <vector>
+
+#include "FixedSimulation.h"
+
+struct TickInput
+{
+	int8_t paddle1;
+	int8_t paddle2;
+};
+
+// players hold a direction for a random number of ticks, like someone on a keyboard
+std::vector<TickInput> makeInputStream(uint64_t seed, int ticks);
+
+// tag::HashLog[]
+// state hashes of consecutive ticks, starting at firstTick
+class HashLog
+{
+public:
+	explicit HashLog(uint32_t firstTick = 0) : first(firstTick) {}
+
+	void record(uint64_t hash) { hashes.push_back((uint32_t)hash); }
+
+	uint32_t firstTick() const { return first; }
+	uint32_t endTick() const { return first + (uint32_t)hashes.size(); }
+	bool has(uint32_t tick) const { return tick >= first && tick < endTick(); }
+	uint32_t at(uint32_t tick) const { return hashes[tick - first]; }
+
+	void clear(uint32_t firstTick) { first = firstTick; hashes.clear(); }
+
+	// the raw hashes, for writing out or sending to a peer
+	const std::vector<uint32_t> &data() const { return hashes; }
+	std::vector<uint32_t> &data() { return hashes; }
+
+private:
+	uint32_t first;
+	std::vector<uint32_t> hashes;
+};
+
+// the first tick both logs cover where the hashes differ, or -1 if every shared tick agrees
+int64_t findFirstDivergence(const HashLog &a, const HashLog &b);
+// end::HashLog[]
+
+// tag::Replay[]
+struct Replay
+{
+	FixedMatchState start;
+	std::vector<TickInput> inputs; // inputs[i] is applied on tick i
+	HashLog hashes;                // the state hash after tick i
+};
+
+// apply input to match for one tick, and record both in replay
+void stepAndRecord(Replay &replay, FixedMatchState &match, TickInput input);
+
+// run the replay's inputs from its start state, hashing every tick into resimulated; returns the
+// first tick whose hash differs from the recorded one, or -1 if the whole replay reproduces
+int64_t verifyReplay(const Replay &replay, HashLog &resimulated, FixedMatchState &end);
+
+// little-endian binary file: "PONGRPL1", tick count, canonical start state, inputs, hashes
+bool saveReplay(const char *path, const Replay &replay);
+bool loadReplay(const char *path, Replay &replay);
+// end::Replay[]
@@ -0,0 +1,54 @@
+#include "ResolutionController.h"
+
+#include <algorithm>
+#include <cmath>
+
+// changes smaller than this aren't worth the settling time they cost
+const float MIN_CHANGE = 0.01f;
+
+ResolutionController::ResolutionController(const ResolutionConfig &config, float startScale)
+	: config(config)
+{
+	currentScale = std::min(config.maxScale, std::max(config.minScale, startScale));
+	stats.lowestScale = stats.highestScale = currentScale;
+}
+
+// tag::updateResolution[]
+float ResolutionController::update(double milliseconds)
+{
+	stats.measurements++;
+	stats.lastMilliseconds = milliseconds;
+	if (milliseconds > config.budgetMilliseconds)
+		stats.overBudget++;
+
+	if (settling > 0)
+	{
+		settling--;
+		return currentScale;
+	}
+	average = averaged == 0 ? milliseconds : average + config.smoothing * (milliseconds - average);
+	stats.averageMilliseconds = average;
+	if (++averaged < config.settleFrames)
+		return currentScale;
+
+	// inside the band, hold
+	double low = config.budgetMilliseconds * config.lowFraction;
+	if (average <= config.budgetMilliseconds && (average >= low || currentScale >= config.maxScale))
+		return currentScale;
+
+	double target = (config.budgetMilliseconds + low) / 2;
+	float wanted = currentScale * (float)std::sqrt(target / std::max(average, 1e-3));
+	wanted = std::min(currentScale + config.maxStep, std::max(currentScale - config.maxStep, wanted));
+	wanted = std::min(config.maxScale, std::max(config.minScale, wanted));
+	if (std::fabs(wanted - currentScale) < MIN_CHANGE)
+		return currentScale;
+
+	currentScale = wanted;
+	stats.changes++;
+	stats.lowestScale = std::min(stats.lowestScale, currentScale);
+	stats.highestScale = std::max(stats.highestScale, currentScale);
+	settling = config.settleFrames;
+	averaged = 0;
+	return currentScale;
+}
+// end::updateResolution[]
@@ -0,0 +1,66 @@
+#pragma once
+
+// Dynamic resolution: picks the scale the scene is drawn at, each frame, from how long it has
+// been taking to render, so a machine too slow for the full resolution holds a frame time budget
+// by drawing fewer pixels instead of dropping frames.
+//
+// Render time is taken to grow with the number of pixels, the square of the scale, so a change
+// aims straight for the middle of a band below the budget: scale * sqrt(target / measured). Any
+// cost that doesn't scale with the pixels makes that fall a little short, never overshoot, so
+// the scale approaches the band from one side instead of bouncing around it. Inside the band the
+// scale holds - that band is the hysteresis that keeps noise from moving it every frame.
+//
+// Measurements lag the scale: GPU timings arrive a few frames after the frame they time. After
+// each change the next settleFrames measurements are thrown away as still showing the old
+// scale, and the following settleFrames are averaged before deciding again.
+
+// tag::ResolutionConfig[]
+struct ResolutionConfig
+{
+	double budgetMilliseconds = 8;  // the most the scene should take to render
+	float lowFraction = 0.7f;       // the scale only goes up once render time is under this share of the budget
+	float minScale = 0.25f;
+	float maxScale = 1.0f;
+	float maxStep = 0.15f;          // the most one change moves the scale by
+	int settleFrames = 4;           // measurements ignored after a change, then averaged before the next
+	float smoothing = 0.25f;        // weight of each new measurement in the running average
+};
+// end::ResolutionConfig[]
+
+// tag::ResolutionStats[]
+// for tuning the config: what the controller has seen and done since it was created
+struct ResolutionStats
+{
+	int measurements = 0;
+	int overBudget = 0;             // measurements over the budget
+	int changes = 0;                // of the scale
+	double lastMilliseconds = 0;
+	double averageMilliseconds = 0; // the running average the last decision was made from
+	float lowestScale = 1;
+	float highestScale = 0;
+};
+// end::ResolutionStats[]
+
+// tag::ResolutionController[]
+class ResolutionController
+{
+public:
+	explicit ResolutionController(const ResolutionConfig &config = ResolutionConfig(), float startScale = 1);
+
+	const ResolutionConfig &getConfig() const { return config; }
+	const ResolutionStats &getStats() const { return stats; }
+	float scale() const { return currentScale; }
+
+	// one measurement of how long the scene took at the scale it was drawn at; returns the scale
+	// to draw the next frame at
+	float update(double milliseconds);
+
+private:
+	ResolutionConfig config;
+	ResolutionStats stats;
+	float currentScale;
+	int settling = 0;               // measurements still to ignore
+	int averaged = 0;               // measurements in the running average since then
+	double average = 0;
+};
+// end::ResolutionController[]
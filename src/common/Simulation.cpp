@@ -0,0 +1,100 @@
+#include "Simulation.h"
+
+// tag::checkSideBounds[]
+bool checkSideBounds(float *value, bool leftSide, const float ITEM_WIDTH)
+{
+	if (leftSide)
+	{
+		if (*value < (-AREA_WIDTH / 2) + ITEM_WIDTH / 2 + WORLD_BOUNDS_WIDTH / 2)
+		{
+			*value = ((-AREA_WIDTH / 2) + ITEM_WIDTH / 2 + WORLD_BOUNDS_WIDTH / 2);
+			return true;
+		}
+		else
+			return false;
+	}
+	else {
+		if (*value > (AREA_WIDTH / 2) - ITEM_WIDTH / 2 - WORLD_BOUNDS_WIDTH / 2)
+		{
+			*value = ((AREA_WIDTH / 2) - ITEM_WIDTH / 2 - WORLD_BOUNDS_WIDTH / 2);
+			return true;
+		}
+		else
+			return false;
+	}
+}
+// end::checkSideBounds[]
+
+// tag::checkBallPaddleCollision[]
+bool checkBallPaddleCollision(const MatchState &match, const glm::vec3 PADDLE_POSITION)
+{
+	if (PADDLE_POSITION.x - PADDLE_WIDTH / 2 < match.ballPosition.x + BALL_WIDTH / 2 &&
+		PADDLE_POSITION.x + PADDLE_WIDTH / 2 > match.ballPosition.x - BALL_WIDTH / 2 &&
+		PADDLE_POSITION.z - PADDLE_DEPTH / 2 < match.ballPosition.z + BALL_WIDTH / 2 &&
+		PADDLE_POSITION.z + PADDLE_DEPTH / 2 > match.ballPosition.z - BALL_WIDTH / 2)
+	{
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+// end::checkBallPaddleCollision[]
+
+// tag::stepMatch[]
+int stepMatch(MatchState &match, double delta)
+{
+	int scorer = 0;
+
+	// move paddle
+	match.paddle1Position.x += (PADDLE_VELOCITY * delta * match.paddle1Direction);
+
+	// make sure that the paddles can't go out of bounds
+	checkSideBounds(&match.paddle1Position.x, true, PADDLE_WIDTH);
+	checkSideBounds(&match.paddle1Position.x, false, PADDLE_WIDTH);
+
+	match.paddle2Position.x += (PADDLE_VELOCITY * delta * match.paddle2Direction);
+
+	checkSideBounds(&match.paddle2Position.x, true, PADDLE_WIDTH);
+	checkSideBounds(&match.paddle2Position.x, false, PADDLE_WIDTH);
+
+	// move the ball
+	match.ballPosition += match.ballDirection * BALL_VELOCITY * (float)delta;
+
+	// reverse the direction of the ball if it hits the side wall
+	if (checkSideBounds(&match.ballPosition.x, false, BALL_WIDTH) || checkSideBounds(&match.ballPosition.x, true, BALL_WIDTH))
+		match.ballDirection.x = -match.ballDirection.x;
+
+	// check for paddle collisions
+	if (checkBallPaddleCollision(match, match.paddle1Position) || checkBallPaddleCollision(match, match.paddle2Position))
+	{
+		if (!match.isColliding)
+		{
+			match.ballDirection.z = -match.ballDirection.z;
+			match.isColliding = true;
+		}
+	}
+	else {
+		match.isColliding = false;
+	}
+
+	// check if a player has missed
+	if ((AREA_DEPTH / 2 - WORLD_BOUNDS_WIDTH / 2 < match.ballPosition.z + BALL_WIDTH / 2) || (-AREA_DEPTH / 2 + WORLD_BOUNDS_WIDTH / 2 > match.ballPosition.z - BALL_WIDTH / 2))
+	{
+		if (match.ballPosition.z < 0)
+		{
+			match.player1Score++;
+			scorer = 1;
+		}
+		else
+		{
+			match.player2Score++;
+			scorer = 2;
+		}
+		match.ballDirection = -match.ballDirection;
+		match.ballPosition = glm::vec3(0, 0, 0);
+	}
+
+	return scorer;
+}
+// end::stepMatch[]
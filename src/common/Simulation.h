@@ -0,0 +1,47 @@
+#pragma once
+
+// The Pong rules, independent of SDL and OpenGL so that the game, the dedicated
+// server and the other headless tools all simulate matches in exactly the same way.
+
+#define GLM_FORCE_RADIANS // suppress a warning in GLM 0.9.5
+#include <glm/glm.hpp>
+
+// Constant variables - Only used for collision detection
+const float PADDLE_WIDTH = 0.5f;
+const float PADDLE_DEPTH = 0.25f;
+const float AREA_WIDTH = 2.6f; // The play area
+const float AREA_DEPTH = 6.0f;
+const float WORLD_BOUNDS_WIDTH = 0.25f;
+const float BALL_WIDTH = 0.1f;
+
+const float PADDLE_VELOCITY = 1.2f;
+const float BALL_VELOCITY = 1.5f;
+
+// tag::MatchState[]
+// everything needed to simulate one match
+struct MatchState
+{
+	glm::vec3 paddle1Position = glm::vec3(0.0f, 0.0f, 2.0f);
+	glm::vec3 paddle2Position = glm::vec3(0.0f, 0.0f, -2.0f);
+
+	float paddle1Direction = 0.0f; // -1 left, 0 still, 1 right
+	float paddle2Direction = 0.0f;
+
+	glm::vec3 ballPosition = glm::vec3(0, 0, 0);
+	glm::vec3 ballDirection = glm::vec3(1, 0, 1);
+
+	// Scores
+	int player1Score = 0;
+	int player2Score = 0;
+
+	bool isColliding = false; // stops the ball bouncing repeatedly inside a paddle
+};
+// end::MatchState[]
+
+// clamps *value inside the play area, returns true if it had to be moved
+bool checkSideBounds(float *value, bool leftSide, const float ITEM_WIDTH);
+
+bool checkBallPaddleCollision(const MatchState &match, const glm::vec3 PADDLE_POSITION);
+
+// advance the match by delta seconds, returns the player who scored (1 or 2) or 0
+int stepMatch(MatchState &match, double delta);
@@ -0,0 +1,120 @@
+#include "Snapshot.h"
+
+#include <cmath>
+
+static int16_t quantiseDelta(float from, float to, bool &fits)
+{
+	long steps = lroundf((to - from) * DELTA_UNITS_PER_METRE);
+	if (steps < INT16_MIN || steps > INT16_MAX)
+		fits = false;
+	return (int16_t)steps;
+}
+
+SnapshotEncoder::SnapshotEncoder(int keyframeInterval)
+	: keyframeInterval(keyframeInterval)
+{
+}
+
+// tag::encode[]
+SnapshotPtr SnapshotEncoder::encode(const MatchState &match, uint32_t tick)
+{
+	std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+	snapshot->tick = tick;
+
+	bool keyframe = needKeyframe || tick != lastTick + 1 || tick - lastKeyframeTick >= (uint32_t)keyframeInterval ||
+	                match.player1Score != sent.player1Score || match.player2Score != sent.player2Score;
+
+	if (!keyframe)
+	{
+		bool fits = true;
+		int16_t paddle1 = quantiseDelta(sent.paddle1Position.x, match.paddle1Position.x, fits);
+		int16_t paddle2 = quantiseDelta(sent.paddle2Position.x, match.paddle2Position.x, fits);
+		int16_t ballX = quantiseDelta(sent.ballPosition.x, match.ballPosition.x, fits);
+		int16_t ballZ = quantiseDelta(sent.ballPosition.z, match.ballPosition.z, fits);
+
+		if (fits)
+		{
+			snapshot->bytes.resize(DELTA_MESSAGE_SIZE);
+			uint8_t *out = &snapshot->bytes[0];
+			out[0] = MSG_DELTA;
+			out[1] = out[2] = out[3] = 0;
+			putU32(out + 4, tick);
+			putU16(out + 8, (uint16_t)paddle1);
+			putU16(out + 10, (uint16_t)paddle2);
+			putU16(out + 12, (uint16_t)ballX);
+			putU16(out + 14, (uint16_t)ballZ);
+
+			// move on exactly as far as the spectators will
+			sent.paddle1Position.x += paddle1 / DELTA_UNITS_PER_METRE;
+			sent.paddle2Position.x += paddle2 / DELTA_UNITS_PER_METRE;
+			sent.ballPosition.x += ballX / DELTA_UNITS_PER_METRE;
+			sent.ballPosition.z += ballZ / DELTA_UNITS_PER_METRE;
+		}
+		else
+			keyframe = true; // moved too far in one tick to describe as a delta
+	}
+
+	if (keyframe)
+	{
+		snapshot->keyframe = true;
+		snapshot->bytes.resize(KEYFRAME_MESSAGE_SIZE);
+		uint8_t *out = &snapshot->bytes[0];
+		out[0] = MSG_KEYFRAME;
+		out[1] = out[2] = out[3] = 0;
+		putU32(out + 4, tick);
+		putF32(out + 8, match.paddle1Position.x);
+		putF32(out + 12, match.paddle2Position.x);
+		putF32(out + 16, match.ballPosition.x);
+		putF32(out + 20, match.ballPosition.z);
+		putF32(out + 24, match.ballDirection.x);
+		putF32(out + 28, match.ballDirection.z);
+		putU16(out + 32, (uint16_t)match.player1Score);
+		putU16(out + 34, (uint16_t)match.player2Score);
+
+		sent = match;
+		lastKeyframeTick = tick;
+		needKeyframe = false;
+	}
+
+	lastTick = tick;
+	return snapshot;
+}
+// end::encode[]
+
+// tag::apply[]
+bool SnapshotDecoder::apply(const uint8_t *message)
+{
+	uint32_t tick = getU32(message + 4);
+
+	if (message[0] == MSG_KEYFRAME)
+	{
+		match.paddle1Position.x = getF32(message + 8);
+		match.paddle2Position.x = getF32(message + 12);
+		match.ballPosition.x = getF32(message + 16);
+		match.ballPosition.z = getF32(message + 20);
+		match.ballDirection.x = getF32(message + 24);
+		match.ballDirection.z = getF32(message + 28);
+		match.player1Score = getU16(message + 32);
+		match.player2Score = getU16(message + 34);
+		hasKeyframe = true;
+		lastTick = tick;
+		return true;
+	}
+
+	if (message[0] != MSG_DELTA)
+		return false;
+
+	if (!hasKeyframe || tick != lastTick + 1)
+	{
+		hasKeyframe = false; // wait for the next keyframe
+		return false;
+	}
+
+	match.paddle1Position.x += (int16_t)getU16(message + 8) / DELTA_UNITS_PER_METRE;
+	match.paddle2Position.x += (int16_t)getU16(message + 10) / DELTA_UNITS_PER_METRE;
+	match.ballPosition.x += (int16_t)getU16(message + 12) / DELTA_UNITS_PER_METRE;
+	match.ballPosition.z += (int16_t)getU16(message + 14) / DELTA_UNITS_PER_METRE;
+	lastTick = tick;
+	return true;
+}
+// end::apply[]
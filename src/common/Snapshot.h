@@ -0,0 +1,69 @@
+#pragma once
+
+// Spectator snapshots - the match state as seen from no particular camera, encoded once per
+// tick into an immutable buffer that any number of spectator connections can share.
+//
+// A keyframe carries the whole state. In between, a delta carries how far the paddles and
+// ball moved since the previous tick, quantised to 16 bits, so a spectator can only use a delta
+// if it received every snapshot since the last keyframe. Spectators that fall behind drop
+// everything queued and pick the stream up again at the next keyframe.
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Simulation.h"
+#include "Protocol.h"
+
+const float DELTA_UNITS_PER_METRE = 8192.0f; // one delta step is ~0.1mm
+const int DEFAULT_KEYFRAME_INTERVAL = 30;    // ticks between keyframes
+
+// tag::Snapshot[]
+struct Snapshot
+{
+	uint32_t tick = 0;
+	bool keyframe = false;
+	std::vector<uint8_t> bytes; // a complete MSG_KEYFRAME or MSG_DELTA message
+};
+
+// shared between every spectator it is queued for, and never modified once encoded
+typedef std::shared_ptr<const Snapshot> SnapshotPtr;
+// end::Snapshot[]
+
+// tag::SnapshotEncoder[]
+class SnapshotEncoder
+{
+public:
+	explicit SnapshotEncoder(int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+	SnapshotPtr encode(const MatchState &match, uint32_t tick);
+
+	void forceKeyframe() { needKeyframe = true; }
+
+private:
+	int keyframeInterval;
+	bool needKeyframe = true;
+	uint32_t lastKeyframeTick = 0;
+	uint32_t lastTick = 0;
+	MatchState sent; // the state as spectators have reconstructed it, so deltas never drift
+};
+// end::SnapshotEncoder[]
+
+// tag::SnapshotDecoder[]
+class SnapshotDecoder
+{
+public:
+	// applies one MSG_KEYFRAME or MSG_DELTA, returns false if a delta arrived that doesn't
+	// follow on from the previous tick (it is ignored until the next keyframe)
+	bool apply(const uint8_t *message);
+
+	bool synced() const { return hasKeyframe; }
+	uint32_t tick() const { return lastTick; }
+	const MatchState &state() const { return match; }
+
+private:
+	bool hasKeyframe = false;
+	uint32_t lastTick = 0;
+	MatchState match;
+};
+// end::SnapshotDecoder[]
@@ -0,0 +1,168 @@
+#include "StateHash.h"
+
+#include "Protocol.h"
+
+// tag::xxh64[]
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read64(const uint8_t *in)
+{
+	return (uint64_t)getU32(in) | ((uint64_t)getU32(in + 4) << 32);
+}
+
+static inline uint64_t xxhRound(uint64_t accumulator, uint64_t input)
+{
+	accumulator += input * PRIME64_2;
+	accumulator = rotateLeft(accumulator, 31);
+	return accumulator * PRIME64_1;
+}
+
+static inline uint64_t xxhMergeRound(uint64_t accumulator, uint64_t value)
+{
+	accumulator ^= xxhRound(0, value);
+	return accumulator * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t hashBytes(const void *data, size_t length, uint64_t seed)
+{
+	const uint8_t *in = (const uint8_t *)data;
+	const uint8_t *end = in + length;
+	uint64_t hash;
+
+	if (length >= 32)
+	{
+		uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+		uint64_t v2 = seed + PRIME64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - PRIME64_1;
+
+		const uint8_t *lastStripe = end - 32;
+		do
+		{
+			v1 = xxhRound(v1, read64(in));
+			v2 = xxhRound(v2, read64(in + 8));
+			v3 = xxhRound(v3, read64(in + 16));
+			v4 = xxhRound(v4, read64(in + 24));
+			in += 32;
+		} while (in <= lastStripe);
+
+		hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+		hash = xxhMergeRound(hash, v1);
+		hash = xxhMergeRound(hash, v2);
+		hash = xxhMergeRound(hash, v3);
+		hash = xxhMergeRound(hash, v4);
+	}
+	else
+		hash = seed + PRIME64_5;
+
+	hash += (uint64_t)length;
+
+	for (; in + 8 <= end; in += 8)
+	{
+		hash ^= xxhRound(0, read64(in));
+		hash = rotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+	}
+	if (in + 4 <= end)
+	{
+		hash ^= (uint64_t)getU32(in) * PRIME64_1;
+		hash = rotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+		in += 4;
+	}
+	for (; in < end; in++)
+	{
+		hash ^= (*in) * PRIME64_5;
+		hash = rotateLeft(hash, 11) * PRIME64_1;
+	}
+
+	// avalanche
+	hash ^= hash >> 33;
+	hash *= PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+// end::xxh64[]
+
+// tag::canonicalState[]
+void canonicalState(const FixedMatchState &match, uint8_t out[CANONICAL_STATE_SIZE])
+{
+	putU32(out + 0, (uint32_t)match.paddle1X.raw);
+	putU32(out + 4, (uint32_t)match.paddle2X.raw);
+	putU32(out + 8, (uint32_t)match.paddle1Z.raw);
+	putU32(out + 12, (uint32_t)match.paddle2Z.raw);
+	putU32(out + 16, (uint32_t)match.ballX.raw);
+	putU32(out + 20, (uint32_t)match.ballZ.raw);
+	putU32(out + 24, (uint32_t)match.player1Score);
+	putU32(out + 28, (uint32_t)match.player2Score);
+	out[32] = (uint8_t)match.paddle1Direction;
+	out[33] = (uint8_t)match.paddle2Direction;
+	out[34] = (uint8_t)match.ballDirectionX;
+	out[35] = (uint8_t)match.ballDirectionZ;
+	out[36] = match.isColliding ? 1 : 0;
+	out[37] = out[38] = out[39] = 0;
+}
+
+void readCanonicalState(const uint8_t in[CANONICAL_STATE_SIZE], FixedMatchState &match)
+{
+	match.paddle1X = Fixed::fromRaw((int32_t)getU32(in + 0));
+	match.paddle2X = Fixed::fromRaw((int32_t)getU32(in + 4));
+	match.paddle1Z = Fixed::fromRaw((int32_t)getU32(in + 8));
+	match.paddle2Z = Fixed::fromRaw((int32_t)getU32(in + 12));
+	match.ballX = Fixed::fromRaw((int32_t)getU32(in + 16));
+	match.ballZ = Fixed::fromRaw((int32_t)getU32(in + 20));
+	match.player1Score = (int)getU32(in + 24);
+	match.player2Score = (int)getU32(in + 28);
+	match.paddle1Direction = (int8_t)in[32];
+	match.paddle2Direction = (int8_t)in[33];
+	match.ballDirectionX = (int8_t)in[34];
+	match.ballDirectionZ = (int8_t)in[35];
+	match.isColliding = in[36] != 0;
+}
+
+static inline void putCanonicalF32(uint8_t *out, float value)
+{
+	putF32(out, value == 0.0f ? 0.0f : value); // -0 == 0, so both hash the same
+}
+
+void canonicalState(const MatchState &match, uint8_t out[CANONICAL_STATE_SIZE])
+{
+	putCanonicalF32(out + 0, match.paddle1Position.x);
+	putCanonicalF32(out + 4, match.paddle2Position.x);
+	putCanonicalF32(out + 8, match.paddle1Position.z);
+	putCanonicalF32(out + 12, match.paddle2Position.z);
+	putCanonicalF32(out + 16, match.ballPosition.x);
+	putCanonicalF32(out + 20, match.ballPosition.z);
+	putU32(out + 24, (uint32_t)match.player1Score);
+	putU32(out + 28, (uint32_t)match.player2Score);
+	out[32] = (uint8_t)(int8_t)match.paddle1Direction;
+	out[33] = (uint8_t)(int8_t)match.paddle2Direction;
+	out[34] = (uint8_t)(int8_t)(match.ballDirection.x < 0 ? -1 : 1);
+	out[35] = (uint8_t)(int8_t)(match.ballDirection.z < 0 ? -1 : 1);
+	out[36] = match.isColliding ? 1 : 0;
+	out[37] = out[38] = out[39] = 0;
+}
+// end::canonicalState[]
+
+uint64_t hashMatchState(const FixedMatchState &match)
+{
+	uint8_t bytes[CANONICAL_STATE_SIZE];
+	canonicalState(match, bytes);
+	return hashBytes(bytes, sizeof(bytes));
+}
+
+uint64_t hashMatchState(const MatchState &match)
+{
+	uint8_t bytes[CANONICAL_STATE_SIZE];
+	canonicalState(match, bytes);
+	return hashBytes(bytes, sizeof(bytes));
+}
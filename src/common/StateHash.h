@@ -0,0 +1,33 @@
+#pragma once
+
+// Hashing the match state, to check that two simulations (two peers in lockstep, or a replay
+// and its re-simulation) are still in exactly the same place.
+//
+// The state is first written into a canonical little-endian byte layout, so the hash doesn't
+// depend on struct padding, endianness or compiler, then hashed with XXH64. The whole thing
+// is ~30ns (PongBench hash), cheap enough to run every tick in production.
+
+#include <cstdint>
+#include <cstddef>
+
+#include "Simulation.h"
+#include "FixedSimulation.h"
+
+const int CANONICAL_STATE_SIZE = 40;
+
+// XXH64 (https://github.com/Cyan4973/xxHash) of any bytes
+uint64_t hashBytes(const void *data, size_t length, uint64_t seed = 0);
+
+// tag::canonicalState[]
+// six positions, two scores, then the directions and collision flag a byte each
+void canonicalState(const FixedMatchState &match, uint8_t out[CANONICAL_STATE_SIZE]);
+
+// the inverse of the above, e.g. to load the starting state of a replay
+void readCanonicalState(const uint8_t in[CANONICAL_STATE_SIZE], FixedMatchState &match);
+
+// the same layout holding the bit patterns of the floats (with -0 written as 0)
+void canonicalState(const MatchState &match, uint8_t out[CANONICAL_STATE_SIZE]);
+// end::canonicalState[]
+
+uint64_t hashMatchState(const FixedMatchState &match);
+uint64_t hashMatchState(const MatchState &match);
@@ -0,0 +1,119 @@
+#include "VecEnv.h"
+
+#include <algorithm>
+
+// envs stepped together through all of a step's ticks
+const int STEP_CHUNK = 256;
+
+VecEnv::VecEnv(const VecEnvConfig &config)
+	: config(config), matches(config.envs), randoms(config.envs), steps(config.envs), opponentDirections(config.envs),
+	  finished(config.envs), pool(config.threads)
+{
+	opponent = config.opponent;
+	if (!opponent)
+	{
+		std::string error;
+		defaultOpponent = createController("predictive", error);
+		opponent = defaultOpponent.get();
+	}
+}
+
+// tag::startEpisode[]
+void VecEnv::startEpisode(int i)
+{
+	randomiseStart(matches[i], randoms[i]);
+	steps[i] = 0;
+}
+// end::startEpisode[]
+
+void VecEnv::reset(const uint64_t *seeds, float *observations)
+{
+	pool.parallelFor(size(), [&](int, int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			randoms[i] = Random(seeds[i]);
+			startEpisode(i);
+			observe(i, observations + (size_t)i * OBSERVATION_SIZE);
+		}
+	});
+}
+
+// tag::observe[]
+void VecEnv::observe(int i, float *out) const
+{
+	const FixedMatchState &match = matches[i];
+	bool agentIsPlayer1 = config.agentPlayer == 1;
+
+	// player 2 sees the arena turned round, so both agents see themselves at +z moving the same way
+	float flip = agentIsPlayer1 ? 1.0f : -1.0f;
+	out[0] = flip * (agentIsPlayer1 ? match.paddle1X : match.paddle2X).toFloat();
+	out[1] = flip * (agentIsPlayer1 ? match.paddle2X : match.paddle1X).toFloat();
+	out[2] = flip * match.ballX.toFloat();
+	out[3] = flip * match.ballZ.toFloat();
+	out[4] = flip * match.ballDirectionX;
+	out[5] = flip * match.ballDirectionZ;
+	out[6] = (float)(agentIsPlayer1 ? match.player1Score - match.player2Score : match.player2Score - match.player1Score);
+	out[7] = steps[i] / (float)config.maxEpisodeSteps;
+}
+// end::observe[]
+
+// tag::step[]
+void VecEnv::step(const int32_t *actions, float *observations, float *rewards, uint8_t *dones)
+{
+	int opponentPlayer = config.agentPlayer == 1 ? 2 : 1;
+
+	pool.parallelFor(size(), [&](int, int shareBegin, int shareEnd) {
+		// a chunk at a time, small enough to stay in cache for all its ticks but big enough that
+		// the opponent's one call per tick covers many envs
+		for (int begin = shareBegin; begin < shareEnd; begin += STEP_CHUNK)
+		{
+			int end = std::min(begin + STEP_CHUNK, shareEnd);
+			for (int i = begin; i < end; i++)
+			{
+				rewards[i] = 0;
+				finished[i] = 0;
+			}
+
+			for (int tick = 0; tick < config.ticksPerStep; tick++)
+			{
+				opponent->decide(&matches[begin], end - begin, opponentPlayer, &randoms[begin], &opponentDirections[begin]);
+
+				for (int i = begin; i < end; i++)
+				{
+					if (finished[i])
+						continue;
+
+					int direction = actions[i] - 1;
+					if (direction < -1 || direction > 1)
+						direction = 0;
+					if (config.agentPlayer == 2)
+						direction = -direction; // undo the turned-round view
+
+					FixedMatchState &match = matches[i];
+					match.paddle1Direction = config.agentPlayer == 1 ? direction : opponentDirections[i];
+					match.paddle2Direction = config.agentPlayer == 1 ? opponentDirections[i] : direction;
+
+					int scorer = stepMatchFixed(match);
+					if (scorer != 0)
+					{
+						rewards[i] += scorer == config.agentPlayer ? 1.0f : -1.0f;
+						if (match.player1Score + match.player2Score >= config.pointsPerEpisode)
+							finished[i] = 1;
+					}
+				}
+			}
+
+			for (int i = begin; i < end; i++)
+			{
+				steps[i]++;
+				bool done = finished[i] || steps[i] >= config.maxEpisodeSteps;
+				if (done)
+					startEpisode(i);
+
+				dones[i] = done ? 1 : 0;
+				observe(i, observations + (size_t)i * OBSERVATION_SIZE);
+			}
+		}
+	});
+}
+// end::step[]
@@ -0,0 +1,82 @@
+#pragma once
+
+// A vectorised reinforcement learning environment: N matches of the fixed point rules stepped
+// together, for training agents against the game.
+//
+// Every call works on all N environments at once and reads and writes the caller's arrays
+// directly (e.g. numpy buffers), laid out environment after environment, so nothing is copied
+// or allocated per step. The matches live in one contiguous array and are split across a
+// WorkerPool. Because the rules are fixed point and every environment has its own seeded
+// random stream, the same seeds and actions give the same results whatever the thread count.
+//
+// An environment that finishes an episode resets itself within the same step: done[i] is set
+// and observations[i] already holds the first observation of the next episode.
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include "FixedSimulation.h"
+#include "Random.h"
+#include "WorkerPool.h"
+#include "Controller.h"
+
+// tag::VecEnvConfig[]
+struct VecEnvConfig
+{
+	int envs = 1024;
+	int threads = 0;             // 0 for one per core
+	int agentPlayer = 1;         // the paddle the actions move; the opponent has the other one
+	const Controller *opponent = nullptr; // any Controller, e.g. a plugin; null for predictive
+	int ticksPerStep = 4;        // each action is repeated for this many FIXED_TICKs
+	int pointsPerEpisode = 5;    // an episode ends after this many points...
+	int maxEpisodeSteps = 4096;  // ...or this many steps
+};
+// end::VecEnvConfig[]
+
+// tag::VecEnv[]
+class VecEnv
+{
+public:
+	// own paddle x, opponent paddle x, ball x, ball z, ball direction x, ball direction z,
+	// own score - opponent score, fraction of maxEpisodeSteps used. Positions are in metres,
+	// seen from the agent's end (its paddle at +z), whichever player it is
+	static const int OBSERVATION_SIZE = 8;
+
+	// actions are 0 left, 1 stay, 2 right
+	static const int ACTION_COUNT = 3;
+
+	explicit VecEnv(const VecEnvConfig &config);
+
+	int size() const { return (int)matches.size(); }
+	const VecEnvConfig &getConfig() const { return config; }
+
+	// start a new episode in every environment, seeding environment i from seeds[i];
+	// writes size() * OBSERVATION_SIZE floats
+	void reset(const uint64_t *seeds, float *observations);
+
+	// apply actions[i] to environment i for ticksPerStep ticks; writes size() * OBSERVATION_SIZE
+	// observations, size() rewards (+1 for each point won, -1 for each lost) and size() dones
+	void step(const int32_t *actions, float *observations, float *rewards, uint8_t *dones);
+
+	// the match behind environment i, e.g. to draw it
+	const FixedMatchState &match(int i) const { return matches[i]; }
+
+private:
+	void startEpisode(int i);
+	void observe(int i, float *out) const;
+
+	VecEnvConfig config;
+	std::unique_ptr<Controller> defaultOpponent;
+	const Controller *opponent;
+
+	// one entry per environment; the matches are an array of their own so the opponent can
+	// decide for a whole worker's share of them in one call
+	std::vector<FixedMatchState> matches;
+	std::vector<Random> randoms;
+	std::vector<int> steps;
+	std::vector<int> opponentDirections;
+	std::vector<uint8_t> finished; // the episode ended part way through this step
+	WorkerPool pool;
+};
+// end::VecEnv[]
@@ -0,0 +1,78 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(int threadCount)
+{
+	workerCount = threadCount > 0 ? threadCount : (int)std::max(1u, std::thread::hardware_concurrency());
+	for (int worker = 1; worker < workerCount; worker++)
+		threads.push_back(std::thread(&WorkerPool::workerLoop, this, worker));
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	startBatch.notify_all();
+	for (std::thread &thread : threads)
+		thread.join();
+}
+
+// tag::parallelFor[]
+void WorkerPool::runShare(int worker)
+{
+	int begin = (int)((long long)currentCount * worker / workerCount);
+	int end = (int)((long long)currentCount * (worker + 1) / workerCount);
+	if (begin < end)
+		(*currentTask)(worker, begin, end);
+}
+
+void WorkerPool::parallelFor(int count, const std::function<void(int worker, int begin, int end)> &task)
+{
+	if (workerCount == 1 || count <= 1)
+	{
+		if (count > 0)
+			task(0, 0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentTask = &task;
+		currentCount = count;
+		unfinished = workerCount - 1;
+		batch++;
+	}
+	startBatch.notify_all();
+
+	// the calling thread does the first share rather than sitting idle
+	runShare(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	batchDone.wait(lock, [this] { return unfinished == 0; });
+	currentTask = nullptr;
+}
+
+void WorkerPool::workerLoop(int worker)
+{
+	unsigned seenBatch = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startBatch.wait(lock, [&] { return stopping || batch != seenBatch; });
+			if (stopping)
+				return;
+			seenBatch = batch;
+		}
+
+		runShare(worker);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--unfinished == 0)
+			batchDone.notify_one();
+	}
+}
+// end::parallelFor[]
@@ -0,0 +1,43 @@
+#pragma once
+
+// A fixed set of threads for splitting a batch of independent work (environments, matches,
+// rollouts) across cores. The threads are started once and wait between batches, so handing
+// out a batch costs a wake-up rather than a thread start.
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+// tag::WorkerPool[]
+class WorkerPool
+{
+public:
+	// threads == 0 means one per core; the calling thread counts as one of them
+	explicit WorkerPool(int threads = 0);
+	~WorkerPool();
+
+	int size() const { return workerCount; }
+
+	// calls task(worker, begin, end) once per worker with contiguous, roughly equal ranges
+	// covering [0, count), and returns when all of them have finished
+	void parallelFor(int count, const std::function<void(int worker, int begin, int end)> &task);
+
+private:
+	void workerLoop(int worker);
+	void runShare(int worker);
+
+	int workerCount;
+	std::vector<std::thread> threads;
+
+	std::mutex mutex;
+	std::condition_variable startBatch;
+	std::condition_variable batchDone;
+	const std::function<void(int, int, int)> *currentTask = nullptr;
+	int currentCount = 0;
+	unsigned batch = 0;     // bumped for every parallelFor, so workers know there's new work
+	int unfinished = 0;     // workers still running the current batch
+	bool stopping = false;
+};
+// end::WorkerPool[]